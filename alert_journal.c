@@ -0,0 +1,606 @@
+/*
+ * Alert Journal - Implementación del diario de alertas
+ *
+ * Cada alerta que entra en el AlertManager se añade antes a un diario de
+ * sólo-añadir repartido en segmentos (alerts-000001.journal, ...). Tras una
+ * cabecera fija, cada registro es:
+ *
+ *   uint32 longitud | uint32 suma | int64 instante | uint16 puerto |
+ *   uint8 nivel | uint8 banderas | uint16 longitudes[4] |
+ *   [uint32 detecciones | int64 primera] | mensaje servicio host origen
+ *
+ * Un registro normal es una detección. Uno agregado (bandera RECORD_AGGREGATE)
+ * resume todas las detecciones de una alerta distinta: lo escribe la
+ * compactación, que vuelca el estado del AlertManager al principio de un
+ * segmento nuevo marcado como instantánea y borra los anteriores. Como en
+ * modo continuo las mismas alertas se repiten cada ciclo, sin compactar el
+ * diario crecería con el tiempo en marcha; así ocupa la instantánea más lo
+ * detectado desde ella, y al reiniciar se lee lo mismo.
+ *
+ * Las alertas se acumulan en un búfer y se escriben de una vez al llenarse;
+ * fdatasync se hace por grupos (cada ALERT_JOURNAL_GROUP alertas o cuando el
+ * llamador pide alert_journal_sync(), p. ej. al final de cada ciclo), así que
+ * un fallo pierde como mucho el último grupo. Al superar
+ * ALERT_JOURNAL_SEGMENT_SIZE se sincroniza el segmento y se compacta o, si
+ * no hay quien escriba la instantánea, se abre el siguiente.
+ *
+ * La instantánea se escribe en un archivo .tmp que sólo se renombra como
+ * segmento tras su fdatasync; los lectores empiezan en el último segmento
+ * marcado como instantánea, así que un corte antes de borrar los anteriores
+ * no duplica nada.
+ *
+ * Cada registro lleva una suma FNV-1a. Un corte a mitad de escritura deja un
+ * registro incompleto al final del último segmento: los lectores se detienen
+ * ahí y la siguiente apertura en escritura lo descarta. Los lectores mapean
+ * los segmentos con mmap y no necesitan el proceso que escribe: un cursor
+ * permite recorrer el diario entero o seguirlo mientras crece. El formato usa
+ * el orden de bytes de la máquina.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "alert_journal.h"
+
+#define RECORD_HEADER_SIZE 8
+#define RECORD_FIXED_SIZE 20
+#define RECORD_AGGREGATE_SIZE 12    // Detecciones y primera detección
+#define RECORD_AGGREGATE 0x01
+#define RECORD_STRINGS 4
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+// Segmento mapeado en memoria (sólo lectura)
+typedef struct {
+    int fd;
+    const uint8_t *data;
+    size_t size;
+} JournalMap;
+
+static uint32_t record_checksum(const uint8_t *payload, uint32_t length) {
+    uint64_t hash = FNV_OFFSET;
+    for (uint32_t i = 0; i < length; i++) {
+        hash ^= payload[i];
+        hash *= FNV_PRIME;
+    }
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+int alert_journal_segment_path(const char *directory, unsigned segment, char *buffer, size_t size) {
+    int written = snprintf(buffer, size, "%s/alerts-%06u.journal", directory, segment);
+    return written > 0 && (size_t)written < size ? 0 : -1;
+}
+
+// Primer y último segmento del directorio (0 y 0 si no hay ninguno)
+static int find_segments(const char *directory, unsigned *first, unsigned *last) {
+    DIR *dir = opendir(directory);
+    if (!dir) return -1;
+
+    *first = 0;
+    *last = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        unsigned segment;
+        int length = 0;
+        if (sscanf(entry->d_name, "alerts-%u.journal%n", &segment, &length) != 1 ||
+            entry->d_name[length] != '\0' || segment == 0) {
+            continue;
+        }
+        if (*first == 0 || segment < *first) *first = segment;
+        if (segment > *last) *last = segment;
+    }
+    closedir(dir);
+    return 0;
+}
+
+// Banderas de la cabecera del segmento (-1 si no se puede leer o no es válida)
+static int segment_flags(const char *directory, unsigned segment) {
+    char path[ALERT_JOURNAL_PATH_SIZE];
+    uint8_t header[ALERT_JOURNAL_HEADER_SIZE];
+    if (alert_journal_segment_path(directory, segment, path, sizeof(path)) != 0) return -1;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return -1;
+    ssize_t length = pread(fd, header, sizeof(header), 0);
+    close(fd);
+    if (length != (ssize_t)sizeof(header) ||
+        memcmp(header, ALERT_JOURNAL_MAGIC, strlen(ALERT_JOURNAL_MAGIC)) != 0) {
+        return -1;
+    }
+    uint32_t flags;
+    memcpy(&flags, header + 12, 4);
+    return (int)flags;
+}
+
+// Último segmento que empieza con una instantánea (0 si no hay ninguno)
+static unsigned latest_snapshot(const char *directory, unsigned first, unsigned last) {
+    for (unsigned segment = last; segment >= first && segment > 0; segment--) {
+        int flags = segment_flags(directory, segment);
+        if (flags >= 0 && (flags & ALERT_JOURNAL_SNAPSHOT)) return segment;
+    }
+    return 0;
+}
+
+// Borra los segmentos anteriores a 'keep' y las instantáneas a medio escribir
+static void remove_segments_before(const char *directory, unsigned keep) {
+    DIR *dir = opendir(directory);
+    if (!dir) return;
+
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        unsigned segment;
+        int length = 0;
+        if (sscanf(entry->d_name, "alerts-%u.journal%n", &segment, &length) != 1) continue;
+        int temporary = strcmp(entry->d_name + length, ".tmp") == 0;
+        if ((entry->d_name[length] != '\0' && !temporary) || (segment >= keep && !temporary)) continue;
+
+        char path[ALERT_JOURNAL_PATH_SIZE];
+        if (snprintf(path, sizeof(path), "%s/%s", directory, entry->d_name) < (int)sizeof(path)) {
+            unlink(path);
+        }
+    }
+    closedir(dir);
+}
+
+static int map_segment(const char *path, JournalMap *map) {
+    struct stat info;
+    map->data = NULL;
+    map->size = 0;
+    map->fd = open(path, O_RDONLY);
+    if (map->fd < 0) return -1;
+    if (fstat(map->fd, &info) != 0) {
+        close(map->fd);
+        map->fd = -1;
+        return -1;
+    }
+    map->size = (size_t)info.st_size;
+    if (map->size > 0) {
+        void *data = mmap(NULL, map->size, PROT_READ, MAP_SHARED, map->fd, 0);
+        if (data == MAP_FAILED) {
+            close(map->fd);
+            map->fd = -1;
+            return -1;
+        }
+        map->data = (const uint8_t*)data;
+    }
+    return 0;
+}
+
+static void unmap_segment(JournalMap *map) {
+    if (map->data) munmap((void*)map->data, map->size);
+    if (map->fd >= 0) close(map->fd);
+    map->data = NULL;
+    map->fd = -1;
+}
+
+static int valid_header(const JournalMap *map) {
+    return map->size >= ALERT_JOURNAL_HEADER_SIZE &&
+           memcmp(map->data, ALERT_JOURNAL_MAGIC, strlen(ALERT_JOURNAL_MAGIC)) == 0;
+}
+
+// Decodifica el registro en 'offset'; las cadenas se copian con su terminador a 'text'.
+// Devuelve la posición del siguiente registro o 0 si no hay uno completo y válido
+static size_t decode_record(const JournalMap *map, size_t offset, Alert *alert, uint32_t *count,
+                            time_t *first_seen, char *text) {
+    if (offset + RECORD_HEADER_SIZE + RECORD_FIXED_SIZE > map->size) return 0;
+    uint32_t length;
+    uint32_t checksum;
+    memcpy(&length, map->data + offset, 4);
+    memcpy(&checksum, map->data + offset + 4, 4);
+    if (length < RECORD_FIXED_SIZE || length > map->size - offset - RECORD_HEADER_SIZE) return 0;
+
+    const uint8_t *payload = map->data + offset + RECORD_HEADER_SIZE;
+    if (record_checksum(payload, length) != checksum) return 0;
+
+    int64_t timestamp;
+    uint16_t port;
+    uint16_t lengths[RECORD_STRINGS];
+    memcpy(&timestamp, payload, 8);
+    memcpy(&port, payload + 8, 2);
+    memcpy(lengths, payload + 12, sizeof(lengths));
+
+    size_t position = RECORD_FIXED_SIZE;
+    *count = 1;
+    *first_seen = (time_t)timestamp;
+    if (payload[11] & RECORD_AGGREGATE) {
+        int64_t first;
+        if (length < RECORD_FIXED_SIZE + RECORD_AGGREGATE_SIZE) return 0;
+        memcpy(count, payload + position, 4);
+        memcpy(&first, payload + position + 4, 8);
+        *first_seen = (time_t)first;
+        position += RECORD_AGGREGATE_SIZE;
+    }
+
+    const char *strings[RECORD_STRINGS];
+    for (int i = 0; i < RECORD_STRINGS; i++) {
+        if (lengths[i] > length - position) return 0;
+        memcpy(text, payload + position, lengths[i]);
+        text[lengths[i]] = '\0';
+        strings[i] = text;
+        text += lengths[i] + 1;
+        position += lengths[i];
+    }
+    if (position != length || payload[10] > ALERT_HIGH) return 0;
+
+    alert->level = (AlertLevel)payload[10];
+    alert->message = strings[0];
+    alert->port = port;
+    alert->service = strings[1];
+    alert->host = strings[2];
+    alert->source = strings[3];
+    alert->timestamp = (time_t)timestamp;
+    return offset + RECORD_HEADER_SIZE + length;
+}
+
+// Recorre las alertas desde 'cursor' hasta el final actual del diario y avanza el cursor.
+// Sirve tanto para reconstruir (cursor a cero) como para seguir el diario mientras crece:
+// un registro a medio escribir se deja para la siguiente llamada. Devuelve cuántas leyó
+int alert_journal_read(const char *directory, AlertJournalCursor *cursor, AlertJournalVisitor visitor,
+                       void *user_data) {
+    if (!directory || !cursor || !visitor) return -1;
+
+    unsigned first;
+    unsigned last;
+    if (find_segments(directory, &first, &last) != 0) return -1;
+    if (last == 0) return 0;
+
+    // Lo anterior a la última instantánea ya está resumido en ella
+    unsigned snapshot = latest_snapshot(directory, first, last);
+    if (snapshot > first) first = snapshot;
+    if (cursor->segment < first) {
+        cursor->segment = first;
+        cursor->offset = 0;
+    }
+
+    // Cada cadena cabe en 65535 bytes más su terminador
+    char *text = malloc(RECORD_STRINGS * 65536);
+    if (!text) return -1;
+
+    int count = 0;
+    while (cursor->segment <= last) {
+        char path[ALERT_JOURNAL_PATH_SIZE];
+        JournalMap map;
+        if (alert_journal_segment_path(directory, cursor->segment, path, sizeof(path)) == 0 &&
+            map_segment(path, &map) == 0) {
+            // Un segmento sin cabecera completa se está creando o está dañado
+            if (valid_header(&map)) {
+                size_t offset = cursor->offset < ALERT_JOURNAL_HEADER_SIZE ?
+                                ALERT_JOURNAL_HEADER_SIZE : (size_t)cursor->offset;
+                Alert alert;
+                uint32_t repeats;
+                time_t first_seen;
+                size_t next;
+                while ((next = decode_record(&map, offset, &alert, &repeats, &first_seen, text)) != 0) {
+                    visitor(&alert, repeats, first_seen, user_data);
+                    count++;
+                    offset = next;
+                }
+                cursor->offset = offset;
+            }
+            unmap_segment(&map);
+        }
+
+        // El último se sigue leyendo en la próxima llamada; los anteriores están cerrados
+        if (cursor->segment == last) break;
+        cursor->segment++;
+        cursor->offset = 0;
+    }
+    free(text);
+    return count;
+}
+
+// Final del último registro válido del segmento (0 si la cabecera no lo es)
+static size_t segment_valid_end(const char *path) {
+    JournalMap map;
+    if (map_segment(path, &map) != 0) return 0;
+
+    size_t end = 0;
+    if (valid_header(&map)) {
+        char *text = malloc(RECORD_STRINGS * 65536);
+        end = ALERT_JOURNAL_HEADER_SIZE;
+        Alert alert;
+        uint32_t count;
+        time_t first_seen;
+        size_t next;
+        while (text && (next = decode_record(&map, end, &alert, &count, &first_seen, text)) != 0) {
+            end = next;
+        }
+        free(text);
+    }
+    unmap_segment(&map);
+    return end;
+}
+
+static int sync_directory(const char *directory) {
+    int fd = open(directory, O_RDONLY | O_DIRECTORY);
+    if (fd < 0) return -1;
+    int status = fsync(fd);
+    close(fd);
+    return status;
+}
+
+// Crea 'path' vacío con la cabecera del segmento; devuelve el descriptor para añadir
+static int create_segment(const char *path, unsigned segment, uint32_t flags) {
+    int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_APPEND, 0644);
+    if (fd < 0) return -1;
+
+    uint8_t header[ALERT_JOURNAL_HEADER_SIZE];
+    int64_t created = (int64_t)time(NULL);
+    memset(header, 0, sizeof(header));
+    memcpy(header, ALERT_JOURNAL_MAGIC, strlen(ALERT_JOURNAL_MAGIC));
+    memcpy(header + 8, &segment, 4);
+    memcpy(header + 12, &flags, 4);
+    memcpy(header + 16, &created, 8);
+    if (write(fd, header, sizeof(header)) != (ssize_t)sizeof(header) || fdatasync(fd) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Crea (o rehace, si quedó sin cabecera) el segmento y lo deja listo para añadir
+static int open_segment(AlertJournal *journal, unsigned segment) {
+    char path[ALERT_JOURNAL_PATH_SIZE];
+    if (alert_journal_segment_path(journal->directory, segment, path, sizeof(path)) != 0) return -1;
+
+    int fd = create_segment(path, segment, 0);
+    if (fd < 0) return -1;
+    sync_directory(journal->directory);
+
+    journal->fd = fd;
+    journal->segment = segment;
+    journal->segment_bytes = ALERT_JOURNAL_HEADER_SIZE;
+    journal->snapshot_bytes = ALERT_JOURNAL_HEADER_SIZE;
+    return 0;
+}
+
+AlertJournal* alert_journal_open(const char *directory) {
+    if (!directory || !*directory) return NULL;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) return NULL;
+
+    AlertJournal *journal = malloc(sizeof(AlertJournal));
+    if (!journal) return NULL;
+    journal->directory = strdup(directory);
+    journal->buffer = malloc(ALERT_JOURNAL_BUFFER_SIZE);
+    journal->fd = -1;
+    journal->buffered = 0;
+    journal->unsynced = 0;
+    journal->records = 0;
+    journal->bytes = 0;
+    journal->syncs = 0;
+    journal->errors = 0;
+    journal->compactions = 0;
+    journal->snapshot = NULL;
+    journal->snapshot_data = NULL;
+    journal->compacting = 0;
+
+    unsigned first;
+    unsigned last;
+    if (!journal->directory || !journal->buffer || find_segments(directory, &first, &last) != 0) {
+        alert_journal_close(journal);
+        return NULL;
+    }
+    // Restos de una compactación cortada antes de borrar lo que ya resumía
+    if (last > 0) {
+        remove_segments_before(directory, latest_snapshot(directory, first, last));
+    }
+
+    // Continuar el último segmento descartando un registro incompleto que dejara un corte
+    char path[ALERT_JOURNAL_PATH_SIZE];
+    size_t end = 0;
+    if (last > 0 && alert_journal_segment_path(directory, last, path, sizeof(path)) == 0) {
+        end = segment_valid_end(path);
+    }
+    if (end > 0) {
+        journal->fd = open(path, O_WRONLY | O_APPEND);
+        if (journal->fd < 0 || ftruncate(journal->fd, (off_t)end) != 0) {
+            alert_journal_close(journal);
+            return NULL;
+        }
+        journal->segment = last;
+        journal->segment_bytes = end;
+        journal->snapshot_bytes = ALERT_JOURNAL_HEADER_SIZE;
+    } else if (open_segment(journal, last > 0 ? last : 1) != 0) {
+        alert_journal_close(journal);
+        return NULL;
+    }
+    return journal;
+}
+
+// Escribe el búfer; si falla, deja el segmento como estaba para no cortar un registro
+static int flush_buffer(AlertJournal *journal) {
+    if (journal->buffered == 0) return 0;
+
+    uint64_t good = journal->segment_bytes - journal->buffered;
+    size_t written = 0;
+    while (written < journal->buffered) {
+        ssize_t result = write(journal->fd, journal->buffer + written, journal->buffered - written);
+        if (result < 0 && errno == EINTR) continue;
+        if (result <= 0) {
+            // Si no se puede recortar, la cola dañada se descarta al reabrir
+            int truncated = ftruncate(journal->fd, (off_t)good);
+            (void)truncated;
+            journal->segment_bytes = good;
+            journal->buffered = 0;
+            journal->errors++;
+            return -1;
+        }
+        written += (size_t)result;
+    }
+    journal->buffered = 0;
+    return 0;
+}
+
+// Lleva a disco lo añadido hasta ahora (escritura del búfer y un único fdatasync)
+int alert_journal_sync(AlertJournal *journal) {
+    if (!journal || journal->fd < 0) return -1;
+    if (flush_buffer(journal) != 0) return -1;
+    if (journal->unsynced == 0) return 0;
+
+    if (fdatasync(journal->fd) != 0) {
+        journal->errors++;
+        return -1;
+    }
+    journal->unsynced = 0;
+    journal->syncs++;
+    return 0;
+}
+
+static int append_record(AlertJournal *journal, const Alert *alert, int aggregate,
+                         uint32_t count, time_t first_seen) {
+    if (!journal || !alert || journal->fd < 0) return -1;
+
+    const char *strings[RECORD_STRINGS] = { alert->message, alert->service, alert->host, alert->source };
+    uint16_t lengths[RECORD_STRINGS];
+    size_t length = RECORD_FIXED_SIZE + (aggregate ? RECORD_AGGREGATE_SIZE : 0);
+    for (int i = 0; i < RECORD_STRINGS; i++) {
+        if (!strings[i]) strings[i] = "";
+        size_t string_length = strlen(strings[i]);
+        lengths[i] = (uint16_t)(string_length > 65535 ? 65535 : string_length);
+        length += lengths[i];
+    }
+    size_t total = RECORD_HEADER_SIZE + length;
+    if (total > ALERT_JOURNAL_BUFFER_SIZE) {
+        journal->errors++;
+        return -1;
+    }
+
+    // Segmento lleno: compactar si desde la última instantánea se ha escrito bastante;
+    // si no, cerrarlo sincronizado y seguir en el siguiente. La instantánea no se parte
+    if (!journal->compacting && journal->segment_bytes + total > ALERT_JOURNAL_SEGMENT_SIZE &&
+        journal->segment_bytes > ALERT_JOURNAL_HEADER_SIZE) {
+        if (journal->snapshot &&
+            journal->segment_bytes - journal->snapshot_bytes >= ALERT_JOURNAL_SEGMENT_SIZE / 2 &&
+            alert_journal_compact(journal) == 0) {
+            return append_record(journal, alert, aggregate, count, first_seen);
+        }
+        if (alert_journal_sync(journal) != 0) return -1;
+        close(journal->fd);
+        journal->fd = -1;
+        if (open_segment(journal, journal->segment + 1) != 0) {
+            journal->errors++;
+            return -1;
+        }
+    }
+    if (journal->buffered + total > ALERT_JOURNAL_BUFFER_SIZE && flush_buffer(journal) != 0) {
+        return -1;
+    }
+
+    uint8_t *record = journal->buffer + journal->buffered;
+    uint8_t *payload = record + RECORD_HEADER_SIZE;
+    int64_t timestamp = (int64_t)alert->timestamp;
+    uint16_t port = (uint16_t)alert->port;
+    memcpy(payload, &timestamp, 8);
+    memcpy(payload + 8, &port, 2);
+    payload[10] = (uint8_t)alert->level;
+    payload[11] = aggregate ? RECORD_AGGREGATE : 0;
+    memcpy(payload + 12, lengths, sizeof(lengths));
+    size_t position = RECORD_FIXED_SIZE;
+    if (aggregate) {
+        int64_t first = (int64_t)first_seen;
+        memcpy(payload + position, &count, 4);
+        memcpy(payload + position + 4, &first, 8);
+        position += RECORD_AGGREGATE_SIZE;
+    }
+    for (int i = 0; i < RECORD_STRINGS; i++) {
+        memcpy(payload + position, strings[i], lengths[i]);
+        position += lengths[i];
+    }
+    uint32_t stored_length = (uint32_t)length;
+    uint32_t checksum = record_checksum(payload, stored_length);
+    memcpy(record, &stored_length, 4);
+    memcpy(record + 4, &checksum, 4);
+
+    journal->buffered += total;
+    journal->segment_bytes += total;
+    if (!journal->compacting) {
+        journal->records++;
+        journal->bytes += total;
+    }
+    journal->unsynced++;
+
+    // fdatasync por grupos: una alerta aislada espera al siguiente alert_journal_sync()
+    if (journal->unsynced >= ALERT_JOURNAL_GROUP) {
+        return alert_journal_sync(journal);
+    }
+    return 0;
+}
+
+int alert_journal_append(AlertJournal *journal, const Alert *alert) {
+    return append_record(journal, alert, 0, 1, alert ? alert->timestamp : 0);
+}
+
+int alert_journal_append_aggregate(AlertJournal *journal, const Alert *alert, uint32_t count,
+                                   time_t first_seen) {
+    return append_record(journal, alert, 1, count, first_seen);
+}
+
+// Vuelca el estado agregado a un segmento nuevo y borra los anteriores.
+// Si algo falla se sigue escribiendo en el segmento de antes, que no se ha tocado
+int alert_journal_compact(AlertJournal *journal) {
+    if (!journal || journal->fd < 0 || !journal->snapshot || journal->compacting) return -1;
+    if (alert_journal_sync(journal) != 0) return -1;
+
+    unsigned segment = journal->segment + 1;
+    char path[ALERT_JOURNAL_PATH_SIZE];
+    char temporary[ALERT_JOURNAL_PATH_SIZE];
+    if (alert_journal_segment_path(journal->directory, segment, path, sizeof(path)) != 0 ||
+        snprintf(temporary, sizeof(temporary), "%s.tmp", path) >= (int)sizeof(temporary)) {
+        return -1;
+    }
+    int fd = create_segment(temporary, segment, ALERT_JOURNAL_SNAPSHOT);
+    if (fd < 0) {
+        journal->errors++;
+        return -1;
+    }
+
+    int previous_fd = journal->fd;
+    unsigned previous_segment = journal->segment;
+    uint64_t previous_bytes = journal->segment_bytes;
+    unsigned long long previous_errors = journal->errors;
+
+    journal->fd = fd;
+    journal->segment = segment;
+    journal->segment_bytes = ALERT_JOURNAL_HEADER_SIZE;
+    journal->compacting = 1;
+    journal->snapshot(journal, journal->snapshot_data);
+    journal->compacting = 0;
+
+    if (journal->errors != previous_errors || alert_journal_sync(journal) != 0 ||
+        rename(temporary, path) != 0) {
+        close(fd);
+        unlink(temporary);
+        journal->fd = previous_fd;
+        journal->segment = previous_segment;
+        journal->segment_bytes = previous_bytes;
+        journal->buffered = 0;
+        journal->unsynced = 0;
+        journal->errors++;
+        return -1;
+    }
+    sync_directory(journal->directory);
+    close(previous_fd);
+    remove_segments_before(journal->directory, segment);
+
+    journal->snapshot_bytes = journal->segment_bytes;
+    journal->compactions++;
+    return 0;
+}
+
+void alert_journal_close(AlertJournal *journal) {
+    if (!journal) return;
+
+    if (journal->fd >= 0) {
+        alert_journal_sync(journal);
+        close(journal->fd);
+    }
+    free(journal->buffer);
+    free(journal->directory);
+    free(journal);
+}
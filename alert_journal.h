@@ -0,0 +1,67 @@
+/*
+ * Alert Journal - Diario persistente de alertas por segmentos (--journal)
+ */
+
+#ifndef ALERT_JOURNAL_H
+#define ALERT_JOURNAL_H
+
+#include <stdint.h>
+#include <time.h>
+#include "alert_manager.h"
+
+#define ALERT_JOURNAL_MAGIC "MGJRNL01"
+#define ALERT_JOURNAL_HEADER_SIZE 64
+#define ALERT_JOURNAL_SEGMENT_SIZE (8 * 1024 * 1024)   // Se abre un segmento nuevo al superarlo
+#define ALERT_JOURNAL_BUFFER_SIZE 65536                // Escrituras agrupadas
+#define ALERT_JOURNAL_GROUP 256                        // Alertas como máximo entre dos fdatasync
+#define ALERT_JOURNAL_PATH_SIZE 4096
+#define ALERT_JOURNAL_SNAPSHOT 1                       // Bandera de cabecera: el segmento sustituye a los anteriores
+
+// Posición de lectura: segmento y desplazamiento dentro de él ({0, 0} = desde el principio)
+typedef struct {
+    unsigned segment;
+    uint64_t offset;
+} AlertJournalCursor;
+
+// count detecciones de la alerta entre first_seen y alert->timestamp (1 en un registro normal)
+typedef void (*AlertJournalVisitor)(const Alert *alert, uint32_t count, time_t first_seen, void *user_data);
+
+struct AlertJournal;
+
+// Escribe con alert_journal_append_aggregate() el estado agregado que sustituye al diario
+typedef void (*AlertJournalSnapshot)(struct AlertJournal *journal, void *user_data);
+
+typedef struct AlertJournal {
+    char *directory;
+    int fd;                     // Segmento en escritura
+    unsigned segment;
+    uint64_t segment_bytes;     // Tamaño del segmento, incluido lo pendiente en el búfer
+    uint64_t snapshot_bytes;    // Parte del segmento ocupada por su instantánea (o la cabecera)
+    uint8_t *buffer;
+    size_t buffered;
+    int unsynced;               // Alertas escritas o en el búfer desde el último fdatasync
+    unsigned long long records; // Alertas añadidas en esta ejecución
+    unsigned long long bytes;
+    unsigned long long syncs;
+    unsigned long long errors;  // Alertas o escrituras que no llegaron al diario
+    unsigned long long compactions;
+    AlertJournalSnapshot snapshot;  // Compacta el diario al llenarse un segmento (NULL = sólo rotar)
+    void *snapshot_data;
+    int compacting;
+} AlertJournal;
+
+// Funciones públicas
+AlertJournal* alert_journal_open(const char *directory);
+void alert_journal_close(AlertJournal *journal);
+int alert_journal_append(AlertJournal *journal, const Alert *alert);
+int alert_journal_append_aggregate(AlertJournal *journal, const Alert *alert, uint32_t count,
+                                   time_t first_seen);
+int alert_journal_compact(AlertJournal *journal);
+int alert_journal_sync(AlertJournal *journal);
+int alert_journal_read(const char *directory, AlertJournalCursor *cursor, AlertJournalVisitor visitor,
+                       void *user_data);
+
+// Funciones auxiliares
+int alert_journal_segment_path(const char *directory, unsigned segment, char *buffer, size_t size);
+
+#endif
@@ -1,12 +1,56 @@
 /*
  * Alert Manager - Implementación del gestor de alertas
+ *
+ * Cada alerta es un AlertRecord de tamaño fijo con su mensaje a continuación,
+ * ambos asignados en un arena por bloques (arena.c): añadir no llama a malloc
+ * salvo al abrir un bloque nuevo y vaciar la lista es un reinicio del arena.
+ * Servicios, hosts y orígenes se repiten mucho y se internan: cada alerta
+ * guarda un puntero a la copia única, que vive mientras viva el gestor.
+ *
+ * Las alertas se agregan por identidad (host, puerto, nivel, origen): en modo
+ * continuo el mismo puerto sospechoso se detecta en cada ciclo y, en lugar de
+ * un registro nuevo, se actualizan el contador y la última detección del que
+ * ya existe. Como las cadenas están internadas, la identidad se compara por
+ * puntero. La memoria, el resumen y los exportadores crecen así con los
+ * problemas distintos y no con el tiempo en marcha; el mensaje guardado es el
+ * de la primera detección.
+ *
+ * Además de la tabla de identidad, cada registro está en tres índices que se
+ * mantienen al insertar en O(1): una lista por nivel y otra por puerto, ambas
+ * en orden de llegada, y una lista doble ordenada por la última detección (una
+ * repetición mueve el registro al final, normalmente en O(1)). Un PortSet
+ * marca los puertos con alertas para recorrer sólo sus listas.
+ * alert_manager_query() elige el índice según el orden pedido, de modo que el
+ * resumen, los exportadores o un panel recorren sólo el tramo que les interesa
+ * en lugar de la lista completa una vez por nivel.
+ *
+ * alert_manager_add_alert() se puede llamar desde cualquier hilo: la alerta
+ * entra por una cola MPSC sin bloqueos (alert_queue.c) y sólo el hilo que
+ * creó el gestor la pasa al almacén indexado. Ese hilo la vacía en el acto al
+ * añadir y antes de cualquier consulta (resumen, exportación, recorrido), de
+ * modo que con un solo hilo el comportamiento es el de siempre. Las consultas
+ * y clear deben hacerse desde el hilo consumidor.
+ *
+ * Con un diario adjunto (alert_journal.c), el consumidor añade cada alerta al
+ * diario antes de pasarla al almacén, y alert_manager_attach_journal()
+ * reconstruye al arrancar el estado de la ejecución anterior a partir de él.
+ * El almacén es además el que escribe la instantánea cuando el diario se
+ * compacta: una entrada agregada por alerta distinta, por orden temporal.
+ * clear sólo vacía la memoria y deja de ofrecer instantáneas, porque el
+ * almacén ya no refleja lo que hay en el diario.
  */
 
 #include <stdio.h>
+#include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
 #include "alert_manager.h"
+#include "alert_queue.h"
+#include "alert_journal.h"
+
+#define STRING_TABLE_INITIAL 64
+#define INDEX_TABLE_INITIAL 256
 
 const char* alert_level_to_string(AlertLevel level) {
     switch (level) {
@@ -17,11 +61,185 @@ const char* alert_level_to_string(AlertLevel level) {
     }
 }
 
+static uint32_t hash_string(const char *text) {
+    uint32_t hash = 2166136261u;    // FNV-1a
+    while (*text) {
+        hash ^= (unsigned char)*text++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Hueco de 'text' en la tabla: el que lo contiene o el vacío donde iría
+static char** string_slot(char **slots, int capacity, const char *text) {
+    uint32_t index = hash_string(text) & (uint32_t)(capacity - 1);
+    while (slots[index] && strcmp(slots[index], text) != 0) {
+        index = (index + 1) & (uint32_t)(capacity - 1);
+    }
+    return &slots[index];
+}
+
+static int grow_strings(AlertManager *manager) {
+    int capacity = manager->string_capacity ? manager->string_capacity * 2 : STRING_TABLE_INITIAL;
+    char **slots = calloc(capacity, sizeof(char*));
+    if (!slots) return -1;
+    
+    for (int i = 0; i < manager->string_capacity; i++) {
+        if (manager->strings[i]) {
+            *string_slot(slots, capacity, manager->strings[i]) = manager->strings[i];
+        }
+    }
+    free(manager->strings);
+    manager->strings = slots;
+    manager->string_capacity = capacity;
+    return 0;
+}
+
+// Devuelve la copia única de 'text' (NULL sin memoria)
+static const char* intern_string(AlertManager *manager, const char *text) {
+    if (!text) text = "";
+    
+    // Factor de carga máximo 1/2
+    if ((manager->string_count + 1) * 2 > manager->string_capacity && grow_strings(manager) != 0) {
+        return NULL;
+    }
+    char **slot = string_slot(manager->strings, manager->string_capacity, text);
+    if (!*slot) {
+        *slot = strdup(text);
+        if (!*slot) return NULL;
+        manager->string_count++;
+    }
+    return *slot;
+}
+
+// Identidad de una alerta: las cadenas internadas se comparan por dirección
+static uint32_t hash_identity(const char *host, const char *source, int port, int level) {
+    uint64_t key = (uint64_t)(uintptr_t)host * 0x9E3779B97F4A7C15ULL;
+    key ^= (uint64_t)(uintptr_t)source * 0xC2B2AE3D27D4EB4FULL;
+    key ^= ((uint64_t)port << 8 | (uint64_t)level) * 0x165667B19E3779F9ULL;
+    return (uint32_t)(key ^ (key >> 32));
+}
+
+static AlertRecord** index_slot(AlertRecord **slots, int capacity, const char *host, const char *source,
+                                int port, int level) {
+    uint32_t index = hash_identity(host, source, port, level) & (uint32_t)(capacity - 1);
+    while (slots[index] && !(slots[index]->host == host && slots[index]->source == source &&
+                             slots[index]->port == port && slots[index]->level == level)) {
+        index = (index + 1) & (uint32_t)(capacity - 1);
+    }
+    return &slots[index];
+}
+
+static int insert_by_port(AlertManager *manager, AlertRecord *record) {
+    // Cabezas y colas de las 65536 listas en un solo bloque, reservado con la primera alerta
+    if (!manager->port_head) {
+        manager->port_head = calloc(2 * (PORT_SET_MAX_PORT + 1), sizeof(AlertRecord*));
+        if (!manager->port_head) return -1;
+        manager->port_tail = manager->port_head + PORT_SET_MAX_PORT + 1;
+    }
+    
+    record->port_next = NULL;
+    if (manager->port_tail[record->port]) {
+        manager->port_tail[record->port]->port_next = record;
+    } else {
+        manager->port_head[record->port] = record;
+        port_set_add(&manager->ports, record->port);
+    }
+    manager->port_tail[record->port] = record;
+    return 0;
+}
+
+// Coloca 'record' en el índice temporal detrás del último con last_seen <= el suyo
+static void time_link(AlertManager *manager, AlertRecord *record) {
+    AlertRecord *after = manager->time_tail;
+    while (after && after->last_seen > record->last_seen) {
+        after = after->time_prev;
+    }
+    record->time_prev = after;
+    record->time_next = after ? after->time_next : manager->time_head;
+    if (record->time_next) {
+        record->time_next->time_prev = record;
+    } else {
+        manager->time_tail = record;
+    }
+    if (after) {
+        after->time_next = record;
+    } else {
+        manager->time_head = record;
+    }
+}
+
+static void time_unlink(AlertManager *manager, AlertRecord *record) {
+    if (record->time_prev) {
+        record->time_prev->time_next = record->time_next;
+    } else {
+        manager->time_head = record->time_next;
+    }
+    if (record->time_next) {
+        record->time_next->time_prev = record->time_prev;
+    } else {
+        manager->time_tail = record->time_prev;
+    }
+}
+
+static void reset_indexes(AlertManager *manager) {
+    for (int level = 0; level < ALERT_LEVEL_COUNT; level++) {
+        manager->level_head[level] = NULL;
+        manager->level_tail[level] = NULL;
+    }
+    manager->time_head = NULL;
+    manager->time_tail = NULL;
+    
+    // Sólo las listas de puertos usados tienen algo que vaciar
+    if (manager->port_head) {
+        for (int port = port_set_next(&manager->ports, 0); port >= 0;
+             port = port_set_next(&manager->ports, port + 1)) {
+            manager->port_head[port] = NULL;
+            manager->port_tail[port] = NULL;
+        }
+    }
+    port_set_clear(&manager->ports);
+}
+
+static int grow_index(AlertManager *manager) {
+    int capacity = manager->index_capacity ? manager->index_capacity * 2 : INDEX_TABLE_INITIAL;
+    AlertRecord **slots = calloc(capacity, sizeof(AlertRecord*));
+    if (!slots) return -1;
+    
+    for (int i = 0; i < manager->index_capacity; i++) {
+        AlertRecord *record = manager->index[i];
+        if (record) {
+            *index_slot(slots, capacity, record->host, record->source, record->port, record->level) = record;
+        }
+    }
+    free(manager->index);
+    manager->index = slots;
+    manager->index_capacity = capacity;
+    return 0;
+}
+
 AlertManager* alert_manager_create() {
     AlertManager *manager = malloc(sizeof(AlertManager));
     if (!manager) return NULL;
     
-    manager->head = NULL;
+    manager->queue = alert_queue_create(ALERT_QUEUE_CAPACITY);
+    if (!manager->queue) {
+        free(manager);
+        return NULL;
+    }
+    manager->consumer = pthread_self();
+    manager->dropped = 0;
+    manager->journal = NULL;
+    arena_init(&manager->arena, ARENA_DEFAULT_CHUNK);
+    manager->port_head = NULL;
+    manager->port_tail = NULL;
+    reset_indexes(manager);
+    manager->index = NULL;
+    manager->index_capacity = 0;
+    manager->strings = NULL;
+    manager->string_capacity = 0;
+    manager->string_count = 0;
+    manager->occurrences = 0;
     manager->total_alerts = 0;
     manager->high_alerts = 0;
     manager->medium_alerts = 0;
@@ -33,20 +251,88 @@ AlertManager* alert_manager_create() {
 void alert_manager_destroy(AlertManager *manager) {
     if (!manager) return;
     
-    alert_manager_clear_alerts(manager);
+    alert_queue_destroy(manager->queue);
+    arena_destroy(&manager->arena);
+    free(manager->index);
+    free(manager->port_head);
+    for (int i = 0; i < manager->string_capacity; i++) {
+        free(manager->strings[i]);
+    }
+    free(manager->strings);
     free(manager);
 }
 
-int alert_manager_add_alert(AlertManager *manager, Alert *alert) {
-    if (!manager || !alert) return -1;
+// Pasa al almacén indexado una alerta detectada 'count' veces desde 'first_seen'
+// (sólo desde el hilo consumidor)
+static int store_alert(AlertManager *manager, const Alert *alert, uint32_t count, time_t first_seen) {
+    const char *host = intern_string(manager, alert->host);
+    const char *source = intern_string(manager, alert->source);
+    if (!host || !source) return -1;
+    
+    // Factor de carga máximo 1/2
+    if ((manager->total_alerts + 1) * 2 > manager->index_capacity && grow_index(manager) != 0) {
+        return -1;
+    }
+    AlertRecord **slot = index_slot(manager->index, manager->index_capacity, host, source,
+                                    (uint16_t)alert->port, (uint8_t)alert->level);
+    manager->occurrences += count;
     
-    AlertNode *new_node = malloc(sizeof(AlertNode));
-    if (!new_node) return -1;
+    // Alerta repetida: actualizar la existente en su sitio
+    if (*slot) {
+        AlertRecord *record = *slot;
+        record->count += count;
+        if (first_seen < record->first_seen) record->first_seen = first_seen;
+        if (alert->timestamp > record->last_seen) {
+            record->last_seen = alert->timestamp;
+            if (record->time_next && record->time_next->last_seen < record->last_seen) {
+                time_unlink(manager, record);
+                time_link(manager, record);
+            }
+        }
+        return 0;
+    }
+    
+    const char *service = intern_string(manager, alert->service);
+    if (!service || (uint8_t)alert->level >= ALERT_LEVEL_COUNT) {
+        manager->occurrences -= count;
+        return -1;
+    }
+    
+    // Registro y mensaje contiguos en el arena
+    const char *message = alert->message ? alert->message : "";
+    size_t length = strlen(message) + 1;
+    AlertRecord *record = arena_alloc(&manager->arena, sizeof(AlertRecord) + length);
+    if (!record) {
+        manager->occurrences -= count;
+        return -1;
+    }
+    
+    char *text = (char*)(record + 1);
+    memcpy(text, message, length);
+    record->message = text;
+    record->service = service;
+    record->host = host;
+    record->source = source;
+    record->first_seen = first_seen < alert->timestamp ? first_seen : alert->timestamp;
+    record->last_seen = alert->timestamp;
+    record->count = count;
+    record->port = (uint16_t)alert->port;
+    record->level = (uint8_t)alert->level;
+    if (insert_by_port(manager, record) != 0) {
+        manager->occurrences -= count;
+        return -1;
+    }
+    *slot = record;
     
-    // Copiar la alerta
-    new_node->alert = *alert;
-    new_node->next = manager->head;
-    manager->head = new_node;
+    // Índices por nivel y temporal
+    record->next = NULL;
+    if (manager->level_tail[record->level]) {
+        manager->level_tail[record->level]->next = record;
+    } else {
+        manager->level_head[record->level] = record;
+    }
+    manager->level_tail[record->level] = record;
+    time_link(manager, record);
     
     // Actualizar contadores
     manager->total_alerts++;
@@ -65,75 +351,184 @@ int alert_manager_add_alert(AlertManager *manager, Alert *alert) {
     return 0;
 }
 
-void print_alert(Alert *alert) {
+static void consume_alert(const Alert *alert, void *user_data) {
+    AlertManager *manager = (AlertManager*)user_data;
+    
+    // Primero al diario: un fallo allí se cuenta en el diario y la alerta sigue en memoria
+    if (manager->journal) {
+        alert_journal_append(manager->journal, alert);
+    }
+    if (store_alert(manager, alert, 1, alert->timestamp) != 0) {
+        manager->dropped++;
+    }
+}
+
+// Vacía la cola de entrada en el almacén; devuelve cuántas alertas pasaron
+int alert_manager_drain(AlertManager *manager) {
+    if (!manager || !pthread_equal(pthread_self(), manager->consumer)) return 0;
+    return alert_queue_drain(manager->queue, consume_alert, manager);
+}
+
+// Restaura una alerta ya agregada (detectada 'count' veces entre 'first_seen' y su
+// timestamp) sin pasar por la cola ni por el diario; sólo desde el hilo consumidor
+int alert_manager_restore_alert(AlertManager *manager, const Alert *alert, uint32_t count, time_t first_seen) {
+    if (!manager || !alert || count == 0 || !pthread_equal(pthread_self(), manager->consumer)) return -1;
+    if (store_alert(manager, alert, count, first_seen) != 0) {
+        manager->dropped++;
+        return -1;
+    }
+    return 0;
+}
+
+static void replay_alert(const Alert *alert, uint32_t count, time_t first_seen, void *user_data) {
+    alert_manager_restore_alert((AlertManager*)user_data, alert, count, first_seen);
+}
+
+// Instantánea para la compactación del diario: una entrada agregada por alerta distinta
+static void write_snapshot(struct AlertJournal *journal, void *user_data) {
+    AlertManager *manager = (AlertManager*)user_data;
+    for (AlertRecord *record = manager->time_head; record; record = record->time_next) {
+        Alert alert;
+        alert.level = (AlertLevel)record->level;
+        alert.message = record->message;
+        alert.port = record->port;
+        alert.service = record->service;
+        alert.host = record->host;
+        alert.source = record->source;
+        alert.timestamp = record->last_seen;
+        if (alert_journal_append_aggregate(journal, &alert, record->count, record->first_seen) != 0) return;
+    }
+}
+
+// Reconstruye el almacén desde el diario, lo compacta y registra en él las alertas nuevas.
+// Devuelve cuántas entradas se leyeron o -1 si no se pudo leer
+int alert_manager_attach_journal(AlertManager *manager, struct AlertJournal *journal) {
+    if (!manager || !journal || !pthread_equal(pthread_self(), manager->consumer)) return -1;
+    alert_manager_drain(manager);
+    
+    AlertJournalCursor cursor = { 0, 0 };
+    int replayed = alert_journal_read(journal->directory, &cursor, replay_alert, manager);
+    if (replayed < 0) return -1;
+    manager->journal = journal;
+    
+    // Compactar sólo si hay repeticiones que agrupar. Si falla, el diario sigue
+    // como estaba y se reintenta al llenarse el segmento
+    journal->snapshot = write_snapshot;
+    journal->snapshot_data = manager;
+    if (replayed > manager->total_alerts) {
+        alert_journal_compact(journal);
+    }
+    return replayed;
+}
+
+int alert_manager_add_alert(AlertManager *manager, const Alert *alert) {
+    if (!manager || !alert) return -1;
+    
+    int consumer = pthread_equal(pthread_self(), manager->consumer);
+    if (alert_queue_push(manager->queue, alert) != 0) {
+        // Cola llena: el consumidor la vacía y reintenta; otro hilo no espera y la pierde
+        if (!consumer) {
+            __atomic_fetch_add(&manager->queue->overflows, 1, __ATOMIC_RELAXED);
+            return -1;
+        }
+        alert_manager_drain(manager);
+        if (alert_queue_push(manager->queue, alert) != 0) return -1;
+    }
+    if (consumer) {
+        alert_manager_drain(manager);
+    }
+    return 0;
+}
+
+void print_alert(const AlertRecord *alert) {
     char time_str[64];
-    struct tm *tm_info = localtime(&alert->timestamp);
+    struct tm *tm_info = localtime(&alert->first_seen);
     strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", tm_info);
     
-    const char *level_str = alert_level_to_string(alert->level);
-    printf("  [%s] %s - Puerto: %d, Servicio: %s - %s\n", 
+    const char *level_str = alert_level_to_string((AlertLevel)alert->level);
+    printf("  [%s] %s - Puerto: %d, Servicio: %s - %s", 
            level_str, alert->message, alert->port, alert->service, time_str);
+    if (alert->count > 1) {
+        char last_str[64];
+        tm_info = localtime(&alert->last_seen);
+        strftime(last_str, sizeof(last_str), "%Y-%m-%d %H:%M:%S", tm_info);
+        printf(" (x%u, última %s)", alert->count, last_str);
+    }
+    printf("\n");
+}
+
+static void show_alert(const AlertRecord *alert, void *user_data) {
+    (void)user_data;
+    print_alert(alert);
 }
 
 void alert_manager_show_summary(AlertManager *manager) {
     if (!manager) return;
+    alert_manager_drain(manager);
     
-    printf("Total de alertas: %d\n", manager->total_alerts);
+    printf("Total de alertas: %d", manager->total_alerts);
+    if (manager->occurrences > (unsigned long long)manager->total_alerts) {
+        printf(" (%llu detecciones)", manager->occurrences);
+    }
+    printf("\n");
     printf("  - Alertas ALTAS: %d\n", manager->high_alerts);
     printf("  - Alertas MEDIAS: %d\n", manager->medium_alerts);
     printf("  - Alertas BAJAS: %d\n", manager->low_alerts);
+    if (manager->dropped > 0 || manager->queue->overflows > 0) {
+        printf("  - Alertas perdidas: %llu (cola llena: %llu)\n",
+               manager->dropped + manager->queue->overflows, manager->queue->overflows);
+    }
     
     if (manager->total_alerts > 0) {
         printf("\nDetalle de alertas:\n");
         
-        // Mostrar alertas de alta prioridad primero
-        AlertNode *current = manager->head;
-        while (current) {
-            if (current->alert.level == ALERT_HIGH) {
-                print_alert(&current->alert);
-            }
-            current = current->next;
-        }
-        
-        // Luego alertas de prioridad media
-        current = manager->head;
-        while (current) {
-            if (current->alert.level == ALERT_MEDIUM) {
-                print_alert(&current->alert);
-            }
-            current = current->next;
-        }
-        
-        // Finalmente alertas de prioridad baja
-        current = manager->head;
-        while (current) {
-            if (current->alert.level == ALERT_LOW) {
-                print_alert(&current->alert);
-            }
-            current = current->next;
-        }
+        // Alta prioridad primero y, dentro de cada nivel, en orden de llegada
+        AlertQuery query;
+        alert_query_init(&query);
+        alert_manager_query(manager, &query, show_alert, NULL);
     }
 }
 
 void alert_manager_clear_alerts(AlertManager *manager) {
     if (!manager) return;
-    
-    AlertNode *current = manager->head;
-    while (current) {
-        AlertNode *next = current->next;
-        free(current);
-        current = next;
+    alert_manager_drain(manager);
+    if (manager->journal) {
+        manager->journal->snapshot = NULL;
     }
     
-    manager->head = NULL;
+    // Los registros viven en el arena: se liberan todos a la vez
+    arena_reset(&manager->arena);
+    if (manager->index) {
+        memset(manager->index, 0, manager->index_capacity * sizeof(AlertRecord*));
+    }
+    reset_indexes(manager);
+    manager->occurrences = 0;
     manager->total_alerts = 0;
     manager->high_alerts = 0;
     manager->medium_alerts = 0;
     manager->low_alerts = 0;
 }
 
+static void export_alert(const AlertRecord *alert, void *user_data) {
+    FILE *file = (FILE*)user_data;
+    char alert_time_str[64];
+    struct tm *alert_tm_info = localtime(&alert->first_seen);
+    strftime(alert_time_str, sizeof(alert_time_str), "%Y-%m-%d %H:%M:%S", alert_tm_info);
+    
+    fprintf(file, "• %s\n", alert->message);
+    fprintf(file, "  Puerto: %d | Servicio: %s | Hora: %s",
+           alert->port, alert->service, alert_time_str);
+    if (alert->count > 1) {
+        strftime(alert_time_str, sizeof(alert_time_str), "%Y-%m-%d %H:%M:%S",
+                 localtime(&alert->last_seen));
+        fprintf(file, " | Veces: %u | Última: %s", alert->count, alert_time_str);
+    }
+    fprintf(file, "\n\n");
+}
+
 int alert_manager_export_to_file(AlertManager *manager, const char *filename) {
     if (!manager || !filename) return -1;
+    alert_manager_drain(manager);
     
     FILE *file = fopen(filename, "w");
     if (!file) return -1;
@@ -148,7 +543,11 @@ int alert_manager_export_to_file(AlertManager *manager, const char *filename) {
     fprintf(file, "Fecha de generación: %s\n\n", time_str);
     
     fprintf(file, "RESUMEN:\n");
-    fprintf(file, "Total de alertas: %d\n", manager->total_alerts);
+    fprintf(file, "Total de alertas: %d", manager->total_alerts);
+    if (manager->occurrences > (unsigned long long)manager->total_alerts) {
+        fprintf(file, " (%llu detecciones)", manager->occurrences);
+    }
+    fprintf(file, "\n");
     fprintf(file, "  - Alertas ALTAS: %d\n", manager->high_alerts);
     fprintf(file, "  - Alertas MEDIAS: %d\n", manager->medium_alerts);
     fprintf(file, "  - Alertas BAJAS: %d\n\n", manager->low_alerts);
@@ -161,41 +560,109 @@ int alert_manager_export_to_file(AlertManager *manager, const char *filename) {
         const AlertLevel priorities[] = {ALERT_HIGH, ALERT_MEDIUM, ALERT_LOW};
         const char* priority_names[] = {"ALTA PRIORIDAD", "MEDIA PRIORIDAD", "BAJA PRIORIDAD"};
         
+        AlertQuery query;
+        alert_query_init(&query);
+        
         for (int p = 0; p < 3; p++) {
             AlertLevel priority = priorities[p];
-            int found_any = 0;
+            if (!manager->level_head[priority]) continue;
             
-            AlertNode *current = manager->head;
-            while (current) {
-                if (current->alert.level == priority) {
-                    if (!found_any) {
-                        fprintf(file, "%s:\n", priority_names[p]);
-                        fprintf(file, "%s\n", (p == 0) ? "===============" : 
-                                            (p == 1) ? "=================" : "================");
-                        found_any = 1;
+            fprintf(file, "%s:\n", priority_names[p]);
+            fprintf(file, "%s\n", (p == 0) ? "===============" : 
+                                (p == 1) ? "=================" : "================");
+            query.levels = ALERT_LEVEL_MASK(priority);
+            alert_manager_query(manager, &query, export_alert, file);
+            fprintf(file, "\n");
+        }
+    }
+    
+    fclose(file);
+    return 0;
+}
+
+// Todas las alertas por última detección, de la más antigua a la más reciente (time_next)
+AlertRecord* alert_manager_get_alerts(AlertManager *manager) {
+    if (!manager) return NULL;
+    alert_manager_drain(manager);
+    return manager->time_head;
+}
+
+void alert_query_init(AlertQuery *query) {
+    query->levels = ALERT_LEVEL_ALL;
+    query->port_min = 0;
+    query->port_max = 65535;
+    query->since = 0;
+    query->until = 0;
+    query->limit = 0;
+    query->order = ALERT_ORDER_PRIORITY;
+}
+
+static int query_matches(const AlertQuery *query, const AlertRecord *record) {
+    return (query->levels & ALERT_LEVEL_MASK(record->level)) &&
+           record->port >= query->port_min && record->port <= query->port_max &&
+           (!query->since || record->last_seen >= query->since) &&
+           (!query->until || record->first_seen <= query->until);
+}
+
+// Recorre las alertas que cumplen 'query' en el orden pedido; devuelve cuántas visitó.
+// Cada orden parte de su índice, así que el coste es el del tramo recorrido: los niveles
+// excluidos, los puertos fuera de rango o lo anterior a 'since' no se visitan.
+int alert_manager_query(AlertManager *manager, const AlertQuery *query, AlertVisitor visitor, void *user_data) {
+    if (!manager || !query || !visitor) return -1;
+    alert_manager_drain(manager);
+    
+    int limit = query->limit > 0 ? query->limit : INT_MAX;
+    int visited = 0;
+    
+    switch (query->order) {
+        case ALERT_ORDER_PRIORITY:
+            for (int level = ALERT_LEVEL_COUNT - 1; level >= 0 && visited < limit; level--) {
+                if (!(query->levels & ALERT_LEVEL_MASK(level))) continue;
+                for (AlertRecord *record = manager->level_head[level]; record && visited < limit;
+                     record = record->next) {
+                    if (query_matches(query, record)) {
+                        visitor(record, user_data);
+                        visited++;
                     }
-                    
-                    char alert_time_str[64];
-                    struct tm *alert_tm_info = localtime(&current->alert.timestamp);
-                    strftime(alert_time_str, sizeof(alert_time_str), "%Y-%m-%d %H:%M:%S", alert_tm_info);
-                    
-                    fprintf(file, "• %s\n", current->alert.message);
-                    fprintf(file, "  Puerto: %d | Servicio: %s | Hora: %s\n\n", 
-                           current->alert.port, current->alert.service, alert_time_str);
                 }
-                current = current->next;
             }
+            break;
             
-            if (found_any) {
-                fprintf(file, "\n");
+        case ALERT_ORDER_PORT: {
+            int port = query->port_min > 0 ? query->port_min : 0;
+            for (port = port_set_next(&manager->ports, port);
+                 port >= 0 && port <= query->port_max && visited < limit;
+                 port = port_set_next(&manager->ports, port + 1)) {
+                for (AlertRecord *record = manager->port_head[port]; record && visited < limit;
+                     record = record->port_next) {
+                    if (query_matches(query, record)) {
+                        visitor(record, user_data);
+                        visited++;
+                    }
+                }
+            }
+            break;
+        }
+        
+        case ALERT_ORDER_TIME: {
+            // Desde el final hacia atrás hasta la primera detectada en [since, ...]
+            AlertRecord *record = manager->time_head;
+            if (query->since) {
+                record = manager->time_tail;
+                if (record && record->last_seen < query->since) record = NULL;
+                while (record && record->time_prev && record->time_prev->last_seen >= query->since) {
+                    record = record->time_prev;
+                }
             }
+            for (; record && visited < limit; record = record->time_next) {
+                if (query_matches(query, record)) {
+                    visitor(record, user_data);
+                    visited++;
+                }
+            }
+            break;
         }
     }
     
-    fclose(file);
-    return 0;
-}
-
-AlertNode* alert_manager_get_alerts(AlertManager *manager) {
-    return manager ? manager->head : NULL;
+    return visited;
 }
@@ -5,7 +5,14 @@
 #ifndef ALERT_MANAGER_H
 #define ALERT_MANAGER_H
 
+#include <stdint.h>
 #include <time.h>
+#include <pthread.h>
+#include "arena.h"
+#include "port_set.h"
+
+struct AlertQueue;
+struct AlertJournal;
 
 typedef enum {
     ALERT_LOW,
@@ -13,22 +20,79 @@ typedef enum {
     ALERT_HIGH
 } AlertLevel;
 
+#define ALERT_LEVEL_COUNT 3
+#define ALERT_LEVEL_MASK(level) (1 << (level))
+#define ALERT_LEVEL_ALL (ALERT_LEVEL_MASK(ALERT_LOW) | ALERT_LEVEL_MASK(ALERT_MEDIUM) | \
+                         ALERT_LEVEL_MASK(ALERT_HIGH))
+
+// Alerta a registrar; las cadenas se copian al arena en alert_manager_add_alert()
 typedef struct {
     AlertLevel level;
-    char message[512];
+    const char *message;
     int port;
-    char service[64];
+    const char *service;
+    const char *host;           // Dirección del host ("" o NULL si no aplica)
+    const char *source;         // Origen: protocolo del escáner ("tcp", "udp") u otro componente
     time_t timestamp;
 } Alert;
 
-typedef struct AlertNode {
-    Alert alert;
-    struct AlertNode *next;
-} AlertNode;
+// Registro compacto de una alerta distinta (host, puerto, nivel, origen) y sus repeticiones
+typedef struct AlertRecord {
+    struct AlertRecord *next;       // Siguiente del mismo nivel, en orden de llegada
+    struct AlertRecord *port_next;  // Siguiente del mismo puerto, en orden de llegada
+    struct AlertRecord *time_prev;  // Índice temporal: por última detección, ascendente
+    struct AlertRecord *time_next;
+    const char *message;        // Texto de la primera aparición, en el arena
+    const char *service;        // Cadenas internadas, compartidas entre alertas
+    const char *host;
+    const char *source;
+    time_t first_seen;
+    time_t last_seen;
+    uint32_t count;             // Veces que se detectó
+    uint16_t port;
+    uint8_t level;              // AlertLevel
+} AlertRecord;
+
+// Orden de los resultados de una consulta; cada uno se sirve desde su índice
+typedef enum {
+    ALERT_ORDER_PRIORITY,       // Por nivel (ALTA primero) y, dentro de él, por llegada
+    ALERT_ORDER_PORT,           // Por puerto ascendente
+    ALERT_ORDER_TIME            // Por última detección, de la más antigua a la más reciente
+} AlertOrder;
+
+// Filtros de alert_manager_query(); alert_query_init() los deja sin restricciones
+typedef struct {
+    int levels;                 // Máscara de ALERT_LEVEL_MASK()
+    int port_min;
+    int port_max;
+    time_t since;               // Alertas detectadas en algún momento de [since, until];
+    time_t until;               // 0 = sin límite por ese lado
+    int limit;                  // Máximo de resultados (0 = sin límite)
+    AlertOrder order;
+} AlertQuery;
+
+typedef void (*AlertVisitor)(const AlertRecord *alert, void *user_data);
 
 typedef struct {
-    AlertNode *head;
-    int total_alerts;
+    struct AlertQueue *queue;   // Entrada desde cualquier hilo (alert_queue.h)
+    pthread_t consumer;         // Hilo que vacía la cola en el almacén: el creador
+    unsigned long long dropped; // Alertas perdidas: cola llena en otro hilo o sin memoria
+    struct AlertJournal *journal;   // Diario en disco (alert_journal.h) o NULL
+    Arena arena;                // Registros y mensajes; se vacía en bloque
+    AlertRecord *level_head[ALERT_LEVEL_COUNT];     // Listas por nivel en orden de llegada
+    AlertRecord *level_tail[ALERT_LEVEL_COUNT];
+    AlertRecord *time_head;     // Índice temporal (lista doble por last_seen)
+    AlertRecord *time_tail;
+    AlertRecord **port_head;    // Listas por puerto en orden de llegada (65536 cabezas y colas)
+    AlertRecord **port_tail;
+    PortSet ports;              // Puertos con alguna alerta: sus listas no están vacías
+    AlertRecord **index;        // Tabla hash por identidad de la alerta (direccionamiento abierto)
+    int index_capacity;         // Potencia de dos
+    char **strings;             // Tabla hash de cadenas internadas (servicios, hosts, orígenes)
+    int string_capacity;        // Potencia de dos
+    int string_count;
+    unsigned long long occurrences; // Detecciones, incluidas las repetidas
+    int total_alerts;           // Alertas distintas (los contadores por nivel también)
     int high_alerts;
     int medium_alerts;
     int low_alerts;
@@ -37,14 +101,19 @@ typedef struct {
 // Funciones públicas
 AlertManager* alert_manager_create();
 void alert_manager_destroy(AlertManager *manager);
-int alert_manager_add_alert(AlertManager *manager, Alert *alert);
+int alert_manager_add_alert(AlertManager *manager, const Alert *alert);
+int alert_manager_drain(AlertManager *manager);
+int alert_manager_attach_journal(AlertManager *manager, struct AlertJournal *journal);
+int alert_manager_restore_alert(AlertManager *manager, const Alert *alert, uint32_t count, time_t first_seen);
 void alert_manager_show_summary(AlertManager *manager);
 void alert_manager_clear_alerts(AlertManager *manager);
 int alert_manager_export_to_file(AlertManager *manager, const char *filename);
-AlertNode* alert_manager_get_alerts(AlertManager *manager);
+AlertRecord* alert_manager_get_alerts(AlertManager *manager);
+int alert_manager_query(AlertManager *manager, const AlertQuery *query, AlertVisitor visitor, void *user_data);
 
 // Funciones auxiliares
 const char* alert_level_to_string(AlertLevel level);
-void print_alert(Alert *alert);
+void print_alert(const AlertRecord *alert);
+void alert_query_init(AlertQuery *query);
 
 #endif
@@ -0,0 +1,130 @@
+/*
+ * Alert Queue - Implementación de la cola MPSC sin bloqueos
+ *
+ * Anillo acotado con un número de secuencia por ranura (esquema de Vyukov).
+ * Un productor reserva la posición de la cola con un único compare-and-swap,
+ * copia la alerta a la ranura y la publica con un store de liberación; nunca
+ * espera a otro hilo ni a la salida. Si el anillo está lleno la alerta no se
+ * encola y se cuenta en overflows. El único consumidor recorre las ranuras
+ * publicadas en orden sin operaciones atómicas de lectura-modificación.
+ *
+ * Las cadenas de la alerta pertenecen al productor (suelen estar en su pila),
+ * así que se copian empaquetadas en la ranura; un mensaje que no cabe se
+ * recorta y se cuenta en truncated.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "alert_queue.h"
+
+AlertQueue* alert_queue_create(unsigned int capacity) {
+    if (capacity < 2 || (capacity & (capacity - 1)) != 0) return NULL;
+
+    AlertQueue *queue = aligned_alloc(ALERT_QUEUE_CACHE_LINE, sizeof(AlertQueue));
+    if (!queue) return NULL;
+    memset(queue, 0, sizeof(AlertQueue));
+
+    queue->slots = aligned_alloc(ALERT_QUEUE_CACHE_LINE, capacity * sizeof(AlertQueueSlot));
+    if (!queue->slots) {
+        free(queue);
+        return NULL;
+    }
+    for (unsigned int i = 0; i < capacity; i++) {
+        queue->slots[i].sequence = i;
+    }
+    queue->mask = capacity - 1;
+    return queue;
+}
+
+void alert_queue_destroy(AlertQueue *queue) {
+    if (queue) {
+        free(queue->slots);
+        free(queue);
+    }
+}
+
+// Copia 'text' a partir de 'offset'; devuelve el desplazamiento siguiente
+static size_t pack_string(char *buffer, size_t offset, size_t limit, const char *text, int *cut) {
+    size_t length = text ? strlen(text) : 0;
+    if (offset + length + 1 > limit) {
+        length = limit > offset + 1 ? limit - offset - 1 : 0;
+        *cut = 1;
+    }
+    if (length > 0) memcpy(buffer + offset, text, length);
+    buffer[offset + length] = '\0';
+    return offset + length + 1;
+}
+
+// Encola una copia de 'alert'; -1 si el anillo está lleno. Seguro desde cualquier hilo
+int alert_queue_push(AlertQueue *queue, const Alert *alert) {
+    uint64_t position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+    AlertQueueSlot *slot;
+
+    for (;;) {
+        slot = &queue->slots[position & queue->mask];
+        uint64_t sequence = __atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE);
+        int64_t distance = (int64_t)(sequence - position);
+        if (distance == 0) {
+            // Ranura libre: reservarla (si otro productor se adelantó, position se actualiza)
+            if (__atomic_compare_exchange_n(&queue->tail, &position, position + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (distance < 0) {
+            // El consumidor no ha liberado esta ranura: anillo lleno
+            return -1;
+        } else {
+            position = __atomic_load_n(&queue->tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    // Servicio, host y origen primero (cortos); el mensaje ocupa lo que quede
+    int cut = 0;
+    char strings[3 * 128];
+    size_t used = 0;
+    size_t service = used;
+    used = pack_string(strings, used, sizeof(strings), alert->service, &cut);
+    size_t host = used;
+    used = pack_string(strings, used, sizeof(strings), alert->host, &cut);
+    size_t source = used;
+    used = pack_string(strings, used, sizeof(strings), alert->source, &cut);
+
+    size_t message_end = pack_string(slot->text, 0, ALERT_QUEUE_TEXT_SIZE - used, alert->message, &cut);
+    memcpy(slot->text + message_end, strings, used);
+    slot->service = (uint16_t)(message_end + service);
+    slot->host = (uint16_t)(message_end + host);
+    slot->source = (uint16_t)(message_end + source);
+    slot->level = alert->level;
+    slot->port = alert->port;
+    slot->timestamp = alert->timestamp;
+    if (cut) __atomic_fetch_add(&queue->truncated, 1, __ATOMIC_RELAXED);
+
+    __atomic_store_n(&slot->sequence, position + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+// Entrega al consumidor las alertas publicadas, en orden; devuelve cuántas. Sólo desde un hilo
+int alert_queue_drain(AlertQueue *queue, AlertQueueConsumer consumer, void *user_data) {
+    int drained = 0;
+    for (;;) {
+        uint64_t position = queue->head;
+        AlertQueueSlot *slot = &queue->slots[position & queue->mask];
+        if (__atomic_load_n(&slot->sequence, __ATOMIC_ACQUIRE) != position + 1) break;
+
+        Alert alert;
+        alert.level = slot->level;
+        alert.message = slot->text;
+        alert.port = slot->port;
+        alert.service = slot->text + slot->service;
+        alert.host = slot->text + slot->host;
+        alert.source = slot->text + slot->source;
+        alert.timestamp = slot->timestamp;
+        consumer(&alert, user_data);
+
+        // Liberar la ranura para la siguiente vuelta del anillo
+        __atomic_store_n(&slot->sequence, position + queue->mask + 1, __ATOMIC_RELEASE);
+        queue->head = position + 1;
+        drained++;
+    }
+    return drained;
+}
@@ -0,0 +1,46 @@
+/*
+ * Alert Queue - Cola sin bloqueos de varios productores y un consumidor para las alertas
+ */
+
+#ifndef ALERT_QUEUE_H
+#define ALERT_QUEUE_H
+
+#include <stdint.h>
+#include <time.h>
+#include "alert_manager.h"
+
+#define ALERT_QUEUE_CAPACITY 256        // Potencia de dos
+#define ALERT_QUEUE_TEXT_SIZE 760       // Mensaje, servicio, host y origen empaquetados
+#define ALERT_QUEUE_CACHE_LINE 64
+
+typedef struct {
+    uint64_t sequence;          // Libre para la posición p cuando vale p; lista cuando vale p + 1
+    AlertLevel level;
+    int port;
+    time_t timestamp;
+    uint16_t service;           // Desplazamientos dentro de text (el mensaje empieza en 0)
+    uint16_t host;
+    uint16_t source;
+    char text[ALERT_QUEUE_TEXT_SIZE];
+} __attribute__((aligned(ALERT_QUEUE_CACHE_LINE))) AlertQueueSlot;
+
+typedef struct AlertQueue {
+    AlertQueueSlot *slots;
+    uint64_t mask;
+    // Productores y consumidor escriben en líneas de caché distintas
+    uint64_t tail __attribute__((aligned(ALERT_QUEUE_CACHE_LINE)));
+    uint64_t head __attribute__((aligned(ALERT_QUEUE_CACHE_LINE)));
+    unsigned long long overflows __attribute__((aligned(ALERT_QUEUE_CACHE_LINE)));
+    unsigned long long truncated;   // Mensajes recortados para caber en la ranura
+} AlertQueue;
+
+// Recibe cada alerta al vaciar la cola; sus cadenas sólo valen durante la llamada
+typedef void (*AlertQueueConsumer)(const Alert *alert, void *user_data);
+
+// Funciones públicas
+AlertQueue* alert_queue_create(unsigned int capacity);
+void alert_queue_destroy(AlertQueue *queue);
+int alert_queue_push(AlertQueue *queue, const Alert *alert);
+int alert_queue_drain(AlertQueue *queue, AlertQueueConsumer consumer, void *user_data);
+
+#endif
@@ -0,0 +1,96 @@
+/*
+ * Arena - Implementación del asignador por bloques
+ *
+ * Las asignaciones avanzan un puntero dentro del bloque actual y no se
+ * liberan por separado. arena_reset() vuelve al primer bloque en O(1): los
+ * bloques se conservan y se reutilizan en orden (cada uno se vacía al volver
+ * a él), así que la memoria reservada queda acotada por el máximo alcanzado
+ * en lugar de crecer con cada ciclo de asignar y liberar.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "arena.h"
+
+static size_t align_up(size_t size) {
+    return (size + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1);
+}
+
+static ArenaChunk* chunk_create(size_t size) {
+    ArenaChunk *chunk = malloc(sizeof(ArenaChunk) + size);
+    if (!chunk) return NULL;
+    chunk->next = NULL;
+    chunk->size = size;
+    chunk->used = 0;
+    return chunk;
+}
+
+void arena_init(Arena *arena, size_t chunk_size) {
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->chunk_size = chunk_size > 0 ? align_up(chunk_size) : ARENA_DEFAULT_CHUNK;
+    arena->reserved = 0;
+    arena->used = 0;
+}
+
+void* arena_alloc(Arena *arena, size_t size) {
+    if (!arena || size == 0) return NULL;
+    size = align_up(size);
+
+    // Avanzar por los bloques conservados hasta uno con espacio
+    ArenaChunk *chunk = arena->current;
+    while (chunk && chunk->used + size > chunk->size) {
+        if (!chunk->next) {
+            chunk = NULL;
+            break;
+        }
+        chunk = chunk->next;
+        chunk->used = 0;
+        arena->current = chunk;
+    }
+
+    if (!chunk) {
+        size_t chunk_size = size > arena->chunk_size ? size : arena->chunk_size;
+        chunk = chunk_create(chunk_size);
+        if (!chunk) return NULL;
+        if (arena->current) {
+            arena->current->next = chunk;
+        } else {
+            arena->first = chunk;
+        }
+        arena->current = chunk;
+        arena->reserved += sizeof(ArenaChunk) + chunk_size;
+    }
+
+    void *pointer = chunk->data + chunk->used;
+    chunk->used += size;
+    arena->used += size;
+    return pointer;
+}
+
+char* arena_strdup(Arena *arena, const char *text) {
+    size_t length = strlen(text) + 1;
+    char *copy = arena_alloc(arena, length);
+    if (copy) memcpy(copy, text, length);
+    return copy;
+}
+
+// Libera todas las asignaciones en O(1) conservando los bloques
+void arena_reset(Arena *arena) {
+    arena->current = arena->first;
+    if (arena->current) arena->current->used = 0;
+    arena->used = 0;
+}
+
+void arena_destroy(Arena *arena) {
+    ArenaChunk *chunk = arena->first;
+    while (chunk) {
+        ArenaChunk *next = chunk->next;
+        free(chunk);
+        chunk = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->reserved = 0;
+    arena->used = 0;
+}
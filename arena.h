@@ -0,0 +1,35 @@
+/*
+ * Arena - Asignador por bloques con liberación en bloque
+ */
+
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+#define ARENA_DEFAULT_CHUNK (64 * 1024)
+#define ARENA_ALIGN 8
+
+typedef struct ArenaChunk {
+    struct ArenaChunk *next;
+    size_t size;            // Bytes útiles de data
+    size_t used;
+    char data[];
+} ArenaChunk;
+
+typedef struct {
+    ArenaChunk *first;      // Bloques en orden de uso; se conservan al reiniciar
+    ArenaChunk *current;    // Bloque donde se asigna ahora
+    size_t chunk_size;
+    size_t reserved;        // Bytes pedidos al sistema (todos los bloques)
+    size_t used;            // Bytes asignados desde el último reinicio
+} Arena;
+
+// Funciones públicas
+void arena_init(Arena *arena, size_t chunk_size);
+void* arena_alloc(Arena *arena, size_t size);
+char* arena_strdup(Arena *arena, const char *text);
+void arena_reset(Arena *arena);
+void arena_destroy(Arena *arena);
+
+#endif
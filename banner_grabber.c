@@ -0,0 +1,354 @@
+/*
+ * Banner Grabber - Implementación de la fase de identificación
+ *
+ * Tras el escaneo, cada puerto abierto recibe una conexión completa en un
+ * bucle epoll con la misma ventana y rueda de plazos que el motor de
+ * escaneo. Primero se espera el banner espontáneo (SSH, FTP, SMTP, MySQL...)
+ * y, si en BANNER_PASSIVE_MS no llega nada, se envía una sonda de protocolo:
+ * una específica del puerto si la hay y, si no, una petición HTTP mínima, a
+ * la que responden con algo reconocible también muchos servicios no HTTP.
+ *
+ * Los bytes recibidos se pasan al autómata de firmas a medida que llegan;
+ * como su estado se conserva entre lecturas, no hace falta acumular el
+ * banner. Todas las conexiones leen sobre un único búfer compartido y los
+ * resultados se reservan de una vez, así que identificar miles de puertos
+ * no reserva memoria por conexión. Una interrupción (running a 0) cierra las
+ * conexiones en curso y deja sin identificar los puertos que faltaban.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <ctype.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "banner_grabber.h"
+#include "scan_engine.h"
+#include "timer_wheel.h"
+
+typedef struct {
+    int port;
+    const char *payload;
+} BannerProbe;
+
+// Sondas específicas por puerto; el resto recibe la petición HTTP
+static const BannerProbe protocol_probes[] = {
+    {6379, "PING\r\n"},
+    {0, NULL} // Terminador
+};
+
+static const char http_probe[] = "GET / HTTP/1.0\r\n\r\n";
+
+typedef enum {
+    GRAB_CONNECTING,
+    GRAB_PASSIVE,           // Conectado, esperando el banner espontáneo
+    GRAB_PROBED             // Sonda enviada, esperando la respuesta
+} GrabState;
+
+typedef struct {
+    int fd;
+    int result;             // Índice en el arreglo de resultados
+    GrabState state;
+    int matcher_state;
+    int received;
+} GrabSlot;
+
+typedef struct {
+    GrabSlot *slots;
+    int *free_list;
+    int free_count;
+    int inflight;
+    int epfd;
+    TimerWheel *wheel;
+    int timeout_ms;
+    int passive_ms;
+    const ServiceMatcher *matcher;
+    FdBudget *fds;
+    BannerResult *results;
+    uint8_t *buffer;        // Búfer de lectura compartido
+} BannerScan;
+
+const char* banner_probe_for_port(int port, size_t *length) {
+    for (int i = 0; protocol_probes[i].payload != NULL; i++) {
+        if (protocol_probes[i].port == port) {
+            *length = strlen(protocol_probes[i].payload);
+            return protocol_probes[i].payload;
+        }
+    }
+    *length = sizeof(http_probe) - 1;
+    return http_probe;
+}
+
+static void finish_slot(BannerScan *scan, int index) {
+    GrabSlot *slot = &scan->slots[index];
+    if (timer_wheel_armed(scan->wheel, index)) {
+        timer_wheel_remove(scan->wheel, index);
+    }
+    close(slot->fd);
+    fd_budget_release(scan->fds);
+    scan->free_list[scan->free_count++] = index;
+    scan->inflight--;
+}
+
+static void rearm(BannerScan *scan, int index, int timeout_ms) {
+    if (timer_wheel_armed(scan->wheel, index)) {
+        timer_wheel_remove(scan->wheel, index);
+    }
+    timer_wheel_insert(scan->wheel, index, timeout_ms);
+}
+
+// Guardar la primera línea si es texto legible
+static void capture_banner(BannerResult *result, const uint8_t *data, ssize_t length) {
+    int written = 0;
+    while (written < length && written < BANNER_TEXT_SIZE - 1 && isprint(data[written])) {
+        result->banner[written] = (char)data[written];
+        written++;
+    }
+    result->banner[written >= 4 ? written : 0] = '\0';
+}
+
+// Devuelve 1 si la conexión terminó
+static int read_banner(BannerScan *scan, int index) {
+    GrabSlot *slot = &scan->slots[index];
+    BannerResult *result = &scan->results[slot->result];
+
+    for (;;) {
+        ssize_t length = recv(slot->fd, scan->buffer, BANNER_READ_SIZE, MSG_DONTWAIT);
+        if (length < 0 && errno == EINTR) continue;
+        if (length < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) return 0;
+        if (length <= 0) break;
+
+        if (slot->received == 0) {
+            capture_banner(result, scan->buffer, length);
+        }
+        slot->received += (int)length;
+
+        int found = service_matcher_feed(scan->matcher, &slot->matcher_state, scan->buffer, (size_t)length);
+        if (found >= 0 && (result->signature < 0 || found < result->signature)) {
+            result->signature = found;
+        }
+        if (result->signature >= 0 || slot->received >= BANNER_MAX_BYTES) break;
+    }
+
+    finish_slot(scan, index);
+    return 1;
+}
+
+static void expire_grab(int index, void *user_data) {
+    BannerScan *scan = (BannerScan*)user_data;
+    GrabSlot *slot = &scan->slots[index];
+
+    // Sin banner espontáneo: enviar la sonda de protocolo y esperar respuesta
+    if (slot->state == GRAB_PASSIVE && slot->received == 0) {
+        size_t length;
+        const char *probe = banner_probe_for_port(scan->results[slot->result].port, &length);
+        if (send(slot->fd, probe, length, MSG_NOSIGNAL | MSG_DONTWAIT) == (ssize_t)length) {
+            slot->state = GRAB_PROBED;
+            timer_wheel_insert(scan->wheel, index, scan->timeout_ms);
+            return;
+        }
+    }
+    finish_slot(scan, index);
+}
+
+// Devuelve -1 si hay que esperar a que se libere un descriptor
+static int start_grab(BannerScan *scan, const HostTable *hosts, int result_index) {
+    BannerResult *result = &scan->results[result_index];
+    struct sockaddr_storage addr;
+    socklen_t addr_len = host_table_endpoint(&hosts->hosts[result->host], result->port, &addr);
+    int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) {
+        // Sin descriptores con conexiones abiertas: reintentar cuando se cierre alguna
+        return fd_budget_exhausted(scan->fds, errno) ? -1 : 0;
+    }
+
+    int connected = connect(fd, (struct sockaddr*)&addr, addr_len) == 0;
+    if (!connected && errno != EINPROGRESS) {
+        close(fd);
+        return 0;
+    }
+
+    int index = scan->free_list[--scan->free_count];
+    GrabSlot *slot = &scan->slots[index];
+    slot->fd = fd;
+    slot->result = result_index;
+    slot->state = connected ? GRAB_PASSIVE : GRAB_CONNECTING;
+    slot->matcher_state = 0;
+    slot->received = 0;
+
+    struct epoll_event ev;
+    ev.events = connected ? EPOLLIN : EPOLLOUT;
+    ev.data.u32 = (uint32_t)index;
+    if (epoll_ctl(scan->epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+        close(fd);
+        scan->free_list[scan->free_count++] = index;
+        return 0;
+    }
+    fd_budget_acquire(scan->fds);
+    scan->inflight++;
+    timer_wheel_insert(scan->wheel, index, connected ? scan->passive_ms : scan->timeout_ms);
+    return 0;
+}
+
+static void handle_event(BannerScan *scan, int index, uint32_t events) {
+    GrabSlot *slot = &scan->slots[index];
+
+    if (slot->state == GRAB_CONNECTING) {
+        int error = 0;
+        socklen_t len = sizeof(error);
+        if (getsockopt(slot->fd, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+            finish_slot(scan, index);
+            return;
+        }
+
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = (uint32_t)index;
+        if (epoll_ctl(scan->epfd, EPOLL_CTL_MOD, slot->fd, &ev) < 0) {
+            finish_slot(scan, index);
+            return;
+        }
+        slot->state = GRAB_PASSIVE;
+        rearm(scan, index, scan->passive_ms);
+        return;
+    }
+
+    if (events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+        read_banner(scan, index);
+    }
+}
+
+int banner_grab(const HostTable *hosts, const ServiceMatcher *matcher, FdBudget *fds,
+                int max_inflight, int timeout_ms, volatile int *running,
+                BannerResult **results, int *count) {
+    if (!hosts || !matcher || !results || !count) return -1;
+
+    *results = NULL;
+    *count = 0;
+
+    // Un resultado por puerto abierto, ordenados por (host, puerto)
+    int total = 0;
+    for (int h = 0; h < hosts->count; h++) {
+        if (hosts->hosts[h].current_open) total += port_set_count(hosts->hosts[h].current_open);
+    }
+    if (total == 0) return 0;
+
+    BannerResult *entries = calloc(total, sizeof(BannerResult));
+    if (!entries) return -1;
+    int filled = 0;
+    for (int h = 0; h < hosts->count; h++) {
+        const PortSet *open_set = hosts->hosts[h].current_open;
+        if (!open_set) continue;
+        for (int port = port_set_next(open_set, 0); port >= 0; port = port_set_next(open_set, port + 1)) {
+            entries[filled].host = h;
+            entries[filled].port = port;
+            entries[filled].signature = -1;
+            filled++;
+        }
+    }
+
+    int window = scan_engine_clamp_inflight(fds, max_inflight);
+    if (window > total) window = total;
+
+    BannerScan scan;
+    scan.slots = malloc(window * sizeof(GrabSlot));
+    scan.free_list = malloc(window * sizeof(int));
+    TimerLink *links = malloc(window * sizeof(TimerLink));
+    struct epoll_event *events = malloc(window * sizeof(struct epoll_event));
+    scan.wheel = malloc(sizeof(TimerWheel));
+    scan.buffer = malloc(BANNER_READ_SIZE);
+    scan.epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (!scan.slots || !scan.free_list || !links || !events || !scan.wheel || !scan.buffer ||
+        scan.epfd < 0) {
+        free(scan.slots);
+        free(scan.free_list);
+        free(links);
+        free(events);
+        free(scan.wheel);
+        free(scan.buffer);
+        if (scan.epfd >= 0) close(scan.epfd);
+        free(entries);
+        return -1;
+    }
+
+    scan.free_count = window;
+    scan.inflight = 0;
+    scan.timeout_ms = timeout_ms;
+    scan.passive_ms = timeout_ms / 2 < BANNER_PASSIVE_MS ? timeout_ms / 2 : BANNER_PASSIVE_MS;
+    scan.matcher = matcher;
+    scan.fds = fds;
+    scan.results = entries;
+    for (int i = 0; i < window; i++) {
+        scan.free_list[i] = window - 1 - i;
+    }
+    timer_wheel_init(scan.wheel, links, window);
+
+    int next = 0;
+    int status = 0;
+    while (next < total || scan.inflight > 0) {
+        if (running && !*running) break;
+
+        while (scan.free_count > 0 && next < total && fd_budget_available(fds)) {
+            if (start_grab(&scan, hosts, next) < 0) break;
+            next++;
+        }
+        if (scan.inflight == 0) continue;
+
+        int ready = epoll_wait(scan.epfd, events, window, TIMER_WHEEL_TICK_MS);
+        if (ready < 0 && errno != EINTR) {
+            status = -1;
+            break;
+        }
+        for (int i = 0; i < ready; i++) {
+            int index = (int)events[i].data.u32;
+            if (timer_wheel_armed(scan.wheel, index)) {
+                handle_event(&scan, index, events[i].events);
+            }
+        }
+        timer_wheel_advance(scan.wheel, expire_grab, &scan);
+    }
+
+    // Cerrar cualquier conexión pendiente si el bucle terminó por interrupción o error
+    for (int i = 0; i < window; i++) {
+        if (timer_wheel_armed(scan.wheel, i)) {
+            close(scan.slots[i].fd);
+            fd_budget_release(fds);
+        }
+    }
+
+    free(scan.slots);
+    free(scan.free_list);
+    free(links);
+    free(events);
+    free(scan.wheel);
+    free(scan.buffer);
+    close(scan.epfd);
+
+    if (status != 0) {
+        free(entries);
+        return -1;
+    }
+    *results = entries;
+    *count = total;
+    return 0;
+}
+
+const BannerResult* banner_find(const BannerResult *results, int count, int host, int port) {
+    int low = 0;
+    int high = count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        const BannerResult *entry = &results[middle];
+        if (entry->host == host && entry->port == port) return entry;
+        if (entry->host < host || (entry->host == host && entry->port < port)) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return NULL;
+}
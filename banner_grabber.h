@@ -0,0 +1,33 @@
+/*
+ * Banner Grabber - Lectura de banners e identificación de servicios abiertos
+ */
+
+#ifndef BANNER_GRABBER_H
+#define BANNER_GRABBER_H
+
+#include "host_table.h"
+#include "service_matcher.h"
+#include "fd_budget.h"
+
+#define BANNER_READ_SIZE 4096       // Lectura compartida por todas las conexiones
+#define BANNER_MAX_BYTES 8192       // Bytes analizados como máximo por puerto
+#define BANNER_PASSIVE_MS 1000      // Espera al banner espontáneo antes de enviar la sonda
+#define BANNER_TEXT_SIZE 64
+
+typedef struct {
+    int host;               // Índice en la tabla de hosts
+    int port;
+    int signature;          // Firma reconocida (-1 = sin identificar)
+    char banner[BANNER_TEXT_SIZE];  // Primera línea recibida, para mostrarla
+} BannerResult;
+
+// Funciones públicas
+int banner_grab(const HostTable *hosts, const ServiceMatcher *matcher, FdBudget *fds,
+                int max_inflight, int timeout_ms, volatile int *running,
+                BannerResult **results, int *count);
+const BannerResult* banner_find(const BannerResult *results, int count, int host, int port);
+
+// Funciones auxiliares
+const char* banner_probe_for_port(int port, size_t *length);
+
+#endif
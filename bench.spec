@@ -0,0 +1,14 @@
+# Especificación del simulador para make bench-scan (test_socket --spec)
+#
+# PUERTOS      ACCIÓN   [delay=MS] [banner=TEXTO]
+# open: acepta; drop: filtrado (la sonda expira); closed: RST del kernel
+#
+# El rango completo se declara cerrado para comprobar que está libre y
+# las líneas siguientes lo sobrescriben.
+20000-24999    closed
+20000-20999    open
+21000-21039    drop
+21500          open     banner=SSH-2.0-OpenSSH_9.6\r\n
+21501          open     delay=50 banner=HTTP/1.1 200 OK\r\nServer: nginx\r\n\r\n
+21502-21599    open     delay=20
+23000-23999    open
@@ -0,0 +1,74 @@
+#!/bin/sh
+#
+# bench_scan.sh - Rendimiento de los motores de MatcomGuard contra el simulador
+#
+# Levanta test_socket --spec sobre loopback, escanea el rango de la
+# especificación con cada motor y muestra sondas/s, latencia p50/p99 por sonda
+# (--stats) y la precisión frente a los puertos que el simulador sabe abiertos.
+#
+# Uso: ./bench_scan.sh [ESPECIFICACIÓN] [MOTORES]
+#   (por defecto: bench.spec y "epoll uring blocking"; syn requiere root)
+# Variables: BENCH_ADDR (127.0.0.1), BENCH_FLAGS (opciones extra del escáner)
+
+SPEC=${1:-bench.spec}
+ENGINES=${2:-"epoll uring blocking"}
+ADDR=${BENCH_ADDR:-127.0.0.1}
+DIR=$(mktemp -d /tmp/bench_scan.XXXXXX) || exit 1
+
+cleanup() {
+    [ -n "$SIM_PID" ] && kill "$SIM_PID" 2>/dev/null && wait "$SIM_PID" 2>/dev/null
+    rm -rf "$DIR"
+}
+trap cleanup EXIT INT TERM
+
+# Rango a escanear: del menor al mayor puerto declarado en la especificación
+PORTS=$(awk '!/^[ \t]*(#|$)/ { n = split($1, r, "-"); if (min == "" || r[1] + 0 < min) min = r[1] + 0;
+             if (r[n] + 0 > max) max = r[n] + 0 } END { if (min != "") print min "-" max }' "$SPEC")
+if [ -z "$PORTS" ]; then
+    echo "❌ Especificación vacía o inexistente: $SPEC"
+    exit 1
+fi
+./test_socket --spec "$SPEC" --expect > "$DIR/expected" || exit 1
+TOTAL=$(echo "$PORTS" | awk -F- '{ print $2 - $1 + 1 }')
+
+./test_socket --spec "$SPEC" --bind "$ADDR" --duration 3600 > "$DIR/simulator" 2>&1 &
+SIM_PID=$!
+for i in 1 2 3 4 5 6 7 8 9 10; do
+    grep -q "Simulando" "$DIR/simulator" && break
+    kill -0 "$SIM_PID" 2>/dev/null || break
+    sleep 0.2
+done
+if ! grep -q "Simulando" "$DIR/simulator"; then
+    cat "$DIR/simulator"
+    echo "❌ El simulador no arrancó"
+    exit 1
+fi
+
+echo "📊 $(sed -n 's/^\[INFO\] //p' "$DIR/simulator" | head -1)"
+echo "   Rango $PORTS ($TOTAL puertos, $(wc -l < "$DIR/expected") abiertos esperados)"
+printf "%-10s %12s %10s %10s %10s %8s %8s\n" "MOTOR" "SONDAS/S" "P50" "P99" "PRECISIÓN" "FALSOS+" "FALSOS-"
+
+STATUS=0
+for ENGINE in $ENGINES; do
+    # shellcheck disable=SC2086
+    ./matcomguard --target "$ADDR" --scan-ports "$PORTS" --engine "$ENGINE" --no-netlink --stats \
+        $BENCH_FLAGS > "$DIR/$ENGINE.out" 2>&1
+    LINE=$(grep "Rendimiento:" "$DIR/$ENGINE.out")
+    if [ -z "$LINE" ] || grep -q "no disponible" "$DIR/$ENGINE.out"; then
+        printf "%-10s %s\n" "$ENGINE" "no disponible (kernel o privilegios)"
+        continue
+    fi
+
+    grep -o "Puerto [0-9]*/tcp" "$DIR/$ENGINE.out" | tr -dc '0-9\n' | sort -u > "$DIR/$ENGINE.found"
+    sort -u "$DIR/expected" > "$DIR/expected.sorted"
+    FP=$(comm -13 "$DIR/expected.sorted" "$DIR/$ENGINE.found" | wc -l)
+    FN=$(comm -23 "$DIR/expected.sorted" "$DIR/$ENGINE.found" | wc -l)
+    RATE=$(echo "$LINE" | sed -n 's/.*(\([0-9]*\) sondas\/s).*/\1/p')
+    P50=$(echo "$LINE" | sed -n 's/.*p50 \([0-9]*us\).*/\1/p')
+    P99=$(echo "$LINE" | sed -n 's/.*p99 \([0-9]*us\).*/\1/p')
+    ACCURACY=$(awk -v t="$TOTAL" -v e="$((FP + FN))" 'BEGIN { printf "%.2f%%", (t - e) * 100 / t }')
+    printf "%-10s %12s %10s %10s %10s %8d %8d\n" "$ENGINE" "$RATE" "$P50" "$P99" "$ACCURACY" "$FP" "$FN"
+    [ "$((FP + FN))" -eq 0 ] || STATUS=1
+done
+
+exit $STATUS
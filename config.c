@@ -0,0 +1,109 @@
+/*
+ * Config - Implementación del lector de matcomguard.conf
+ *
+ * El archivo mezcla líneas CLAVE=VALOR con líneas PUERTO:DESCRIPCION. Las
+ * segundas pertenecen a la sección de puertos sospechosos o a la de servicios
+ * según el último encabezado visto ("# PUERTOS PERSONALIZADOS SOSPECHOSOS" o
+ * "# SERVICIOS PERSONALIZADOS").
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include "config.h"
+#include "alert_manager.h"
+
+static char* trim(char *str) {
+    while (isspace((unsigned char)*str)) str++;
+    char *end = str + strlen(str);
+    while (end > str && isspace((unsigned char)end[-1])) end--;
+    *end = '\0';
+    return str;
+}
+
+static int parse_level(const char *str) {
+    if (strcmp(str, "ALTA") == 0) return ALERT_HIGH;
+    if (strcmp(str, "MEDIA") == 0) return ALERT_MEDIUM;
+    if (strcmp(str, "BAJA") == 0) return ALERT_LOW;
+    return -1;
+}
+
+static void parse_key_value(const char *key, const char *value, MatcomConfig *config) {
+    if (strcmp(key, "DEFAULT_TIMEOUT") == 0) {
+        config->default_timeout = atoi(value);
+    } else if (strcmp(key, "DEFAULT_INTERVAL") == 0) {
+        config->default_interval = atoi(value);
+    } else if (strcmp(key, "USE_RANDOM_SCAN_ORDER") == 0) {
+        config->random_order = atoi(value) != 0;
+    }
+}
+
+const char* config_find_default_path(void) {
+    if (access(CONFIG_DEFAULT_PATH, R_OK) == 0) return CONFIG_DEFAULT_PATH;
+    if (access(CONFIG_SYSTEM_PATH, R_OK) == 0) return CONFIG_SYSTEM_PATH;
+    return NULL;
+}
+
+int config_load(const char *path, MatcomConfig *config, ConfigPortCallback callback, void *user_data) {
+    if (!path || !config) return -1;
+
+    config->default_timeout = -1;
+    config->default_interval = -1;
+    config->random_order = -1;
+
+    FILE *file = fopen(path, "r");
+    if (!file) return -1;
+
+    ConfigSection section = CONFIG_SECTION_SUSPICIOUS;
+    char line[512];
+    while (fgets(line, sizeof(line), file)) {
+        char *text = trim(line);
+
+        if (*text == '#') {
+            if (strstr(text, "PUERTOS PERSONALIZADOS SOSPECHOSOS")) {
+                section = CONFIG_SECTION_SUSPICIOUS;
+            } else if (strstr(text, "SERVICIOS PERSONALIZADOS")) {
+                section = CONFIG_SECTION_SERVICES;
+            }
+            continue;
+        }
+
+        // Quitar comentarios al final de la línea
+        char *comment = strchr(text, '#');
+        if (comment) *comment = '\0';
+        text = trim(text);
+        if (*text == '\0') continue;
+
+        char *equals = strchr(text, '=');
+        if (equals) {
+            *equals = '\0';
+            parse_key_value(trim(text), trim(equals + 1), config);
+            continue;
+        }
+
+        char *colon = strchr(text, ':');
+        if (!colon || !isdigit((unsigned char)*text)) continue;
+        *colon = '\0';
+        int port = atoi(text);
+        if (port <= 0 || port > 65535) continue;
+
+        // Nivel opcional al final: PUERTO:DESCRIPCION:ALTA
+        char *description = trim(colon + 1);
+        int severity = -1;
+        char *last_colon = strrchr(description, ':');
+        if (last_colon && (severity = parse_level(trim(last_colon + 1))) >= 0) {
+            *last_colon = '\0';
+            description = trim(description);
+        }
+        if (*description == '\0') continue;
+
+        if (callback) {
+            callback(port, description, section, severity, user_data);
+        }
+    }
+
+    fclose(file);
+    return 0;
+}
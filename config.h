@@ -0,0 +1,30 @@
+/*
+ * Config - Lectura de matcomguard.conf
+ */
+
+#ifndef CONFIG_H
+#define CONFIG_H
+
+#define CONFIG_DEFAULT_PATH "matcomguard.conf"
+#define CONFIG_SYSTEM_PATH "/etc/matcomguard.conf"
+
+typedef enum {
+    CONFIG_SECTION_SUSPICIOUS,
+    CONFIG_SECTION_SERVICES
+} ConfigSection;
+
+// Entrada PUERTO:DESCRIPCION[:NIVEL]; severity = -1 si no se indicó nivel
+typedef void (*ConfigPortCallback)(int port, const char *description, ConfigSection section,
+                                   int severity, void *user_data);
+
+typedef struct {
+    int default_timeout;    // -1 si el archivo no lo define
+    int default_interval;   // -1 si el archivo no lo define
+    int random_order;       // USE_RANDOM_SCAN_ORDER; -1 si el archivo no lo define
+} MatcomConfig;
+
+// Funciones públicas
+int config_load(const char *path, MatcomConfig *config, ConfigPortCallback callback, void *user_data);
+const char* config_find_default_path(void);
+
+#endif
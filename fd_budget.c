@@ -0,0 +1,108 @@
+/*
+ * FD Budget - Implementación del presupuesto de descriptores
+ *
+ * Con miles de connect() en vuelo el límite real de concurrencia es
+ * RLIMIT_NOFILE. Al iniciar se lee el límite (y, si la ventana pedida no
+ * cabe, se sube el blando hasta el duro), se descuentan los descriptores ya
+ * abiertos y una reserva para reportes y alertas, y el resto queda como
+ * capacidad para sockets de sondeo.
+ *
+ * Los motores piden turno antes de crear cada socket: sin presupuesto la
+ * sonda espera en la cola en lugar de fallar. Si aun así socket() devuelve
+ * EMFILE/ENFILE (otro componente abrió archivos, límite del sistema), la
+ * capacidad se ajusta a los sockets en vuelo y la sonda se reencola; sólo
+ * cuando no queda ninguno por liberarse se informa como error local, nunca
+ * como puerto cerrado. El ajuste dura un escaneo: fd_budget_reset devuelve
+ * la capacidad calculada al iniciar, porque la escasez suele ser pasajera.
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include <dirent.h>
+#include <sys/resource.h>
+#include "fd_budget.h"
+
+int fd_budget_count_open(void) {
+    DIR *dir = opendir("/proc/self/fd");
+    if (!dir) return 3;     // stdin, stdout y stderr
+
+    int count = 0;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] != '.') count++;
+    }
+    closedir(dir);
+    return count > 1 ? count - 1 : 1;   // Sin contar el del propio opendir
+}
+
+int fd_budget_init(FdBudget *budget, int wanted) {
+    if (!budget) return -1;
+
+    struct rlimit limit;
+    budget->baseline = fd_budget_count_open();
+    budget->in_use = 0;
+    budget->peak = 0;
+    budget->raised = 0;
+    budget->exhausted = 0;
+
+    if (getrlimit(RLIMIT_NOFILE, &limit) != 0) {
+        budget->limit = 1024;
+    } else {
+        // Subir el límite blando sólo si la ventana pedida no cabe
+        rlim_t needed = (rlim_t)wanted + budget->baseline + FD_BUDGET_RESERVE;
+        if (limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur < needed) {
+            struct rlimit raised = limit;
+            raised.rlim_cur = limit.rlim_max == RLIM_INFINITY || limit.rlim_max > needed
+                              ? needed : limit.rlim_max;
+            if (raised.rlim_cur > limit.rlim_cur && setrlimit(RLIMIT_NOFILE, &raised) == 0) {
+                limit = raised;
+                budget->raised = 1;
+            }
+        }
+        budget->limit = limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > FD_BUDGET_NO_LIMIT
+                        ? FD_BUDGET_NO_LIMIT : (int)limit.rlim_cur;
+    }
+
+    fd_budget_reset(budget);
+    return 0;
+}
+
+// Al empezar cada escaneo: capacidad completa y contador de agotamientos a cero
+void fd_budget_reset(FdBudget *budget) {
+    if (!budget) return;
+
+    budget->capacity = budget->limit - budget->baseline - FD_BUDGET_RESERVE;
+    if (budget->capacity < 1) budget->capacity = 1;
+    budget->exhausted = 0;
+}
+
+int fd_budget_window(const FdBudget *budget, int requested) {
+    if (budget && requested > budget->capacity) return budget->capacity;
+    return requested;
+}
+
+int fd_budget_available(const FdBudget *budget) {
+    return !budget || budget->in_use < budget->capacity;
+}
+
+void fd_budget_acquire(FdBudget *budget) {
+    if (!budget) return;
+    budget->in_use++;
+    if (budget->in_use > budget->peak) budget->peak = budget->in_use;
+}
+
+void fd_budget_release(FdBudget *budget) {
+    if (budget && budget->in_use > 0) budget->in_use--;
+}
+
+int fd_budget_exhausted(FdBudget *budget, int error) {
+    if (!budget || budget->in_use == 0) return 0;
+    if (error != EMFILE && error != ENFILE && error != ENOBUFS && error != ENOMEM) return 0;
+
+    // El límite real está por debajo del calculado: ajustarlo a lo que hay en vuelo
+    if (error == EMFILE || error == ENFILE) {
+        budget->capacity = budget->in_use;
+    }
+    budget->exhausted++;
+    return 1;
+}
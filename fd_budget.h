@@ -0,0 +1,33 @@
+/*
+ * FD Budget - Presupuesto de descriptores de archivo para los sockets de sondeo
+ */
+
+#ifndef FD_BUDGET_H
+#define FD_BUDGET_H
+
+#define FD_BUDGET_RESERVE 32        // Reportes, alertas, configuración, epoll, netlink...
+#define FD_BUDGET_NO_LIMIT (1 << 20)    // Tope usado si RLIMIT_NOFILE es infinito
+
+typedef struct {
+    int limit;              // RLIMIT_NOFILE efectivo (límite blando)
+    int baseline;           // Descriptores ya abiertos al iniciar
+    int capacity;           // Sockets de sondeo simultáneos permitidos
+    int in_use;
+    int peak;
+    int raised;             // Se subió el límite blando hacia el duro
+    unsigned long long exhausted;   // socket() sin descriptores en este escaneo: sonda reencolada
+} FdBudget;
+
+// Funciones públicas
+int fd_budget_init(FdBudget *budget, int wanted);
+void fd_budget_reset(FdBudget *budget);
+int fd_budget_window(const FdBudget *budget, int requested);
+int fd_budget_available(const FdBudget *budget);
+void fd_budget_acquire(FdBudget *budget);
+void fd_budget_release(FdBudget *budget);
+int fd_budget_exhausted(FdBudget *budget, int error);
+
+// Funciones auxiliares
+int fd_budget_count_open(void);
+
+#endif
@@ -0,0 +1,421 @@
+/*
+ * Host Table - Implementación de la tabla de objetivos
+ *
+ * Formatos aceptados en --target, separados por comas:
+ *   192.168.1.10            dirección individual
+ *   192.168.1.0/24          bloque CIDR (todas las direcciones del bloque)
+ *   10.0.0.1-10.0.0.50      rango completo
+ *   10.0.0.1-50             rango sobre el último octeto
+ *   2001:db8::10, [::1]     dirección IPv6 (también bloques de /104 en adelante)
+ *   servidor.example.com    nombre DNS: una entrada por cada dirección A/AAAA
+ *
+ * Cada objetivo se parsea o se resuelve una sola vez a un sockaddr_storage
+ * que los motores usan tal cual, sin volver a interpretar texto por sonda.
+ * Un nombre con registros A y AAAA se escanea en ambas familias (doble pila)
+ * como hosts separados. En modo continuo los nombres se vuelven a resolver
+ * cuando vence resolve_ttl: las direcciones que siguen presentes conservan
+ * su estado y las nuevas ocupan el lugar de las que desaparecieron. La tabla
+ * no escribe nada durante la renovación: anota los cambios en changes para
+ * que el escáner los comunique a sus suscriptores.
+ *
+ * Los mapas de bits de puertos de cada host se reservan sólo cuando tiene
+ * algún puerto abierto, así que un /16 mayormente vacío ocupa unos pocos MB.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <netdb.h>
+#include <arpa/inet.h>
+#include "host_table.h"
+
+HostTable* host_table_create(void) {
+    HostTable *table = malloc(sizeof(HostTable));
+    if (!table) return NULL;
+
+    table->hosts = NULL;
+    table->count = 0;
+    table->capacity = 0;
+    table->resolve_ttl = HOST_TABLE_RESOLVE_TTL;
+    table->changes = NULL;
+    table->change_count = 0;
+    table->change_capacity = 0;
+    return table;
+}
+
+void host_table_destroy(HostTable *table) {
+    if (!table) return;
+
+    for (int i = 0; i < table->count; i++) {
+        free(table->hosts[i].previous_open);
+        free(table->hosts[i].current_open);
+        free(table->hosts[i].name);
+    }
+    free(table->hosts);
+    free(table->changes);
+    free(table);
+}
+
+int host_table_add(HostTable *table, const struct sockaddr *addr, socklen_t addr_len, const char *name) {
+    if (table->count >= HOST_TABLE_MAX_HOSTS || addr_len > sizeof(struct sockaddr_storage)) return -1;
+
+    if (table->count >= table->capacity) {
+        int new_capacity = table->capacity == 0 ? 16 : table->capacity * 2;
+        ScanHost *grown = realloc(table->hosts, new_capacity * sizeof(ScanHost));
+        if (!grown) return -1;
+        table->hosts = grown;
+        table->capacity = new_capacity;
+    }
+
+    ScanHost *host = &table->hosts[table->count];
+    memset(host, 0, sizeof(*host));
+    memcpy(&host->addr, addr, addr_len);
+    host->addr_len = addr_len;
+    if (name) {
+        host->name = strdup(name);
+        if (!host->name) return -1;
+        host->resolved_at = time(NULL);
+    }
+    table->count++;
+    return 0;
+}
+
+static int add_ipv4(HostTable *table, unsigned int ip) {
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(ip);
+    return host_table_add(table, (const struct sockaddr*)&addr, sizeof(addr), NULL);
+}
+
+static int add_range(HostTable *table, unsigned int first, unsigned int last) {
+    if (first > last) return -1;
+    if ((unsigned long long)last - first + 1 + table->count > HOST_TABLE_MAX_HOSTS) return -1;
+
+    for (unsigned long long ip = first; ip <= last; ip++) {
+        if (add_ipv4(table, (unsigned int)ip) != 0) return -1;
+    }
+    return 0;
+}
+
+// Bloque IPv6: como máximo 2^24 direcciones, así que sólo varía la última palabra
+static int add_ipv6_block(HostTable *table, const struct in6_addr *base, int prefix) {
+    if (prefix < 128 - 24 || prefix > 128) return -1;
+
+    unsigned int low;
+    memcpy(&low, &base->s6_addr[12], sizeof(low));
+    low = ntohl(low);
+    unsigned int mask = prefix == 128 ? ~0U : ~0U << (128 - prefix);
+    unsigned long long first = low & mask;
+    unsigned long long last = low | ~mask;
+    if (last - first + 1 + table->count > HOST_TABLE_MAX_HOSTS) return -1;
+
+    struct sockaddr_in6 addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin6_family = AF_INET6;
+    addr.sin6_addr = *base;
+    for (unsigned long long word = first; word <= last; word++) {
+        unsigned int value = htonl((unsigned int)word);
+        memcpy(&addr.sin6_addr.s6_addr[12], &value, sizeof(value));
+        if (host_table_add(table, (const struct sockaddr*)&addr, sizeof(addr), NULL) != 0) return -1;
+    }
+    return 0;
+}
+
+static int same_address(const struct sockaddr_storage *a, const struct sockaddr_storage *b) {
+    if (a->ss_family != b->ss_family) return 0;
+    if (a->ss_family == AF_INET) {
+        return ((const struct sockaddr_in*)a)->sin_addr.s_addr == ((const struct sockaddr_in*)b)->sin_addr.s_addr;
+    }
+    const struct sockaddr_in6 *a6 = (const struct sockaddr_in6*)a;
+    const struct sockaddr_in6 *b6 = (const struct sockaddr_in6*)b;
+    return memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(a6->sin6_addr)) == 0 &&
+           a6->sin6_scope_id == b6->sin6_scope_id;
+}
+
+// Direcciones distintas de un nombre (A y AAAA); devuelve cuántas o -1 con el código en *error
+static int lookup_name(const char *name, struct sockaddr_storage *found, socklen_t *lengths, int max,
+                       int *error) {
+    struct addrinfo hints;
+    struct addrinfo *result;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    *error = getaddrinfo(name, NULL, &hints, &result);
+    if (*error != 0) return -1;
+
+    int count = 0;
+    for (struct addrinfo *ai = result; ai && count < max; ai = ai->ai_next) {
+        if ((ai->ai_family != AF_INET && ai->ai_family != AF_INET6) ||
+            ai->ai_addrlen > sizeof(struct sockaddr_storage)) {
+            continue;
+        }
+        memset(&found[count], 0, sizeof(found[count]));
+        memcpy(&found[count], ai->ai_addr, ai->ai_addrlen);
+
+        int duplicate = 0;
+        for (int i = 0; i < count && !duplicate; i++) {
+            duplicate = same_address(&found[i], &found[count]);
+        }
+        if (!duplicate) {
+            lengths[count++] = ai->ai_addrlen;
+        }
+    }
+    freeaddrinfo(result);
+    if (count == 0) {
+        *error = EAI_NONAME;
+        return -1;
+    }
+    return count;
+}
+
+static void report_lookup_error(const char *name, int error) {
+    fprintf(stderr, "[ERROR] No se pudo resolver '%s': %s\n", name, gai_strerror(error));
+}
+
+static int parse_item(HostTable *table, char *item) {
+    struct in_addr addr;
+    struct in6_addr addr6;
+
+    // IPv6, opcionalmente entre corchetes y con prefijo
+    if (strchr(item, ':')) {
+        if (*item == '[') {
+            item++;
+            char *close = strchr(item, ']');
+            if (!close) return -1;
+            memmove(close, close + 1, strlen(close + 1) + 1);
+        }
+        char *slash = strchr(item, '/');
+        int prefix = 128;
+        if (slash) {
+            *slash = '\0';
+            prefix = atoi(slash + 1);
+        }
+        if (inet_pton(AF_INET6, item, &addr6) <= 0) return -1;
+        return add_ipv6_block(table, &addr6, prefix);
+    }
+
+    char *slash = strchr(item, '/');
+    if (slash) {
+        // Bloque CIDR
+        *slash = '\0';
+        int prefix = atoi(slash + 1);
+        if (prefix < 0 || prefix > 32 || inet_pton(AF_INET, item, &addr) <= 0) return -1;
+
+        unsigned int base = ntohl(addr.s_addr);
+        unsigned int mask = prefix == 0 ? 0 : ~0U << (32 - prefix);
+        return add_range(table, base & mask, (base & mask) | ~mask);
+    }
+
+    // Rango completo o sobre el último octeto (un nombre DNS también puede llevar '-')
+    char *dash = strchr(item, '-');
+    if (dash) {
+        *dash = '\0';
+        if (inet_pton(AF_INET, item, &addr) > 0) {
+            unsigned int first = ntohl(addr.s_addr);
+            unsigned int last;
+
+            struct in_addr end_addr;
+            if (inet_pton(AF_INET, dash + 1, &end_addr) > 0) {
+                last = ntohl(end_addr.s_addr);
+            } else {
+                int octet = atoi(dash + 1);
+                if (octet < 0 || octet > 255) return -1;
+                last = (first & 0xffffff00U) | (unsigned int)octet;
+            }
+            return add_range(table, first, last);
+        }
+        *dash = '-';
+    }
+
+    if (inet_pton(AF_INET, item, &addr) > 0) {
+        return add_ipv4(table, ntohl(addr.s_addr));
+    }
+
+    // Nombre DNS: una entrada por dirección
+    struct sockaddr_storage found[HOST_TABLE_MAX_PER_NAME];
+    socklen_t lengths[HOST_TABLE_MAX_PER_NAME];
+    int error;
+    int count = lookup_name(item, found, lengths, HOST_TABLE_MAX_PER_NAME, &error);
+    if (count < 0) {
+        report_lookup_error(item, error);
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        if (host_table_add(table, (const struct sockaddr*)&found[i], lengths[i], item) != 0) return -1;
+    }
+    return 0;
+}
+
+int host_table_parse(HostTable *table, const char *spec) {
+    if (!table || !spec) return -1;
+
+    char *copy = strdup(spec);
+    if (!copy) return -1;
+
+    int status = 0;
+    char *saveptr = NULL;
+    for (char *item = strtok_r(copy, ",", &saveptr); item; item = strtok_r(NULL, ",", &saveptr)) {
+        while (*item == ' ') item++;
+        if (*item == '\0') continue;
+        if (parse_item(table, item) != 0) {
+            status = -1;
+            break;
+        }
+    }
+
+    free(copy);
+    return status == 0 && table->count > 0 ? 0 : -1;
+}
+
+static HostChange* record_change(HostTable *table, HostChangeKind kind, int host) {
+    if (table->change_count >= table->change_capacity) {
+        int new_capacity = table->change_capacity == 0 ? 8 : table->change_capacity * 2;
+        HostChange *grown = realloc(table->changes, new_capacity * sizeof(HostChange));
+        if (!grown) return NULL;
+        table->changes = grown;
+        table->change_capacity = new_capacity;
+    }
+
+    HostChange *change = &table->changes[table->change_count++];
+    change->kind = kind;
+    change->host = host;
+    change->error = 0;
+    change->previous[0] = '\0';
+    return change;
+}
+
+// Nueva dirección en una entrada existente: el estado anterior era de otra máquina
+static void replace_address(HostTable *table, int index, const struct sockaddr_storage *addr,
+                            socklen_t addr_len) {
+    ScanHost *host = &table->hosts[index];
+    HostChange *change = record_change(table, HOST_CHANGE_REPLACED, index);
+    if (change) host_table_address(host, change->previous, sizeof(change->previous));
+
+    host->addr = *addr;
+    host->addr_len = addr_len;
+    free(host->previous_open);
+    free(host->current_open);
+    host->previous_open = NULL;
+    host->current_open = NULL;
+    rtt_estimator_init(&host->rtt);
+}
+
+int host_table_refresh(HostTable *table, time_t now) {
+    if (!table || table->resolve_ttl <= 0) return 0;
+
+    int changed = 0;
+    int original_count = table->count;
+    table->change_count = 0;
+    for (int i = 0; i < original_count; i++) {
+        // Se procesa el grupo de cada nombre desde su primera entrada vencida
+        if (!table->hosts[i].name || now - table->hosts[i].resolved_at < table->resolve_ttl) continue;
+
+        const char *name = table->hosts[i].name;
+        int group[HOST_TABLE_MAX_PER_NAME];
+        int group_count = 0;
+        for (int j = i; j < original_count && group_count < HOST_TABLE_MAX_PER_NAME; j++) {
+            if (table->hosts[j].name && strcmp(table->hosts[j].name, name) == 0) {
+                group[group_count++] = j;
+                table->hosts[j].resolved_at = now;
+            }
+        }
+
+        // Si el nombre deja de resolver se conservan las direcciones conocidas
+        struct sockaddr_storage found[HOST_TABLE_MAX_PER_NAME];
+        socklen_t lengths[HOST_TABLE_MAX_PER_NAME];
+        int error;
+        int found_count = lookup_name(name, found, lengths, HOST_TABLE_MAX_PER_NAME, &error);
+        if (found_count < 0) {
+            HostChange *change = record_change(table, HOST_CHANGE_UNRESOLVED, i);
+            if (change) change->error = error;
+            continue;
+        }
+
+        int used[HOST_TABLE_MAX_PER_NAME] = {0};
+        int stale[HOST_TABLE_MAX_PER_NAME];
+        int stale_count = 0;
+        for (int g = 0; g < group_count; g++) {
+            int kept = 0;
+            for (int k = 0; k < found_count && !kept; k++) {
+                if (!used[k] && same_address(&table->hosts[group[g]].addr, &found[k])) {
+                    used[k] = 1;
+                    kept = 1;
+                }
+            }
+            if (!kept) stale[stale_count++] = group[g];
+        }
+
+        // Direcciones nuevas: primero en el lugar de las que desaparecieron
+        int next_stale = 0;
+        for (int k = 0; k < found_count; k++) {
+            if (used[k]) continue;
+            if (next_stale < stale_count) {
+                replace_address(table, stale[next_stale++], &found[k], lengths[k]);
+                changed++;
+            } else if (host_table_add(table, (const struct sockaddr*)&found[k], lengths[k],
+                                      table->hosts[i].name) == 0) {
+                record_change(table, HOST_CHANGE_ADDED, table->count - 1);
+                changed++;
+            }
+        }
+    }
+    return changed;
+}
+
+socklen_t host_table_endpoint(const ScanHost *host, int port, struct sockaddr_storage *out) {
+    *out = host->addr;
+    if (out->ss_family == AF_INET6) {
+        ((struct sockaddr_in6*)out)->sin6_port = htons((uint16_t)port);
+    } else {
+        ((struct sockaddr_in*)out)->sin_port = htons((uint16_t)port);
+    }
+    return host->addr_len;
+}
+
+int host_table_resolve(const char *target, struct sockaddr_storage *out, socklen_t *out_len) {
+    struct sockaddr_in *addr4 = (struct sockaddr_in*)out;
+    struct sockaddr_in6 *addr6 = (struct sockaddr_in6*)out;
+
+    // Literales sin pasar por el resolver
+    memset(out, 0, sizeof(*out));
+    if (inet_pton(AF_INET, target, &addr4->sin_addr) > 0) {
+        addr4->sin_family = AF_INET;
+        *out_len = sizeof(*addr4);
+        return 0;
+    }
+    if (inet_pton(AF_INET6, target, &addr6->sin6_addr) > 0) {
+        addr6->sin6_family = AF_INET6;
+        *out_len = sizeof(*addr6);
+        return 0;
+    }
+
+    socklen_t length;
+    int error;
+    if (lookup_name(target, out, &length, 1, &error) < 0) {
+        report_lookup_error(target, error);
+        return -1;
+    }
+    *out_len = length;
+    return 0;
+}
+
+const char* host_table_address(const ScanHost *host, char *buffer, size_t size) {
+    const void *raw = host->addr.ss_family == AF_INET6
+                    ? (const void*)&((const struct sockaddr_in6*)&host->addr)->sin6_addr
+                    : (const void*)&((const struct sockaddr_in*)&host->addr)->sin_addr;
+    if (!inet_ntop(host->addr.ss_family, raw, buffer, (socklen_t)size)) {
+        snprintf(buffer, size, "?");
+    }
+    return buffer;
+}
+
+const char* host_table_format(const ScanHost *host, char *buffer, size_t size) {
+    if (!host->name) return host_table_address(host, buffer, size);
+
+    char address[INET6_ADDRSTRLEN];
+    host_table_address(host, address, sizeof(address));
+    snprintf(buffer, size, "%s (%s)", host->name, address);
+    return buffer;
+}
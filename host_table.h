@@ -0,0 +1,66 @@
+/*
+ * Host Table - Tabla compacta de objetivos (listas, CIDR, rangos, IPv6 y nombres)
+ */
+
+#ifndef HOST_TABLE_H
+#define HOST_TABLE_H
+
+#include <time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "port_set.h"
+#include "rtt_estimator.h"
+
+#define HOST_TABLE_MAX_HOSTS (1 << 24)
+#define HOST_TABLE_MAX_PER_NAME 16      // Direcciones por nombre DNS como máximo
+#define HOST_TABLE_RESOLVE_TTL 300      // Segundos antes de volver a resolver un nombre
+#define HOST_TABLE_FORMAT_SIZE 320      // Nombre DNS + dirección IPv6
+
+typedef struct {
+    struct sockaddr_storage addr;   // Dirección ya resuelta (puerto en 0)
+    socklen_t addr_len;
+    char *name;                 // Nombre DNS del que salió (NULL si se indicó la dirección)
+    time_t resolved_at;         // Última resolución del nombre
+    PortSet *previous_open;     // Estado del último escaneo (NULL = ninguno abierto)
+    PortSet *current_open;      // Resultados del escaneo en curso (NULL = ninguno)
+    RttEstimator rtt;           // RTT medido; se conserva entre escaneos
+    int unanswered;             // Puertos UDP sin respuesta o filtrados (open|filtered) en el último escaneo
+} ScanHost;
+
+typedef enum {
+    HOST_CHANGE_REPLACED,       // La entrada pasó a otra dirección; su estado se descartó
+    HOST_CHANGE_ADDED,          // Dirección nueva del nombre, añadida al final de la tabla
+    HOST_CHANGE_UNRESOLVED      // El nombre dejó de resolver; se conservan sus direcciones
+} HostChangeKind;
+
+typedef struct {
+    HostChangeKind kind;
+    int host;                               // Índice de la entrada afectada
+    int error;                              // Código de getaddrinfo (HOST_CHANGE_UNRESOLVED)
+    char previous[HOST_TABLE_FORMAT_SIZE];  // Dirección anterior (HOST_CHANGE_REPLACED)
+} HostChange;
+
+typedef struct {
+    ScanHost *hosts;
+    int count;
+    int capacity;
+    int resolve_ttl;            // Segundos de validez de una resolución (0 = no renovar)
+    HostChange *changes;        // Cambios de la última llamada a host_table_refresh
+    int change_count;
+    int change_capacity;
+} HostTable;
+
+// Funciones públicas
+HostTable* host_table_create(void);
+void host_table_destroy(HostTable *table);
+int host_table_parse(HostTable *table, const char *spec);
+int host_table_add(HostTable *table, const struct sockaddr *addr, socklen_t addr_len, const char *name);
+int host_table_refresh(HostTable *table, time_t now);
+const char* host_table_format(const ScanHost *host, char *buffer, size_t size);
+
+// Funciones auxiliares
+socklen_t host_table_endpoint(const ScanHost *host, int port, struct sockaddr_storage *out);
+int host_table_resolve(const char *target, struct sockaddr_storage *out, socklen_t *out_len);
+const char* host_table_address(const ScanHost *host, char *buffer, size_t size);
+
+#endif
@@ -0,0 +1,292 @@
+/*
+ * Listener Diag - Implementación de la enumeración local de puertos
+ *
+ * Cuando el objetivo es una dirección de la propia máquina no hace falta
+ * completar un handshake por puerto: el kernel entrega todos los sockets TCP
+ * y TCP6 en estado LISTEN en un único volcado NETLINK_SOCK_DIAG por familia.
+ * En UDP no hay LISTEN: un puerto está abierto si hay un socket atado sin
+ * conectar, que sock_diag muestra en estado CLOSE sin puerto remoto.
+ * El inodo de cada socket permite además identificar el proceso dueño
+ * recorriendo /proc/<pid>/fd. Para los sockets IPv6 en LISTEN o CLOSE el
+ * kernel añade siempre el atributo INET_DIAG_SKV6ONLY (no cabe en idiag_ext),
+ * con el que un listener en "::" con IPV6_V6ONLY no cuenta para IPv4.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <dirent.h>
+#include <ifaddrs.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+#include <linux/netlink.h>
+#include <linux/sock_diag.h>
+#include <linux/inet_diag.h>
+#include <linux/rtnetlink.h>
+#include "listener_diag.h"
+
+#define TCP_LISTEN_STATE 10
+#define UDP_UNCONNECTED_STATE 7     // TCP_CLOSE
+#define DIAG_BUFFER_SIZE 32768
+
+int listener_diag_is_local(const struct sockaddr *addr) {
+    struct ifaddrs *interfaces;
+    int local = 0;
+
+    if (addr->sa_family == AF_INET) {
+        // Todo 127.0.0.0/8 es loopback
+        const struct in_addr *in = &((const struct sockaddr_in*)addr)->sin_addr;
+        if ((ntohl(in->s_addr) >> 24) == 127) return 1;
+    } else if (addr->sa_family == AF_INET6) {
+        if (IN6_IS_ADDR_LOOPBACK(&((const struct sockaddr_in6*)addr)->sin6_addr)) return 1;
+    } else {
+        return 0;
+    }
+
+    if (getifaddrs(&interfaces) != 0) return 0;
+    for (struct ifaddrs *ifa = interfaces; ifa && !local; ifa = ifa->ifa_next) {
+        if (!ifa->ifa_addr || ifa->ifa_addr->sa_family != addr->sa_family) continue;
+        if (addr->sa_family == AF_INET) {
+            local = ((const struct sockaddr_in*)ifa->ifa_addr)->sin_addr.s_addr ==
+                    ((const struct sockaddr_in*)addr)->sin_addr.s_addr;
+        } else {
+            local = IN6_ARE_ADDR_EQUAL(&((const struct sockaddr_in6*)ifa->ifa_addr)->sin6_addr,
+                                       &((const struct sockaddr_in6*)addr)->sin6_addr);
+        }
+    }
+    freeifaddrs(interfaces);
+    return local;
+}
+
+// Indica si un listener atado a bound_addr acepta conexiones hacia target
+static int listener_reaches_target(int family, const unsigned int *bound_addr, int v6only,
+                                   const struct sockaddr *target) {
+    if (target->sa_family == AF_INET6) {
+        // Un objetivo IPv6 sólo llega a listeners IPv6 en "::" o en su propia dirección
+        const unsigned int *address = (const unsigned int*)&((const struct sockaddr_in6*)target)->sin6_addr;
+        if (family != AF_INET6) return 0;
+        if ((bound_addr[0] | bound_addr[1] | bound_addr[2] | bound_addr[3]) == 0) return 1;
+        return memcmp(bound_addr, address, sizeof(struct in6_addr)) == 0;
+    }
+
+    in_addr_t address = ((const struct sockaddr_in*)target)->sin_addr.s_addr;
+    if (family == AF_INET) {
+        return bound_addr[0] == INADDR_ANY || bound_addr[0] == address;
+    }
+
+    // AF_INET6: "::" acepta IPv4 salvo con IPV6_V6ONLY; también ::ffff:a.b.c.d
+    if (bound_addr[0] == 0 && bound_addr[1] == 0) {
+        if (bound_addr[2] == 0 && bound_addr[3] == 0) return !v6only;
+        if (bound_addr[2] == htonl(0xffff)) return bound_addr[3] == address;
+    }
+    return 0;
+}
+
+// Valor de INET_DIAG_SKV6ONLY en los atributos que siguen a inet_diag_msg (0 si falta)
+static int diag_v6only(const struct nlmsghdr *header) {
+    const struct inet_diag_msg *diag = NLMSG_DATA(header);
+    struct rtattr *attr = (struct rtattr*)(diag + 1);
+    int length = (int)header->nlmsg_len - NLMSG_LENGTH(sizeof(*diag));
+
+    for (; RTA_OK(attr, length); attr = RTA_NEXT(attr, length)) {
+        if (attr->rta_type == INET_DIAG_SKV6ONLY && RTA_PAYLOAD(attr) >= 1) {
+            return *(const unsigned char*)RTA_DATA(attr) != 0;
+        }
+    }
+    return 0;
+}
+
+static int append_listener(ListenerInfo **listeners, int *count, int *capacity,
+                           int port, unsigned int inode) {
+    if (*count >= *capacity) {
+        int new_capacity = *capacity == 0 ? 64 : *capacity * 2;
+        ListenerInfo *grown = realloc(*listeners, new_capacity * sizeof(ListenerInfo));
+        if (!grown) return -1;
+        *listeners = grown;
+        *capacity = new_capacity;
+    }
+
+    ListenerInfo *info = &(*listeners)[(*count)++];
+    info->port = port;
+    info->inode = inode;
+    info->pid = -1;
+    info->process[0] = '\0';
+    return 0;
+}
+
+static int dump_family(int nl, int family, int protocol, const struct sockaddr *target,
+                       const PortSet *port_filter, ListenerInfo **listeners,
+                       int *count, int *capacity) {
+    struct {
+        struct nlmsghdr header;
+        struct inet_diag_req_v2 request;
+    } message;
+    struct sockaddr_nl kernel;
+    char *buffer;
+
+    memset(&message, 0, sizeof(message));
+    message.header.nlmsg_len = sizeof(message);
+    message.header.nlmsg_type = SOCK_DIAG_BY_FAMILY;
+    message.header.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+    message.header.nlmsg_seq = (unsigned int)family;
+    message.request.sdiag_family = (unsigned char)family;
+    message.request.sdiag_protocol = (unsigned char)protocol;
+    message.request.idiag_states = 1U << (protocol == IPPROTO_UDP ? UDP_UNCONNECTED_STATE : TCP_LISTEN_STATE);
+
+    memset(&kernel, 0, sizeof(kernel));
+    kernel.nl_family = AF_NETLINK;
+    if (sendto(nl, &message, sizeof(message), 0, (struct sockaddr*)&kernel, sizeof(kernel)) < 0) {
+        return -1;
+    }
+
+    buffer = malloc(DIAG_BUFFER_SIZE);
+    if (!buffer) return -1;
+
+    int status = 0;
+    int done = 0;
+    while (!done) {
+        ssize_t received = recv(nl, buffer, DIAG_BUFFER_SIZE, 0);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            status = -1;
+            break;
+        }
+
+        struct nlmsghdr *header = (struct nlmsghdr*)buffer;
+        int remaining = (int)received;
+        for (; NLMSG_OK(header, remaining); header = NLMSG_NEXT(header, remaining)) {
+            if (header->nlmsg_type == NLMSG_DONE) {
+                done = 1;
+                break;
+            }
+            if (header->nlmsg_type == NLMSG_ERROR) {
+                status = -1;
+                done = 1;
+                break;
+            }
+
+            const struct inet_diag_msg *diag = NLMSG_DATA(header);
+            int port = ntohs(diag->id.idiag_sport);
+            if (protocol == IPPROTO_UDP && diag->id.idiag_dport != 0) continue;
+            if (port_filter && !port_set_contains(port_filter, port)) continue;
+            if (!listener_reaches_target(family, diag->id.idiag_src,
+                                         family == AF_INET6 && diag_v6only(header), target)) continue;
+
+            if (append_listener(listeners, count, capacity, port, diag->idiag_inode) != 0) {
+                status = -1;
+                done = 1;
+                break;
+            }
+        }
+    }
+
+    free(buffer);
+    return status;
+}
+
+static int compare_listeners(const void *a, const void *b) {
+    return ((const ListenerInfo*)a)->port - ((const ListenerInfo*)b)->port;
+}
+
+int listener_diag_dump(const struct sockaddr *target, int protocol, const PortSet *port_filter,
+                       ListenerInfo **listeners, int *count) {
+    if (!target || !listeners || !count) return -1;
+
+    *listeners = NULL;
+    *count = 0;
+    int capacity = 0;
+
+    int nl = socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_SOCK_DIAG);
+    if (nl < 0) return -1;
+
+    // Los listeners IPv4 nunca aceptan conexiones hacia un objetivo IPv6
+    if ((target->sa_family == AF_INET &&
+         dump_family(nl, AF_INET, protocol, target, port_filter, listeners, count, &capacity) != 0) ||
+        dump_family(nl, AF_INET6, protocol, target, port_filter, listeners, count, &capacity) != 0) {
+        close(nl);
+        free(*listeners);
+        *listeners = NULL;
+        *count = 0;
+        return -1;
+    }
+    close(nl);
+
+    // Un mismo puerto puede escuchar en IPv4 e IPv6: dejar una entrada por puerto
+    if (*count > 1) {
+        qsort(*listeners, *count, sizeof(ListenerInfo), compare_listeners);
+        int unique_count = 1;
+        for (int i = 1; i < *count; i++) {
+            if ((*listeners)[i].port != (*listeners)[unique_count - 1].port) {
+                (*listeners)[unique_count++] = (*listeners)[i];
+            }
+        }
+        *count = unique_count;
+    }
+    return 0;
+}
+
+static ListenerInfo* find_by_inode(ListenerInfo *listeners, int count, unsigned int inode) {
+    for (int i = 0; i < count; i++) {
+        if (listeners[i].inode == inode && listeners[i].pid < 0) {
+            return &listeners[i];
+        }
+    }
+    return NULL;
+}
+
+void listener_diag_resolve_owners(ListenerInfo *listeners, int count) {
+    if (!listeners || count <= 0) return;
+
+    DIR *proc = opendir("/proc");
+    if (!proc) return;
+
+    int pending = count;
+    struct dirent *entry;
+    while (pending > 0 && (entry = readdir(proc)) != NULL) {
+        int pid = atoi(entry->d_name);
+        if (pid <= 0) continue;
+
+        char path[64];
+        snprintf(path, sizeof(path), "/proc/%d/fd", pid);
+        DIR *fds = opendir(path);
+        if (!fds) continue;
+
+        struct dirent *fd_entry;
+        while ((fd_entry = readdir(fds)) != NULL) {
+            char link_path[320];
+            char target[64];
+            unsigned int inode;
+
+            snprintf(link_path, sizeof(link_path), "/proc/%d/fd/%s", pid, fd_entry->d_name);
+            ssize_t len = readlink(link_path, target, sizeof(target) - 1);
+            if (len <= 0) continue;
+            target[len] = '\0';
+            if (sscanf(target, "socket:[%u]", &inode) != 1) continue;
+
+            ListenerInfo *info = find_by_inode(listeners, count, inode);
+            if (!info) continue;
+
+            info->pid = pid;
+            snprintf(path, sizeof(path), "/proc/%d/comm", pid);
+            FILE *comm = fopen(path, "r");
+            if (comm) {
+                if (fgets(info->process, sizeof(info->process), comm)) {
+                    info->process[strcspn(info->process, "\n")] = '\0';
+                }
+                fclose(comm);
+            }
+            pending--;
+        }
+        closedir(fds);
+    }
+    closedir(proc);
+}
+
+const ListenerInfo* listener_diag_find(const ListenerInfo *listeners, int count, int port) {
+    ListenerInfo key;
+    key.port = port;
+    if (!listeners || count <= 0) return NULL;
+    return bsearch(&key, listeners, count, sizeof(ListenerInfo), compare_listeners);
+}
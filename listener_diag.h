@@ -0,0 +1,26 @@
+/*
+ * Listener Diag - Enumeración de puertos locales abiertos (TCP y UDP) vía NETLINK_SOCK_DIAG
+ */
+
+#ifndef LISTENER_DIAG_H
+#define LISTENER_DIAG_H
+
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include "port_set.h"
+
+typedef struct {
+    int port;
+    unsigned int inode;
+    int pid;            // -1 si no se pudo determinar
+    char process[32];   // Nombre del proceso (vacío si se desconoce)
+} ListenerInfo;
+
+// Funciones públicas
+int listener_diag_is_local(const struct sockaddr *addr);
+int listener_diag_dump(const struct sockaddr *target, int protocol, const PortSet *port_filter,
+                       ListenerInfo **listeners, int *count);
+void listener_diag_resolve_owners(ListenerInfo *listeners, int count);
+const ListenerInfo* listener_diag_find(const ListenerInfo *listeners, int count, int port);
+
+#endif
@@ -2,7 +2,7 @@
  * MatcomGuard - Sistema de Monitoreo de Seguridad
  * Escáner de puertos en tiempo real para sistemas Unix-like
  * 
- * Compilar: gcc -o matcomguard matcomguard.c port_scanner.c alert_manager.c report_generator.c -lpthread
+ * Compilar: gcc -o matcomguard matcomguard.c port_scanner.c scan_console.c port_set.c scan_engine.c scan_uring.c scan_syn.c scan_udp.c scan_pacer.c fd_budget.c probe_stats.c banner_grabber.c service_matcher.c timer_wheel.c scan_plan.c scan_checkpoint.c scan_scheduler.c scan_history.c host_table.c rtt_estimator.c listener_diag.c port_classifier.c config.c arena.c alert_queue.c alert_journal.c alert_manager.c report_generator.c -lpthread
  * Uso: ./matcomguard --scan-ports 1-1024
  */
 
@@ -13,12 +13,20 @@
 #include <getopt.h>
 #include <signal.h>
 #include <time.h>
+#include <sys/random.h>
 #include "port_scanner.h"
+#include "scan_console.h"
+#include "scan_engine.h"
+#include "scan_scheduler.h"
+#include "scan_history.h"
+#include "alert_journal.h"
 #include "alert_manager.h"
 #include "report_generator.h"
+#include "port_classifier.h"
+#include "config.h"
 
 #define VERSION "1.0.0"
-#define MAX_TARGET_LEN 256
+#define MAX_TARGET_LEN 4096
 
 // Variables globales para manejo de señales
 volatile int keep_running = 1;
@@ -34,17 +42,202 @@ void print_usage(const char *program_name) {
     printf("Uso: %s [OPCIONES]\n\n", program_name);
     printf("Opciones:\n");
     printf("  --scan-ports RANGO    Rango de puertos a escanear (ej: 1-1024, 80,443,22)\n");
-    printf("  --target IP           IP objetivo (por defecto: 127.0.0.1)\n");
+    printf("  --target OBJETIVOS    IPs (v4/v6), nombres, CIDR o rangos separados por comas\n");
+    printf("                        (ej: 192.168.1.0/24,10.0.0.1-50; por defecto: 127.0.0.1)\n");
     printf("  --continuous          Monitoreo continuo en tiempo real\n");
     printf("  --interval SEGUNDOS   Intervalo entre escaneos (por defecto: 30)\n");
-    printf("  --timeout SEGUNDOS    Timeout para conexiones TCP (por defecto: 3)\n");
+    printf("  --tiered              Modo continuo por niveles: puertos de riesgo y volátiles cada\n");
+    printf("                        pocos segundos, servicios cada intervalo y el resto en barrido gradual\n");
+    printf("  --hot-interval SEG    Periodo de los puertos de riesgo con --tiered (por defecto: %d)\n",
+           SCAN_SCHEDULER_HOT_PERIOD);
+    printf("  --timeout TIEMPO      Plazo máximo por conexión TCP, en segundos o con sufijo ms\n");
+    printf("                        (ej: 3, 1.5, 250ms; por defecto: 3). El plazo real se\n");
+    printf("                        adapta al RTT medido de cada host\n");
+    printf("  --retries N           Reintentos de sondas sin respuesta (por defecto: %d)\n", SCAN_ENGINE_DEFAULT_RETRIES);
+    printf("  --parallel N          Conexiones simultáneas en vuelo (por defecto: %d)\n", SCAN_ENGINE_DEFAULT_INFLIGHT);
+    printf("  --engine MOTOR        Motor de escaneo: uring, epoll, blocking, syn, udp (por defecto: epoll)\n");
+    printf("  --syn                 Escaneo semiabierto con SYN sobre socket raw (requiere root)\n");
+    printf("  --udp                 Escanear puertos UDP (abierto, cerrado u open|filtered)\n");
+    printf("  --rate N              Máximo de sondas por segundo (por defecto: sin límite)\n");
+    printf("  --congestion          Adaptar las sondas en vuelo a las pérdidas (AIMD por host)\n");
+    printf("  --banners             Identificar el servicio real de cada puerto abierto por su banner\n");
+    printf("  --random-order        Sondear hosts y puertos en orden aleatorio\n");
+    printf("  --seed N              Semilla del orden aleatorio (implica --random-order)\n");
+    printf("  --no-netlink          Usar conexiones TCP también con objetivos locales\n");
+    printf("  --checkpoint ARCHIVO  Guardar el progreso cada %ds para poder reanudar\n", SCAN_CHECKPOINT_INTERVAL);
+    printf("  --resume ARCHIVO      Continuar un barrido interrumpido (objetivo y puertos del archivo)\n");
+    printf("  --history DIRECTORIO  Guardar el estado de cada host en disco; al reiniciar, los\n");
+    printf("                        cambios se detectan contra el último estado guardado\n");
+    printf("  --at FECHA            Mostrar qué estaba abierto en los objetivos en esa fecha\n");
+    printf("                        según --history, sin escanear (\"AAAA-MM-DD HH:MM[:SS]\" o @epoch)\n");
+    printf("  --journal DIRECTORIO  Registrar cada alerta en un diario en disco; al reiniciar, las\n");
+    printf("                        alertas anteriores se recuperan. Sin --scan-ports, muestra el\n");
+    printf("                        resumen del diario (y lo exporta con --export-pdf) sin escanear\n");
+    printf("  --stats               Mostrar al final la tasa de sondas y la latencia p50/p99\n");
+    printf("  --config ARCHIVO      Archivo de configuración (por defecto: %s o %s)\n",
+           CONFIG_DEFAULT_PATH, CONFIG_SYSTEM_PATH);
     printf("  --export-pdf          Exportar alertas a PDF al finalizar\n");
     printf("  --help               Mostrar esta ayuda\n");
     printf("  --version            Mostrar versión\n\n");
     printf("Ejemplos:\n");
     printf("  %s --scan-ports 1-1024\n", program_name);
     printf("  %s --scan-ports 1-65535 --target 192.168.1.1\n", program_name);
+    printf("  %s --scan-ports 22,80,443 --target 10.0.0.0/16 --parallel 4000\n", program_name);
     printf("  %s --scan-ports 80,443,22,21 --continuous\n", program_name);
+    printf("  %s --scan-ports 1-65535 --tiered\n", program_name);
+    printf("  %s --target 10.0.0.0/24 --history hist --at \"2026-01-15 03:00\"\n", program_name);
+    printf("  %s --journal alertas --export-pdf\n", program_name);
+}
+
+// Convierte "3", "1.5", "2s" o "250ms" a milisegundos; -1 si no es válido
+static int parse_timeout_ms(const char *text) {
+    char *end;
+    double value = strtod(text, &end);
+    if (end == text || value <= 0) return -1;
+
+    if (strcmp(end, "ms") == 0) {
+        // Ya en milisegundos
+    } else if (*end == '\0' || strcmp(end, "s") == 0) {
+        value *= 1000.0;
+    } else {
+        return -1;
+    }
+    if (value < 1 || value > 3600 * 1000.0) return -1;
+    return (int)value;
+}
+
+// Convierte "AAAA-MM-DD[ HH:MM[:SS]]" (hora local) o "@epoch"; -1 si no es válido
+static int parse_history_time(const char *text, time_t *out) {
+    if (text[0] == '@') {
+        char *end;
+        long long value = strtoll(text + 1, &end, 10);
+        if (end == text + 1 || *end != '\0') return -1;
+        *out = (time_t)value;
+        return 0;
+    }
+    
+    static const char *formats[] = {"%Y-%m-%d %H:%M:%S", "%Y-%m-%d %H:%M", "%Y-%m-%d", NULL};
+    for (int i = 0; formats[i]; i++) {
+        struct tm tm_value;
+        memset(&tm_value, 0, sizeof(tm_value));
+        const char *end = strptime(text, formats[i], &tm_value);
+        if (end && *end == '\0') {
+            tm_value.tm_isdst = -1;
+            *out = mktime(&tm_value);
+            return *out == (time_t)-1 ? -1 : 0;
+        }
+    }
+    return -1;
+}
+
+// Consulta del historial: puertos abiertos de cada objetivo en el instante 'when'
+static int print_history_at(const char *directory, const char *target, int udp, time_t when) {
+    ScanHistory *history = scan_history_open(directory, udp);
+    HostTable *hosts = host_table_create();
+    PortSet *state = malloc(sizeof(PortSet));
+    int status = 0;
+    
+    if (!history || !hosts || !state || host_table_parse(hosts, target) != 0) {
+        fprintf(stderr, "Error: No se pudo abrir el historial '%s' o el objetivo '%s' no es válido\n",
+                directory, target);
+        status = 1;
+    }
+    
+    char when_str[64];
+    strftime(when_str, sizeof(when_str), "%Y-%m-%d %H:%M:%S", localtime(&when));
+    for (int h = 0; status == 0 && h < hosts->count; h++) {
+        char address[HOST_TABLE_FORMAT_SIZE];
+        host_table_format(&hosts->hosts[h], address, sizeof(address));
+        
+        time_t since;
+        int found = scan_history_at(history, &hosts->hosts[h], when, state, &since);
+        if (found < 0) {
+            printf("[HISTORIAL] %s: historial dañado o ilegible\n", address);
+            continue;
+        }
+        if (found == 0) {
+            printf("[HISTORIAL] %s: sin registros hasta %s\n", address, when_str);
+            continue;
+        }
+        
+        char since_str[64];
+        strftime(since_str, sizeof(since_str), "%Y-%m-%d %H:%M:%S", localtime(&since));
+        printf("[HISTORIAL] %s a las %s: ", address, when_str);
+        if (port_set_next(state, 0) < 0) {
+            printf("ningún puerto %s abierto", udp ? "UDP" : "TCP");
+        }
+        for (int port = port_set_next(state, 0); port >= 0; port = port_set_next(state, port + 1)) {
+            printf("%d%s", port, port_set_next(state, port + 1) >= 0 ? "," : "");
+        }
+        printf(" (sin cambios desde %s)\n", since_str);
+    }
+    
+    free(state);
+    host_table_destroy(hosts);
+    scan_history_close(history);
+    return status;
+}
+
+static void load_journal_alert(const Alert *alert, uint32_t count, time_t first_seen, void *user_data) {
+    alert_manager_restore_alert((AlertManager*)user_data, alert, count, first_seen);
+}
+
+// Resumen (y reporte) de las alertas del diario, leído sin abrirlo en escritura
+static int print_journal(const char *directory, const char *target, int export_pdf) {
+    AlertManager *manager = alert_manager_create();
+    ReportGenerator *report_gen = manager ? report_generator_create(manager) : NULL;
+    AlertJournalCursor cursor = { 0, 0 };
+    int loaded = report_gen ? alert_journal_read(directory, &cursor, load_journal_alert, manager) : -1;
+    int status = 0;
+    
+    if (loaded < 0) {
+        fprintf(stderr, "Error: No se pudo leer el diario de alertas '%s'\n", directory);
+        status = 1;
+    } else {
+        print_banner();
+        printf("Diario: %s (%llu alertas)\n", directory, manager->occurrences);
+        printf("============================================================\n");
+        alert_manager_show_summary(manager);
+        
+        if (export_pdf) {
+            printf("\n[INFO] Generando reporte PDF...\n");
+            char pdf_path[512];
+            if (report_generator_create_pdf(report_gen, target, "(diario de alertas)", pdf_path,
+                                            sizeof(pdf_path)) == 0) {
+                printf("[INFO] Reporte guardado en: %s\n", pdf_path);
+            } else {
+                printf("[ERROR] No se pudo generar el reporte PDF\n");
+            }
+        }
+    }
+    
+    report_generator_destroy(report_gen);
+    alert_manager_destroy(manager);
+    return status;
+}
+
+// Un puerto que cambió de estado pasa a sondearse con los de riesgo
+static void on_port_changes(const ScanEvent *event, void *user_data) {
+    ScanScheduler *scheduler = (ScanScheduler*)user_data;
+    const PortSet *sets[2] = {event->opened, event->closed};
+    for (int i = 0; i < 2; i++) {
+        for (int port = port_set_next(sets[i], 0); port >= 0; port = port_set_next(sets[i], port + 1)) {
+            scan_scheduler_observe(scheduler, port, event->timestamp);
+        }
+    }
+}
+
+// Línea de rendimiento de --stats (la lee make bench-scan)
+static void print_probe_stats(const ProbeStats *stats) {
+    if (stats->probes == 0) {
+        printf("\n[INFO] Rendimiento: sin sondas (listeners leídos vía sock_diag)\n");
+        return;
+    }
+    printf("\n[INFO] Rendimiento: %llu sondas en %.3fs (%.0f sondas/s), latencia p50 %lluus p99 %lluus "
+           "(%llu con respuesta)\n",
+           (unsigned long long)stats->probes, stats->elapsed_us / 1000000.0, probe_stats_rate(stats),
+           (unsigned long long)probe_stats_percentile(stats, 50), (unsigned long long)probe_stats_percentile(stats, 99),
+           (unsigned long long)stats->samples);
 }
 
 void signal_handler(int signum) {
@@ -64,7 +257,29 @@ int main(int argc, char *argv[]) {
     char *port_range = NULL;
     int continuous = 0;
     int interval = 30;
-    int timeout = 3;
+    int tiered = 0;
+    int hot_interval = SCAN_SCHEDULER_HOT_PERIOD;
+    int timeout_ms = 3000;
+    int retries = SCAN_ENGINE_DEFAULT_RETRIES;
+    int interval_set = 0;
+    int timeout_set = 0;
+    const char *config_path = NULL;
+    int parallel = SCAN_ENGINE_DEFAULT_INFLIGHT;
+    ScanEngineType engine = SCAN_ENGINE_EPOLL;
+    int use_netlink = 1;
+    int random_order = -1;
+    int seed_set = 0;
+    unsigned long long seed = 0;
+    double rate = 0;
+    int congestion = 0;
+    int grab_banners = 0;
+    const char *checkpoint_path = NULL;
+    const char *resume_path = NULL;
+    ScanCheckpoint *resume = NULL;
+    const char *history_path = NULL;
+    const char *history_at = NULL;
+    const char *journal_path = NULL;
+    int show_stats = 0;
     int export_pdf = 0;
     
     // Opciones de línea de comandos
@@ -73,7 +288,27 @@ int main(int argc, char *argv[]) {
         {"target", required_argument, 0, 't'},
         {"continuous", no_argument, 0, 'c'},
         {"interval", required_argument, 0, 'i'},
+        {"tiered", no_argument, 0, 'L'},
+        {"hot-interval", required_argument, 0, 'H'},
         {"timeout", required_argument, 0, 'T'},
+        {"retries", required_argument, 0, 'R'},
+        {"parallel", required_argument, 0, 'P'},
+        {"engine", required_argument, 0, 'E'},
+        {"syn", no_argument, 0, 'S'},
+        {"udp", no_argument, 0, 'U'},
+        {"rate", required_argument, 0, 'a'},
+        {"congestion", no_argument, 0, 'g'},
+        {"banners", no_argument, 0, 'b'},
+        {"random-order", no_argument, 0, 'r'},
+        {"seed", required_argument, 0, 's'},
+        {"no-netlink", no_argument, 0, 'N'},
+        {"checkpoint", required_argument, 0, 'k'},
+        {"resume", required_argument, 0, 'z'},
+        {"history", required_argument, 0, 'Y'},
+        {"at", required_argument, 0, 'A'},
+        {"journal", required_argument, 0, 'J'},
+        {"stats", no_argument, 0, 'M'},
+        {"config", required_argument, 0, 'C'},
         {"export-pdf", no_argument, 0, 'e'},
         {"help", no_argument, 0, 'h'},
         {"version", no_argument, 0, 'v'},
@@ -83,7 +318,7 @@ int main(int argc, char *argv[]) {
     int opt;
     int option_index = 0;
     
-    while ((opt = getopt_long(argc, argv, "p:t:ci:T:ehv", long_options, &option_index)) != -1) {
+    while ((opt = getopt_long(argc, argv, "p:t:ci:LH:T:R:P:E:SUa:gbrs:Nk:z:Y:A:J:MC:ehv", long_options, &option_index)) != -1) {
         switch (opt) {
             case 'p':
                 port_range = strdup(optarg);
@@ -101,14 +336,106 @@ int main(int argc, char *argv[]) {
                     fprintf(stderr, "Error: El intervalo debe ser mayor a 0\n");
                     return 1;
                 }
+                interval_set = 1;
+                break;
+            case 'L':
+                tiered = 1;
+                continuous = 1;
+                break;
+            case 'H':
+                hot_interval = atoi(optarg);
+                if (hot_interval < 1) {
+                    fprintf(stderr, "Error: El periodo de los puertos de riesgo debe ser mayor a 0\n");
+                    return 1;
+                }
                 break;
             case 'T':
-                timeout = atoi(optarg);
-                if (timeout < 1) {
-                    fprintf(stderr, "Error: El timeout debe ser mayor a 0\n");
+                timeout_ms = parse_timeout_ms(optarg);
+                if (timeout_ms < 0) {
+                    fprintf(stderr, "Error: El timeout debe ser mayor a 0 (ej: 3, 1.5, 250ms)\n");
+                    return 1;
+                }
+                timeout_set = 1;
+                break;
+            case 'R':
+                retries = atoi(optarg);
+                if (retries < 0) {
+                    fprintf(stderr, "Error: Los reintentos no pueden ser negativos\n");
                     return 1;
                 }
                 break;
+            case 'P':
+                parallel = atoi(optarg);
+                if (parallel < 1) {
+                    fprintf(stderr, "Error: El paralelismo debe ser mayor a 0\n");
+                    return 1;
+                }
+                break;
+            case 'E':
+                if (scan_engine_parse_type(optarg, &engine) != 0) {
+                    fprintf(stderr, "Error: Motor de escaneo inválido '%s' (uring, epoll, blocking, syn, udp)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'S':
+                engine = SCAN_ENGINE_SYN;
+                break;
+            case 'U':
+                engine = SCAN_ENGINE_UDP;
+                break;
+            case 'a': {
+                char *end;
+                rate = strtod(optarg, &end);
+                if (end == optarg || *end != '\0' || rate <= 0) {
+                    fprintf(stderr, "Error: La tasa debe ser un número de sondas por segundo mayor a 0\n");
+                    return 1;
+                }
+                break;
+            }
+            case 'g':
+                congestion = 1;
+                break;
+            case 'b':
+                grab_banners = 1;
+                break;
+            case 'r':
+                random_order = 1;
+                break;
+            case 's': {
+                char *end;
+                seed = strtoull(optarg, &end, 0);
+                if (end == optarg || *end != '\0') {
+                    fprintf(stderr, "Error: Semilla inválida '%s'\n", optarg);
+                    return 1;
+                }
+                seed_set = 1;
+                random_order = 1;
+                break;
+            }
+            case 'N':
+                use_netlink = 0;
+                break;
+            case 'k':
+                checkpoint_path = optarg;
+                break;
+            case 'z':
+                resume_path = optarg;
+                break;
+            case 'Y':
+                history_path = optarg;
+                break;
+            case 'A':
+                history_at = optarg;
+                break;
+            case 'J':
+                journal_path = optarg;
+                break;
+            case 'M':
+                show_stats = 1;
+                break;
+            case 'C':
+                config_path = optarg;
+                break;
             case 'e':
                 export_pdf = 1;
                 break;
@@ -124,6 +451,51 @@ int main(int argc, char *argv[]) {
         }
     }
     
+    // Consulta del historial: no hace falta escanear
+    if (history_at) {
+        time_t when;
+        if (!history_path) {
+            fprintf(stderr, "Error: --at requiere --history DIRECTORIO\n");
+            free(port_range);
+            return 1;
+        }
+        if (parse_history_time(history_at, &when) != 0) {
+            fprintf(stderr, "Error: Fecha inválida '%s' (AAAA-MM-DD HH:MM[:SS] o @epoch)\n", history_at);
+            free(port_range);
+            return 1;
+        }
+        free(port_range);
+        return print_history_at(history_path, target, engine == SCAN_ENGINE_UDP, when);
+    }
+    
+    // Consulta del diario de alertas: sin puertos que escanear, sólo se lee
+    if (journal_path && !port_range && !resume_path) {
+        return print_journal(journal_path, target, export_pdf);
+    }
+    
+    // Reanudar: objetivo, puertos, protocolo y orden salen del checkpoint
+    if (resume_path) {
+        resume = scan_checkpoint_load(resume_path);
+        if (!resume) {
+            fprintf(stderr, "Error: No se pudo leer el checkpoint '%s' (inexistente o dañado)\n", resume_path);
+            free(port_range);
+            return 1;
+        }
+        strncpy(target, resume->target_spec, MAX_TARGET_LEN - 1);
+        target[MAX_TARGET_LEN - 1] = '\0';
+        free(port_range);
+        port_range = strdup(resume->port_spec);
+        random_order = resume->randomized;
+        seed = resume->seed;
+        seed_set = 1;
+        if (resume->udp) {
+            engine = SCAN_ENGINE_UDP;
+        } else if (engine == SCAN_ENGINE_UDP) {
+            engine = SCAN_ENGINE_EPOLL;
+        }
+        if (!checkpoint_path) checkpoint_path = resume_path;
+    }
+    
     // Verificar argumentos requeridos
     if (!port_range) {
         fprintf(stderr, "Error: Debe especificar --scan-ports\n\n");
@@ -131,9 +503,51 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
+    // Compilar el conjunto de puertos una sola vez
+    PortSet port_set;
+    if (port_set_parse(port_range, &port_set) != 0) {
+        fprintf(stderr, "Error: Rango de puertos inválido '%s'\n", port_range);
+        free(port_range);
+        scan_checkpoint_destroy(resume);
+        return 1;
+    }
+    
+    // Construir la tabla de clasificación (valores por defecto + archivo de configuración)
+    int explicit_config = config_path != NULL;
+    if (!config_path) {
+        config_path = config_find_default_path();
+    }
+    int config_entries = port_classifier_init(config_path);
+    if (config_entries < 0) {
+        if (explicit_config) {
+            fprintf(stderr, "Error: No se pudo leer el archivo de configuración '%s'\n", config_path);
+            free(port_range);
+            scan_checkpoint_destroy(resume);
+            return 1;
+        }
+        config_path = NULL;
+    }
+    if (config_path) {
+        MatcomConfig config;
+        if (config_load(config_path, &config, NULL, NULL) == 0) {
+            if (!timeout_set && config.default_timeout > 0) timeout_ms = config.default_timeout * 1000;
+            if (!interval_set && config.default_interval > 0) interval = config.default_interval;
+            if (random_order < 0 && config.random_order >= 0) random_order = config.random_order;
+        }
+    }
+    
+    if (random_order < 0) random_order = 0;
+    if (random_order && !seed_set && getrandom(&seed, sizeof(seed), 0) != sizeof(seed)) {
+        seed = (unsigned long long)time(NULL) ^ ((unsigned long long)getpid() << 32);
+    }
+    
     // Configurar manejadores de señales
     setup_signal_handlers();
     
+    // Presupuesto de descriptores: sube RLIMIT_NOFILE si la ventana no cabe
+    FdBudget fd_budget;
+    fd_budget_init(&fd_budget, parallel);
+    
     // Mostrar banner e información
     print_banner();
     printf("Objetivo: %s\n", target);
@@ -142,7 +556,48 @@ int main(int argc, char *argv[]) {
     if (continuous) {
         printf("Intervalo: %ds\n", interval);
     }
-    printf("Timeout: %ds\n", timeout);
+    if (tiered) {
+        printf("Planificación: por niveles (riesgo y volátiles cada %ds)\n",
+               hot_interval < interval ? hot_interval : interval);
+    }
+    printf("Timeout: hasta %dms (adaptativo por RTT, %d reintentos)\n", timeout_ms, retries);
+    if (config_path) {
+        printf("Configuración: %s (%d puertos personalizados)\n", config_path, config_entries);
+    }
+    printf("Paralelismo: %d conexiones\n", parallel);
+    printf("Descriptores: %d para sondas (RLIMIT_NOFILE %d%s)\n", fd_budget.capacity,
+           fd_budget.limit, fd_budget.raised ? ", ampliado" : "");
+    if (fd_budget.capacity < parallel && engine != SCAN_ENGINE_SYN && engine != SCAN_ENGINE_UDP) {
+        printf("[ADVERTENCIA] El límite de descriptores reduce el paralelismo a %d conexiones\n",
+               fd_budget.capacity);
+    }
+    printf("Motor: %s\n", scan_engine_type_to_string(engine));
+    if (rate > 0) {
+        printf("Tasa: hasta %.0f sondas/s\n", rate);
+    }
+    if (congestion) {
+        printf("Congestión: ventanas AIMD por host y global\n");
+    }
+    if (grab_banners) {
+        printf("Servicios: identificación por banner\n");
+    }
+    if (resume_path) {
+        printf("Reanudando: %s\n", resume_path);
+    }
+    if (checkpoint_path) {
+        printf("Checkpoint: %s (cada %ds)\n", checkpoint_path, SCAN_CHECKPOINT_INTERVAL);
+    }
+    if (history_path) {
+        printf("Historial: %s\n", history_path);
+    }
+    if (journal_path) {
+        printf("Diario de alertas: %s\n", journal_path);
+    }
+    if (random_order) {
+        printf("Orden: aleatorio (semilla %llu)\n", seed);
+    } else {
+        printf("Orden: secuencial\n");
+    }
     printf("============================================================\n");
     
     // Inicializar componentes
@@ -150,22 +605,83 @@ int main(int argc, char *argv[]) {
     if (!alert_manager) {
         fprintf(stderr, "Error: No se pudo inicializar el gestor de alertas\n");
         free(port_range);
+        scan_checkpoint_destroy(resume);
         return 1;
     }
     global_alert_manager = alert_manager;
     
-    PortScanner *scanner = port_scanner_create(target, timeout, alert_manager);
+    // Diario de alertas: recuperar las de ejecuciones anteriores y registrar las nuevas
+    AlertJournal *journal = NULL;
+    if (journal_path) {
+        journal = alert_journal_open(journal_path);
+        int recovered = journal ? alert_manager_attach_journal(alert_manager, journal) : -1;
+        if (recovered < 0) {
+            fprintf(stderr, "Error: No se pudo abrir el diario de alertas '%s'\n", journal_path);
+            alert_journal_close(journal);
+            alert_manager_destroy(alert_manager);
+            free(port_range);
+            scan_checkpoint_destroy(resume);
+            return 1;
+        }
+        if (recovered > 0) {
+            printf("[INFO] Diario: %d alertas recuperadas (%d distintas)\n", recovered,
+                   alert_manager->total_alerts);
+        }
+    }
+    
+    PortScanner *scanner = port_scanner_create(target, timeout_ms, alert_manager);
     if (!scanner) {
-        fprintf(stderr, "Error: No se pudo inicializar el escáner de puertos\n");
+        fprintf(stderr, "Error: Objetivo inválido '%s' o sin memoria para el escáner\n", target);
+        alert_journal_close(journal);
         alert_manager_destroy(alert_manager);
         free(port_range);
+        scan_checkpoint_destroy(resume);
         return 1;
     }
+    scanner->max_inflight = parallel;
+    scanner->max_retries = retries;
+    scanner->engine = engine;
+    scanner->use_netlink = use_netlink;
+    scanner->random_order = random_order;
+    scanner->seed = seed;
+    scanner->rate = rate;
+    scanner->congestion = congestion;
+    scanner->fds = &fd_budget;
+    scanner->grab_banners = grab_banners;
+    scanner->running = &keep_running;
+    ProbeStats probe_stats;
+    if (show_stats) {
+        probe_stats_init(&probe_stats);
+        scanner->stats = &probe_stats;
+    }
+    port_scanner_subscribe(scanner, SCAN_CONSOLE_EVENTS, scan_console_print, NULL);
+    scanner->port_spec = port_range;
+    scanner->checkpoint_path = checkpoint_path;
+    if (resume) {
+        scanner->scan_round = resume->scan_round;
+        scanner->resume = resume;
+    }
+    
+    ScanHistory *history = NULL;
+    if (history_path) {
+        history = scan_history_open(history_path, engine == SCAN_ENGINE_UDP);
+        if (!history) {
+            fprintf(stderr, "Error: No se pudo abrir el directorio de historial '%s'\n", history_path);
+            port_scanner_destroy(scanner);
+            alert_journal_close(journal);
+            alert_manager_destroy(alert_manager);
+            free(port_range);
+            return 1;
+        }
+        scanner->history = history;
+    }
     
     ReportGenerator *report_gen = report_generator_create(alert_manager);
     if (!report_gen) {
         fprintf(stderr, "Error: No se pudo inicializar el generador de reportes\n");
+        scan_history_close(history);
         port_scanner_destroy(scanner);
+        alert_journal_close(journal);
         alert_manager_destroy(alert_manager);
         free(port_range);
         return 1;
@@ -174,11 +690,33 @@ int main(int argc, char *argv[]) {
     // Ejecutar escaneos
     int scan_count = 0;
     time_t start_time = time(NULL);
+    ScanScheduler *scheduler = NULL;
+    PortSet *due_ports = NULL;
+    time_t next_cycle = 0;
     
     do {
         scan_count++;
+        const PortSet *scan_ports = &port_set;
         
-        if (continuous) {
+        if (scheduler) {
+            // Ciclo del planificador: sólo los puertos que vencen ahora
+            time_t now = time(NULL);
+            int due = scan_scheduler_next(scheduler, now, due_ports);
+            next_cycle = now + scheduler->period[SCAN_TIER_HOT];
+            if (due > 0) {
+                struct tm *tm_info = localtime(&now);
+                char time_str[64];
+                strftime(time_str, sizeof(time_str), "%H:%M:%S", tm_info);
+                printf("\n--- Ciclo #%d - %s: %d puertos (%d de riesgo, %d servicios, %d del barrido",
+                       scan_count, time_str, due, scheduler->last_due[SCAN_TIER_HOT],
+                       scheduler->last_due[SCAN_TIER_WARM], scheduler->last_due[SCAN_TIER_COLD]);
+                if (scheduler->volatile_count > 0) {
+                    printf("; %d volátiles", scheduler->volatile_count);
+                }
+                printf(") ---\n");
+            }
+            scan_ports = due > 0 ? due_ports : NULL;
+        } else if (continuous) {
             struct tm *tm_info = localtime(&start_time);
             char time_str[64];
             strftime(time_str, sizeof(time_str), "%H:%M:%S", tm_info);
@@ -188,30 +726,67 @@ int main(int argc, char *argv[]) {
         }
         
         // Realizar escaneo
-        int result = port_scanner_scan(scanner, port_range);
+        int result = scan_ports ? port_scanner_scan(scanner, scan_ports) : 0;
         if (result != 0) {
             fprintf(stderr, "Error durante el escaneo\n");
             break;
         }
         
+        // Un fdatasync por ciclo para las alertas del diario
+        if (journal) {
+            alert_manager_drain(alert_manager);
+            alert_journal_sync(journal);
+        }
+        if (scanner->interrupted) {
+            break;
+        }
+        
         if (continuous && scan_count == 1) {
             printf("\n[INFO] Primer escaneo completado. Las siguientes alertas mostrarán solo cambios.\n");
         }
         
-        // Esperar intervalo si es modo continuo
-        if (continuous && keep_running) {
+        // Tras la línea base completa, el planificador reparte los puertos por niveles
+        if (tiered && !scheduler) {
+            due_ports = malloc(sizeof(PortSet));
+            scheduler = due_ports ? scan_scheduler_create(&port_set, hot_interval, interval, time(NULL)) : NULL;
+            if (!scheduler) {
+                fprintf(stderr, "Error: No se pudo crear el planificador por niveles\n");
+                break;
+            }
+            port_scanner_subscribe(scanner, SCAN_EVENT_MASK(SCAN_EVENT_CHANGES), on_port_changes, scheduler);
+            scanner->quiet = 1;
+            next_cycle = time(NULL) + scheduler->period[SCAN_TIER_HOT];
+            printf("[INFO] Planificador: %d de riesgo cada %ds, %d servicios cada %ds, %d en barrido cada %ds\n",
+                   scheduler->tier_count[SCAN_TIER_HOT], scheduler->period[SCAN_TIER_HOT],
+                   scheduler->tier_count[SCAN_TIER_WARM], scheduler->period[SCAN_TIER_WARM],
+                   scheduler->tier_count[SCAN_TIER_COLD], scheduler->period[SCAN_TIER_COLD]);
+            printf("[INFO] Carga: ~%.1f sondas/s por host (barrido completo: %.1f)\n",
+                   scan_scheduler_rate(scheduler), (double)scheduler->count / interval);
+        }
+        
+        // Esperar intervalo (o el próximo ciclo del planificador) si es modo continuo
+        if (scheduler) {
+            while (keep_running && time(NULL) < next_cycle) {
+                sleep(1);
+            }
+        } else if (continuous && keep_running) {
             for (int i = 0; i < interval && keep_running; i++) {
                 sleep(1);
             }
         }
         
     } while (continuous && keep_running);
+    scan_scheduler_destroy(scheduler);
+    free(due_ports);
     
     // Mostrar resumen final
     printf("\n============================================================\n");
     printf("            RESUMEN FINAL\n");
     printf("============================================================\n");
     alert_manager_show_summary(alert_manager);
+    if (show_stats) {
+        print_probe_stats(&probe_stats);
+    }
     
     // Exportar PDF si se solicita
     if (export_pdf) {
@@ -229,10 +804,29 @@ int main(int argc, char *argv[]) {
     alert_manager_clear_alerts(alert_manager);
     
     report_generator_destroy(report_gen);
+    if (history && history->records > 0) {
+        printf("[INFO] Historial: %llu cambios guardados (%llu bytes) en %s\n",
+               history->records, history->bytes, history->directory);
+    }
+    scan_history_close(history);
+    if (journal) {
+        alert_journal_sync(journal);
+        printf("[INFO] Diario: %llu alertas añadidas (%llu bytes, %llu sincronizaciones) en %s\n",
+               journal->records, journal->bytes, journal->syncs, journal->directory);
+        if (journal->compactions > 0) {
+            printf("[INFO] Diario: %llu compactaciones\n", journal->compactions);
+        }
+        if (journal->errors > 0) {
+            printf("[ADVERTENCIA] Diario: %llu escrituras fallidas\n", journal->errors);
+        }
+    }
+    alert_journal_close(journal);
     port_scanner_destroy(scanner);
     alert_manager_destroy(alert_manager);
     free(port_range);
     
+    port_classifier_cleanup();
+    
     printf("[INFO] MatcomGuard finalizado correctamente\n");
     return 0;
 }
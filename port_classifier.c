@@ -0,0 +1,167 @@
+/*
+ * Port Classifier - Implementación de la tabla de clasificación
+ *
+ * La tabla se construye una sola vez al inicio: primero los valores por
+ * defecto compilados y luego las entradas de matcomguard.conf, que los
+ * sobrescriben puerto a puerto. Las descripciones se internan en un único
+ * almacén de cadenas, de modo que miles de puertos con la misma descripción
+ * comparten una copia y cada consulta es una sola lectura del arreglo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "port_classifier.h"
+#include "config.h"
+
+#define INTERN_HASH_SIZE 4096      // Potencia de 2
+#define MAX_STRINGS 65535
+
+// Mapeo de servicios comunes
+static const ServiceMapping common_services[] = {
+    {21, "FTP"}, {22, "SSH"}, {23, "Telnet"}, {25, "SMTP"}, {53, "DNS"},
+    {80, "HTTP"}, {110, "POP3"}, {143, "IMAP"}, {443, "HTTPS"}, {993, "IMAPS"},
+    {995, "POP3S"}, {465, "SMTPS"}, {587, "SMTP"}, {139, "NetBIOS"}, {445, "SMB"},
+    {3389, "RDP"}, {5432, "PostgreSQL"}, {3306, "MySQL"}, {1433, "MSSQL"},
+    {6379, "Redis"}, {27017, "MongoDB"}, {5672, "RabbitMQ"}, {9200, "Elasticsearch"},
+    {0, NULL} // Terminador
+};
+
+// Puertos sospechosos conocidos
+static const SuspiciousPort suspicious_ports[] = {
+    {31337, "Backdoor común"}, {12345, "NetBus"}, {54321, "Back Orifice"},
+    {6667, "IRC"}, {6666, "IRC/Backdoor"}, {4444, "Metasploit"}, {5555, "Android Debug"},
+    {8080, "Proxy/Web alternativo"}, {8888, "Proxy alternativo"}, {9999, "Backdoor común"},
+    {1234, "Ultors Trojan"}, {6969, "GateCrasher"}, {7777, "Tini backdoor"},
+    {0, NULL} // Terminador
+};
+
+static PortClass port_table[65536];
+static int table_ready = 0;
+
+// Almacén de cadenas internadas (el id 0 queda reservado)
+static char **strings = NULL;
+static int string_count = 0;
+static int string_capacity = 0;
+static uint16_t intern_hash[INTERN_HASH_SIZE];
+
+static uint32_t hash_string(const char *str) {
+    uint32_t hash = 2166136261u;   // FNV-1a
+    while (*str) {
+        hash ^= (unsigned char)*str++;
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+static uint16_t intern_string(const char *str) {
+    uint32_t slot = hash_string(str) & (INTERN_HASH_SIZE - 1);
+
+    // Sondeo lineal; si la tabla hash se llena se recurre a la búsqueda directa
+    for (int probes = 0; probes < INTERN_HASH_SIZE; probes++) {
+        uint16_t id = intern_hash[slot];
+        if (id == 0) break;
+        if (strcmp(strings[id], str) == 0) return id;
+        slot = (slot + 1) & (INTERN_HASH_SIZE - 1);
+    }
+    if (intern_hash[slot] != 0) {
+        for (int id = 1; id < string_count; id++) {
+            if (strcmp(strings[id], str) == 0) return (uint16_t)id;
+        }
+    }
+
+    if (string_count >= MAX_STRINGS) return 0;
+    if (string_count >= string_capacity) {
+        int new_capacity = string_capacity == 0 ? 64 : string_capacity * 2;
+        char **grown = realloc(strings, new_capacity * sizeof(char*));
+        if (!grown) return 0;
+        strings = grown;
+        string_capacity = new_capacity;
+    }
+    if (string_count == 0) {
+        strings[string_count++] = NULL;
+    }
+
+    char *copy = strdup(str);
+    if (!copy) return 0;
+    uint16_t id = (uint16_t)string_count;
+    strings[string_count++] = copy;
+    if (intern_hash[slot] == 0) {
+        intern_hash[slot] = id;
+    }
+    return id;
+}
+
+static void set_entry(int port, const char *description, int suspicious, int severity) {
+    PortClass *entry = &port_table[port];
+    entry->string_id = intern_string(description);
+    entry->flags = suspicious ? PORT_FLAG_SUSPICIOUS : PORT_FLAG_SERVICE;
+    if (severity >= 0) {
+        entry->severity = (uint8_t)severity;
+    } else {
+        entry->severity = suspicious ? ALERT_HIGH : ALERT_LOW;
+    }
+}
+
+static void apply_config_entry(int port, const char *description, ConfigSection section,
+                               int severity, void *user_data) {
+    int *loaded = (int*)user_data;
+    set_entry(port, description, section == CONFIG_SECTION_SUSPICIOUS, severity);
+    (*loaded)++;
+}
+
+static void build_defaults(void) {
+    // Puerto sin clasificar: servicio desconocido, advertencia media
+    for (int port = 0; port < 65536; port++) {
+        port_table[port].string_id = 0;
+        port_table[port].flags = 0;
+        port_table[port].severity = ALERT_MEDIUM;
+    }
+    for (int i = 0; common_services[i].service != NULL; i++) {
+        set_entry(common_services[i].port, common_services[i].service, 0, -1);
+    }
+    for (int i = 0; suspicious_ports[i].description != NULL; i++) {
+        set_entry(suspicious_ports[i].port, suspicious_ports[i].description, 1, -1);
+    }
+    table_ready = 1;
+}
+
+int port_classifier_init(const char *config_path) {
+    port_classifier_cleanup();
+    build_defaults();
+
+    if (!config_path) return 0;
+
+    MatcomConfig config;
+    int loaded = 0;
+    if (config_load(config_path, &config, apply_config_entry, &loaded) != 0) {
+        return -1;
+    }
+    return loaded;
+}
+
+void port_classifier_cleanup(void) {
+    for (int id = 1; id < string_count; id++) {
+        free(strings[id]);
+    }
+    free(strings);
+    strings = NULL;
+    string_count = 0;
+    string_capacity = 0;
+    memset(intern_hash, 0, sizeof(intern_hash));
+    table_ready = 0;
+}
+
+const PortClass* port_classifier_lookup(int port) {
+    if (!table_ready) build_defaults();
+    return &port_table[port & 0xffff];
+}
+
+const char* port_classifier_string(uint16_t string_id) {
+    if (string_id == 0 || string_id >= string_count) return NULL;
+    return strings[string_id];
+}
+
+int port_classifier_string_count(void) {
+    return string_count > 0 ? string_count - 1 : 0;
+}
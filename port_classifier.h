@@ -0,0 +1,38 @@
+/*
+ * Port Classifier - Tabla de clasificación de puertos indexada por número
+ */
+
+#ifndef PORT_CLASSIFIER_H
+#define PORT_CLASSIFIER_H
+
+#include <stdint.h>
+#include "alert_manager.h"
+
+#define PORT_FLAG_SERVICE    0x01   // string_id es el nombre de un servicio conocido
+#define PORT_FLAG_SUSPICIOUS 0x02   // string_id es la descripción de la amenaza
+
+// Entrada compacta (4 bytes): 65536 entradas ocupan 256 KB
+typedef struct {
+    uint16_t string_id;     // 0 = sin descripción
+    uint8_t flags;
+    uint8_t severity;       // AlertLevel sugerido
+} PortClass;
+
+typedef struct {
+    int port;
+    const char *service;
+} ServiceMapping;
+
+typedef struct {
+    int port;
+    const char *description;
+} SuspiciousPort;
+
+// Funciones públicas
+int port_classifier_init(const char *config_path);
+void port_classifier_cleanup(void);
+const PortClass* port_classifier_lookup(int port);
+const char* port_classifier_string(uint16_t string_id);
+int port_classifier_string_count(void);
+
+#endif
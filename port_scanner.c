@@ -1,59 +1,53 @@
 /*
  * Port Scanner - Implementación del escáner de puertos TCP
+ *
+ * El escáner no escribe en stdout: todo lo que produce (resultados de cada
+ * sonda, progreso, cambios, puertos clasificados y avisos) sale como
+ * ScanEvent hacia los suscriptores. La consola (scan_console.c) y el gestor
+ * de alertas son dos consumidores más; sin suscriptores para un tipo de
+ * evento el escáner ni siquiera lo construye.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdarg.h>
 #include <unistd.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
+#include <netdb.h>
 #include <errno.h>
-#include <fcntl.h>
-#include <sys/select.h>
-#include <pthread.h>
 #include "port_scanner.h"
-
-// Mapeo de servicios comunes
-static ServiceMapping common_services[] = {
-    {21, "FTP"}, {22, "SSH"}, {23, "Telnet"}, {25, "SMTP"}, {53, "DNS"},
-    {80, "HTTP"}, {110, "POP3"}, {143, "IMAP"}, {443, "HTTPS"}, {993, "IMAPS"},
-    {995, "POP3S"}, {465, "SMTPS"}, {587, "SMTP"}, {139, "NetBIOS"}, {445, "SMB"},
-    {3389, "RDP"}, {5432, "PostgreSQL"}, {3306, "MySQL"}, {1433, "MSSQL"},
-    {6379, "Redis"}, {27017, "MongoDB"}, {5672, "RabbitMQ"}, {9200, "Elasticsearch"},
-    {0, NULL} // Terminador
-};
-
-// Puertos sospechosos conocidos
-static SuspiciousPort suspicious_ports[] = {
-    {31337, "Backdoor común"}, {12345, "NetBus"}, {54321, "Back Orifice"},
-    {6667, "IRC"}, {6666, "IRC/Backdoor"}, {4444, "Metasploit"}, {5555, "Android Debug"},
-    {8080, "Proxy/Web alternativo"}, {8888, "Proxy alternativo"}, {9999, "Backdoor común"},
-    {1234, "Ultors Trojan"}, {6969, "GateCrasher"}, {7777, "Tini backdoor"},
-    {0, NULL} // Terminador
-};
+#include "scan_engine.h"
+#include "listener_diag.h"
+#include "port_classifier.h"
 
 typedef struct {
     PortScanner *scanner;
-    int port;
-    int *result;
-} ScanThreadData;
+    HostTable *hosts;
+    ScanPlan *plan;
+    ScanTracker tracker;    // Posiciones del plan ya completadas (para checkpoints)
+    time_t last_checkpoint;
+    uint64_t completed;
+    uint64_t total;
+    uint64_t report_every;
+    int failed;             // Sin memoria para el mapa de bits de algún host
+    uint64_t socket_errors; // Sondas sin socket o sin enviar (fallo local, no puerto cerrado)
+} ScanProgress;
 
 const char* get_service_name(int port) {
-    for (int i = 0; common_services[i].service != NULL; i++) {
-        if (common_services[i].port == port) {
-            return common_services[i].service;
-        }
+    const PortClass *entry = port_classifier_lookup(port);
+    if (entry->flags & PORT_FLAG_SERVICE) {
+        return port_classifier_string(entry->string_id);
     }
     return "Desconocido";
 }
 
 const char* get_suspicious_description(int port) {
-    for (int i = 0; suspicious_ports[i].description != NULL; i++) {
-        if (suspicious_ports[i].port == port) {
-            return suspicious_ports[i].description;
-        }
+    const PortClass *entry = port_classifier_lookup(port);
+    if (entry->flags & PORT_FLAG_SUSPICIOUS) {
+        return port_classifier_string(entry->string_id);
     }
     return NULL;
 }
@@ -62,335 +56,763 @@ int is_suspicious_port(int port) {
     return get_suspicious_description(port) != NULL;
 }
 
+// Devuelve 1 si está abierto, 0 si no y -1 si no se pudo crear el socket
 int scan_single_port(const char *host, int port, int timeout) {
-    int sock;
-    struct sockaddr_in target;
-    int flags;
-    fd_set fdset;
-    struct timeval tv;
-    int result;
-    socklen_t len;
-    int error;
-    
-    // Crear socket
-    sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        return 0;
-    }
-    
-    // Configurar socket no bloqueante
-    flags = fcntl(sock, F_GETFL, 0);
-    fcntl(sock, F_SETFL, flags | O_NONBLOCK);
+    ScanHost target;
+    struct sockaddr_storage endpoint;
     
-    // Configurar dirección objetivo
+    // Configurar dirección objetivo (IPv4, IPv6 o nombre)
     memset(&target, 0, sizeof(target));
-    target.sin_family = AF_INET;
-    target.sin_port = htons(port);
-    if (inet_pton(AF_INET, host, &target.sin_addr) <= 0) {
-        close(sock);
+    if (host_table_resolve(host, &target.addr, &target.addr_len) != 0) {
         return 0;
     }
     
-    // Intentar conexión
-    result = connect(sock, (struct sockaddr*)&target, sizeof(target));
+    socklen_t endpoint_len = host_table_endpoint(&target, port, &endpoint);
+    ScanResult result = scan_engine_probe_blocking(&endpoint, endpoint_len, timeout * 1000, NULL);
+    if (result == SCAN_RESULT_ERROR) {
+        return -1;
+    }
+    return result == SCAN_RESULT_OPEN;
+}
+
+// Camino rápido local: un volcado sock_diag en lugar de un connect por puerto
+static int scan_local_listeners(const struct sockaddr *target, int protocol, const PortSet *ports,
+                                PortSet *open_ports, ListenerInfo **listeners, int *listener_count) {
+    if (listener_diag_dump(target, protocol, ports, listeners, listener_count) != 0) return -1;
     
-    if (result < 0) {
-        if (errno == EINPROGRESS) {
-            // Conexión en progreso, usar select para timeout
-            FD_ZERO(&fdset);
-            FD_SET(sock, &fdset);
-            tv.tv_sec = timeout;
-            tv.tv_usec = 0;
-            
-            result = select(sock + 1, NULL, &fdset, NULL, &tv);
-            
-            if (result > 0) {
-                // Verificar si la conexión fue exitosa
-                len = sizeof(error);
-                if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
-                    close(sock);
-                    return 0;
-                }
-            } else {
-                // Timeout o error
-                close(sock);
-                return 0;
-            }
-        } else {
-            // Error inmediato
-            close(sock);
-            return 0;
+    listener_diag_resolve_owners(*listeners, *listener_count);
+    for (int i = 0; i < *listener_count; i++) {
+        port_set_add(open_ports, (*listeners)[i].port);
+    }
+    return 0;
+}
+
+static void emit_event(PortScanner *scanner, const ScanEvent *event) {
+    for (int i = 0; i < scanner->subscriber_count; i++) {
+        const ScanSubscriber *subscriber = &scanner->subscribers[i];
+        if (subscriber->mask & SCAN_EVENT_MASK(event->type)) {
+            subscriber->callback(event, subscriber->user_data);
         }
     }
+}
+
+static int wants_event(const PortScanner *scanner, ScanEventType type) {
+    return (scanner->event_mask & SCAN_EVENT_MASK(type)) != 0;
+}
+
+static void init_event(ScanEvent *event, ScanEventType type, int host, int port) {
+    memset(event, 0, sizeof(*event));
+    event->type = type;
+    event->host = host;
+    event->port = port;
+    event->timestamp = time(NULL);
+}
+
+static void scan_log(PortScanner *scanner, ScanLogLevel level, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
+
+static void scan_log(PortScanner *scanner, ScanLogLevel level, const char *format, ...) {
+    if (!wants_event(scanner, SCAN_EVENT_LOG)) return;
     
-    close(sock);
-    return 1; // Puerto abierto
+    char text[512];
+    va_list args;
+    va_start(args, format);
+    vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+    
+    ScanEvent event;
+    init_event(&event, SCAN_EVENT_LOG, -1, 0);
+    event.log_level = level;
+    event.text = text;
+    emit_event(scanner, &event);
 }
 
-int* parse_port_range(const char *port_string, int *count) {
-    int *ports = NULL;
-    int capacity = 0;
-    *count = 0;
+// Consumidor de alertas: registra los puertos abiertos de severidad media o alta
+static void alert_on_port(const ScanEvent *event, void *user_data) {
+    AlertManager *alert_manager = (AlertManager*)user_data;
+    if (event->level != ALERT_HIGH && event->level != ALERT_MEDIUM) return;
     
-    char *str_copy = strdup(port_string);
-    char *token = strtok(str_copy, ",");
+    Alert alert;
+    alert.level = event->level;
+    alert.message = event->text;
+    alert.port = event->port;
+    alert.service = event->identified ? event->identified :
+                    event->suspicious ? event->suspicious : event->service;
+    alert.host = event->address;
+    alert.source = event->protocol;
+    alert.timestamp = event->timestamp;
     
-    while (token != NULL) {
-        // Remover espacios
-        while (*token == ' ') token++;
-        
-        if (strchr(token, '-') != NULL) {
-            // Rango de puertos
-            int start, end;
-            if (sscanf(token, "%d-%d", &start, &end) == 2) {
-                for (int port = start; port <= end; port++) {
-                    if (*count >= capacity) {
-                        capacity = capacity == 0 ? 1000 : capacity * 2;
-                        ports = realloc(ports, capacity * sizeof(int));
-                    }
-                    ports[*count] = port;
-                    (*count)++;
-                }
+    alert_manager_add_alert(alert_manager, &alert);
+}
+
+static int save_checkpoint(PortScanner *scanner, const ScanPlan *plan, const ScanTracker *tracker,
+                           const char *path) {
+    ScanCheckpointInfo info;
+    info.target_spec = scanner->target_spec;
+    info.port_spec = scanner->port_spec ? scanner->port_spec : "";
+    info.udp = scanner->engine == SCAN_ENGINE_UDP;
+    info.randomized = scanner->random_order;
+    info.seed = scanner->seed;
+    info.scan_round = scanner->scan_round;
+    return scan_checkpoint_save(path, &info, scanner->hosts, plan, tracker);
+}
+
+static void collect_scan_result(int host, int port, int open, void *user_data) {
+    ScanProgress *progress = (ScanProgress*)user_data;
+    PortScanner *scanner = progress->scanner;
+    
+    if (wants_event(scanner, SCAN_EVENT_RESULT)) {
+        ScanEvent event;
+        init_event(&event, SCAN_EVENT_RESULT, host, port);
+        event.result = (ScanResult)open;
+        emit_event(scanner, &event);
+    }
+    
+    if (open == SCAN_RESULT_TIMEOUT || open == SCAN_RESULT_FILTERED) {
+        progress->hosts->hosts[host].unanswered++;
+    } else if (open == SCAN_RESULT_ERROR) {
+        // Estado desconocido: conservar el del escaneo anterior para no inventar cambios
+        ScanHost *entry = &progress->hosts->hosts[host];
+        progress->socket_errors++;
+        if (entry->previous_open && port_set_contains(entry->previous_open, port)) {
+            if (!entry->current_open) {
+                entry->current_open = calloc(1, sizeof(PortSet));
             }
-        } else {
-            // Puerto individual
-            int port = atoi(token);
-            if (port > 0 && port <= 65535) {
-                if (*count >= capacity) {
-                    capacity = capacity == 0 ? 1000 : capacity * 2;
-                    ports = realloc(ports, capacity * sizeof(int));
-                }
-                ports[*count] = port;
-                (*count)++;
+            if (entry->current_open) {
+                port_set_add(entry->current_open, port);
+            } else {
+                progress->failed = 1;
             }
         }
-        
-        token = strtok(NULL, ",");
+    } else if (open) {
+        ScanHost *entry = &progress->hosts->hosts[host];
+        if (!entry->current_open) {
+            entry->current_open = calloc(1, sizeof(PortSet));
+        }
+        if (entry->current_open) {
+            port_set_add(entry->current_open, port);
+        } else {
+            progress->failed = 1;
+        }
     }
+    if (scan_tracker_mark(&progress->tracker, scan_plan_position(progress->plan, host, port)) < 0) {
+        progress->failed = 1;
+    }
+    progress->completed++;
     
-    free(str_copy);
-    
-    // Ordenar y eliminar duplicados
-    if (*count > 1) {
-        // Ordenamiento burbuja simple
-        for (int i = 0; i < *count - 1; i++) {
-            for (int j = 0; j < *count - i - 1; j++) {
-                if (ports[j] > ports[j + 1]) {
-                    int temp = ports[j];
-                    ports[j] = ports[j + 1];
-                    ports[j + 1] = temp;
-                }
+    // Checkpoint periódico (se mira el reloj sólo cada 1024 sondas)
+    if (scanner->checkpoint_path && !scanner->quiet && (progress->completed & 1023) == 0) {
+        time_t now = time(NULL);
+        if (now - progress->last_checkpoint >= SCAN_CHECKPOINT_INTERVAL) {
+            if (save_checkpoint(scanner, progress->plan, &progress->tracker, scanner->checkpoint_path) != 0) {
+                scan_log(scanner, SCAN_LOG_WARNING, "No se pudo guardar el checkpoint en %s",
+                         scanner->checkpoint_path);
             }
+            progress->last_checkpoint = now;
         }
-        
-        // Eliminar duplicados
-        int unique_count = 1;
-        for (int i = 1; i < *count; i++) {
-            if (ports[i] != ports[unique_count - 1]) {
-                ports[unique_count] = ports[i];
-                unique_count++;
-            }
-        }
-        *count = unique_count;
     }
     
-    return ports;
-}
-
-void* scan_port_thread(void* arg) {
-    ScanThreadData *data = (ScanThreadData*)arg;
-    *(data->result) = scan_single_port(data->scanner->target_host, data->port, data->scanner->timeout);
-    return NULL;
+    // Progreso cada 100 sondas (o cada 1% en barridos grandes)
+    if (scanner->quiet || !wants_event(scanner, SCAN_EVENT_PROGRESS)) return;
+    if (progress->completed % progress->report_every == 0 || progress->completed == progress->total) {
+        ScanEvent event;
+        init_event(&event, SCAN_EVENT_PROGRESS, -1, 0);
+        event.completed = progress->completed;
+        event.total = progress->total;
+        emit_event(scanner, &event);
+    }
 }
 
-PortScanner* port_scanner_create(const char *target_host, int timeout, AlertManager *alert_manager) {
+PortScanner* port_scanner_create(const char *target_spec, int timeout_ms, AlertManager *alert_manager) {
     PortScanner *scanner = malloc(sizeof(PortScanner));
     if (!scanner) return NULL;
     
-    strncpy(scanner->target_host, target_host, sizeof(scanner->target_host) - 1);
-    scanner->target_host[sizeof(scanner->target_host) - 1] = '\0';
-    scanner->timeout = timeout;
+    scanner->target_spec = strdup(target_spec);
+    scanner->hosts = host_table_create();
+    if (!scanner->target_spec || !scanner->hosts ||
+        host_table_parse(scanner->hosts, target_spec) != 0) {
+        host_table_destroy(scanner->hosts);
+        free(scanner->target_spec);
+        free(scanner);
+        return NULL;
+    }
+    
+    scanner->timeout_ms = timeout_ms;
+    scanner->max_retries = SCAN_ENGINE_DEFAULT_RETRIES;
+    scanner->max_inflight = SCAN_ENGINE_DEFAULT_INFLIGHT;
+    scanner->engine = SCAN_ENGINE_EPOLL;
+    scanner->use_netlink = 1;
+    scanner->random_order = 0;
+    scanner->seed = 0;
+    scanner->scan_round = 0;
+    scanner->rate = 0;
+    scanner->congestion = 0;
+    scanner->pacer = NULL;
+    scanner->fds = NULL;
+    scanner->stats = NULL;
+    scanner->running = NULL;
+    scanner->port_spec = NULL;
+    scanner->checkpoint_path = NULL;
+    scanner->resume = NULL;
+    scanner->interrupted = 0;
+    scanner->quiet = 0;
+    scanner->history = NULL;
+    scanner->grab_banners = 0;
+    scanner->matcher = NULL;
+    scanner->banners = NULL;
+    scanner->banner_count = 0;
     scanner->alert_manager = alert_manager;
-    scanner->previous_open_ports = NULL;
-    scanner->previous_count = 0;
     scanner->first_scan = 1;
+    scanner->subscriber_count = 0;
+    scanner->event_mask = 0;
+    
+    // Las alertas son un consumidor más de los puertos clasificados
+    if (alert_manager) {
+        port_scanner_subscribe(scanner, SCAN_EVENT_MASK(SCAN_EVENT_PORT), alert_on_port, alert_manager);
+    }
     
     return scanner;
 }
 
 void port_scanner_destroy(PortScanner *scanner) {
     if (scanner) {
-        if (scanner->previous_open_ports) {
-            free(scanner->previous_open_ports);
-        }
+        scan_pacer_destroy(scanner->pacer);
+        service_matcher_destroy(scanner->matcher);
+        free(scanner->banners);
+        scan_checkpoint_destroy(scanner->resume);
+        host_table_destroy(scanner->hosts);
+        free(scanner->target_spec);
         free(scanner);
     }
 }
 
-int port_scanner_scan(PortScanner *scanner, const char *port_range_string) {
-    int port_count;
-    int *ports = parse_port_range(port_range_string, &port_count);
+// Registra un consumidor de eventos; devuelve -1 si no quedan huecos
+int port_scanner_subscribe(PortScanner *scanner, unsigned int mask, ScanEventCallback callback,
+                           void *user_data) {
+    if (!scanner || !callback || scanner->subscriber_count >= PORT_SCANNER_MAX_SUBSCRIBERS) return -1;
     
-    if (!ports || port_count == 0) {
-        printf("[ERROR] Rango de puertos inválido\n");
-        return -1;
+    ScanSubscriber *subscriber = &scanner->subscribers[scanner->subscriber_count++];
+    subscriber->mask = mask;
+    subscriber->callback = callback;
+    subscriber->user_data = user_data;
+    scanner->event_mask |= mask;
+    return 0;
+}
+
+// Renueva los nombres vencidos y comunica los cambios; devuelve cuántas entradas cambiaron
+static int refresh_hosts(PortScanner *scanner) {
+    HostTable *hosts = scanner->hosts;
+    int changed = host_table_refresh(hosts, time(NULL));
+    
+    for (int i = 0; i < hosts->change_count; i++) {
+        const HostChange *change = &hosts->changes[i];
+        const ScanHost *entry = &hosts->hosts[change->host];
+        char address[HOST_TABLE_FORMAT_SIZE];
+        host_table_address(entry, address, sizeof(address));
+        
+        switch (change->kind) {
+            case HOST_CHANGE_REPLACED:
+                scan_log(scanner, SCAN_LOG_INFO, "%s ahora resuelve a %s (antes %s)",
+                         entry->name, address, change->previous);
+                break;
+            case HOST_CHANGE_ADDED:
+                scan_log(scanner, SCAN_LOG_INFO, "%s resuelve además a %s", entry->name, address);
+                break;
+            case HOST_CHANGE_UNRESOLVED:
+                scan_log(scanner, SCAN_LOG_WARNING, "No se pudo renovar la resolución de %s (%s); "
+                         "se conservan sus direcciones", entry->name, gai_strerror(change->error));
+                break;
+        }
     }
+    return changed;
+}
+
+// Devuelve cuántos hosts tenían historial o -1 sin memoria
+static int load_history_baseline(PortScanner *scanner) {
+    HostTable *hosts = scanner->hosts;
+    PortSet *state = malloc(sizeof(PortSet));
+    if (!state) return -1;
     
-    printf("[INFO] Escaneando %d puertos en %s...\n", port_count, scanner->target_host);
+    int restored = 0;
+    int damaged = 0;
+    time_t latest = 0;
+    for (int h = 0; h < hosts->count; h++) {
+        ScanHost *entry = &hosts->hosts[h];
+        time_t since;
+        int found = scan_history_at(scanner->history, entry, SCAN_HISTORY_LATEST, state, &since);
+        if (found < 0) {
+            damaged++;
+            continue;
+        }
+        if (found == 0) continue;
+        restored++;
+        if (since > latest) latest = since;
+        
+        if (port_set_next(state, 0) >= 0 && !entry->previous_open) {
+            entry->previous_open = state;
+            state = malloc(sizeof(PortSet));
+            if (!state) return -1;
+        }
+    }
+    free(state);
     
-    // Arrays para resultados
-    int *results = calloc(port_count, sizeof(int));
-    int *open_ports = malloc(port_count * sizeof(int));
-    int open_count = 0;
+    if (damaged > 0) {
+        scan_log(scanner, SCAN_LOG_WARNING, "Historial dañado o ilegible para %d hosts (se toman como nuevos)",
+                 damaged);
+    }
+    if (restored > 0) {
+        char time_str[64];
+        strftime(time_str, sizeof(time_str), "%Y-%m-%d %H:%M:%S", localtime(&latest));
+        scan_log(scanner, SCAN_LOG_INFO, "Historial: línea base de %d hosts recuperada (último cambio %s)",
+                 restored, time_str);
+        scanner->first_scan = 0;
+    }
+    return restored;
+}
+
+// Diferencias del host contra el escaneo anterior; devuelve 1 si hubo cambios
+static int report_host_changes(PortScanner *scanner, int host, const PortSet *ports,
+                               const char *address) {
+    static const PortSet empty_set;
+    ScanHost *entry = &scanner->hosts->hosts[host];
+    const PortSet *before = entry->previous_open ? entry->previous_open : &empty_set;
+    const PortSet *after = entry->current_open ? entry->current_open : &empty_set;
     
-    // Escanear puertos (limitando threads para evitar sobrecargar el sistema)
-    const int MAX_THREADS = 50;
-    int active_threads = 0;
+    // Sin puertos abiertos antes ni ahora no puede haber cambios
+    if (!entry->previous_open && !entry->current_open) return 0;
+    
+    PortSet *changes = malloc(2 * sizeof(PortSet));
+    if (!changes) return -1;
+    PortSet *new_ports = &changes[0];
+    PortSet *closed_ports = &changes[1];
+    
+    int changed = port_set_diff(before, after, ports, new_ports, closed_ports);
+    if (changed) {
+        ScanEvent event;
+        init_event(&event, SCAN_EVENT_CHANGES, host, 0);
+        event.opened = new_ports;
+        event.closed = closed_ports;
+        event.text = address;
+        emit_event(scanner, &event);
+    }
+    free(changes);
+    return changed;
+}
+
+// Clasificar y registrar los puertos abiertos de un host
+static void report_host_ports(PortScanner *scanner, int host, const PortSet *open_set,
+                              const char *host_suffix, const ListenerInfo *listeners, int listener_count) {
+    const char *protocol = scanner->engine == SCAN_ENGINE_UDP ? "udp" : "tcp";
+    if (!wants_event(scanner, SCAN_EVENT_PORT)) return;
     
-    for (int i = 0; i < port_count; i++) {
-        results[i] = scan_single_port(scanner->target_host, ports[i], scanner->timeout);
+    for (int port = port_set_next(open_set, 0); port >= 0; port = port_set_next(open_set, port + 1)) {
+        const PortClass *entry = port_classifier_lookup(port);
+        const char *description = port_classifier_string(entry->string_id);
+        const char *service = (entry->flags & PORT_FLAG_SERVICE) && description ? description : "Desconocido";
+        const char *suspicious_desc = (entry->flags & PORT_FLAG_SUSPICIOUS) ? description : NULL;
+        AlertLevel alert_level = (AlertLevel)entry->severity;
+        
+        // Servicio identificado por su banner, si se hizo esa fase
+        const BannerResult *banner = banner_find(scanner->banners, scanner->banner_count, host, port);
+        const char *identified = banner ? service_matcher_name(scanner->matcher, banner->signature) : NULL;
+        
+        const char *status = alert_level == ALERT_HIGH ? "ALERTA" :
+                             alert_level == ALERT_MEDIUM ? "ADVERTENCIA" : "OK";
+        
+        char message[512];
+        int written;
+        if (suspicious_desc) {
+            written = snprintf(message, sizeof(message), "[%s] Puerto %d/%s%s abierto (%s)", 
+                               status, port, protocol, host_suffix, suspicious_desc);
+        } else {
+            written = snprintf(message, sizeof(message), "[%s] Puerto %d/%s%s (%s) abierto", 
+                               status, port, protocol, host_suffix, service);
+        }
         
-        if (results[i]) {
-            open_ports[open_count] = ports[i];
-            open_count++;
+        // Con sock_diag se conoce el proceso dueño del puerto
+        const ListenerInfo *owner = listener_diag_find(listeners, listener_count, port);
+        if (owner && owner->pid > 0 && written > 0 && (size_t)written < sizeof(message)) {
+            written += snprintf(message + written, sizeof(message) - written, " - proceso %s (PID %d)",
+                                owner->process, owner->pid);
+        }
+        if (identified && written > 0 && (size_t)written < sizeof(message)) {
+            written += snprintf(message + written, sizeof(message) - written, " - identificado: %s",
+                                identified);
+        }
+        if (banner && banner->banner[0] && written > 0 && (size_t)written < sizeof(message)) {
+            snprintf(message + written, sizeof(message) - written, " [%s]", banner->banner);
         }
         
-        // Mostrar progreso cada 100 puertos
-        if ((i + 1) % 100 == 0 || i == port_count - 1) {
-            printf("[INFO] Progreso: %d/%d puertos escaneados\n", i + 1, port_count);
+        char address[HOST_TABLE_FORMAT_SIZE];
+        ScanEvent event;
+        init_event(&event, SCAN_EVENT_PORT, host, port);
+        event.address = host_table_format(&scanner->hosts->hosts[host], address, sizeof(address));
+        event.level = alert_level;
+        event.protocol = protocol;
+        event.service = service;
+        event.suspicious = suspicious_desc;
+        event.identified = identified;
+        event.banner = banner && banner->banner[0] ? banner->banner : NULL;
+        event.process = owner && owner->pid > 0 ? owner->process : NULL;
+        event.pid = owner ? owner->pid : 0;
+        event.text = message;
+        emit_event(scanner, &event);
+    }
+}
+
+int port_scanner_scan(PortScanner *scanner, const PortSet *ports) {
+    int port_count = ports ? port_set_count(ports) : 0;
+    
+    if (port_count == 0) {
+        scan_log(scanner, SCAN_LOG_ERROR, "Rango de puertos inválido");
+        return -1;
+    }
+    
+    HostTable *hosts = scanner->hosts;
+    
+    // En modo continuo los nombres se vuelven a resolver al caducar su resolución
+    if (!scanner->first_scan && refresh_hosts(scanner) > 0 &&
+        scanner->pacer && scanner->pacer->host_count != hosts->count) {
+        scan_pacer_destroy(scanner->pacer);
+        scanner->pacer = NULL;
+    }
+    int multi_host = hosts->count > 1;
+    
+    // Una falta de descriptores del escaneo anterior no limita éste
+    fd_budget_reset(scanner->fds);
+    
+    // Arranque en caliente: la línea base del primer escaneo sale del historial
+    if (scanner->first_scan && scanner->history && load_history_baseline(scanner) < 0) {
+        return -1;
+    }
+    
+    // En los ciclos del planificador el ciclo ya se anunció
+    if (!scanner->quiet && wants_event(scanner, SCAN_EVENT_START)) {
+        ScanEvent event;
+        init_event(&event, SCAN_EVENT_START, -1, 0);
+        event.total = (uint64_t)port_count * hosts->count;
+        event.host_count = hosts->count;
+        event.port_count = port_count;
+        event.text = scanner->target_spec;
+        emit_event(scanner, &event);
+    }
+    
+    for (int h = 0; h < hosts->count; h++) {
+        free(hosts->hosts[h].current_open);
+        hosts->hosts[h].current_open = NULL;
+        hosts->hosts[h].unanswered = 0;
+    }
+    int udp = scanner->engine == SCAN_ENGINE_UDP;
+    
+    // El volcado sock_diag sólo describe esta máquina: se usa con un único objetivo local
+    ListenerInfo *listeners = NULL;
+    int listener_count = 0;
+    const struct sockaddr *local = (const struct sockaddr*)&hosts->hosts[0].addr;
+    int use_netlink = scanner->use_netlink && !multi_host && listener_diag_is_local(local);
+    
+    if (use_netlink) {
+        hosts->hosts[0].current_open = calloc(1, sizeof(PortSet));
+        if (!hosts->hosts[0].current_open) {
+            return -1;
+        }
+        if (scan_local_listeners(local, udp ? IPPROTO_UDP : IPPROTO_TCP,
+                                 ports, hosts->hosts[0].current_open,
+                                 &listeners, &listener_count) != 0) {
+            scan_log(scanner, SCAN_LOG_WARNING, "sock_diag no disponible, usando sondas %s",
+                     udp ? "UDP" : "TCP");
+            use_netlink = 0;
+        } else if (!scanner->quiet && wants_event(scanner, SCAN_EVENT_PROGRESS)) {
+            ScanEvent event;
+            init_event(&event, SCAN_EVENT_PROGRESS, -1, 0);
+            event.completed = (uint64_t)port_count;
+            event.total = (uint64_t)port_count;
+            event.text = "sock_diag";
+            emit_event(scanner, &event);
         }
     }
     
-    // Detectar cambios desde el último escaneo
-    if (!scanner->first_scan && scanner->previous_open_ports) {
-        int new_ports[1024], closed_ports[1024];
-        int new_count = 0, closed_count = 0;
+    if (!use_netlink) {
+        // Escanear hosts x puertos con el motor elegido (ventana de conexiones compartida)
+        ScanPlan plan;
+        if (scan_plan_init(&plan, ports, hosts->count) != 0) {
+            return -1;
+        }
+        if (scanner->random_order) {
+            scan_plan_randomize(&plan, scanner->seed + scanner->scan_round);
+        }
         
-        // Encontrar nuevos puertos
-        for (int i = 0; i < open_count; i++) {
-            int found = 0;
-            for (int j = 0; j < scanner->previous_count; j++) {
-                if (open_ports[i] == scanner->previous_open_ports[j]) {
-                    found = 1;
-                    break;
-                }
-            }
-            if (!found) {
-                new_ports[new_count++] = open_ports[i];
+        ScanProgress progress;
+        progress.scanner = scanner;
+        progress.hosts = hosts;
+        progress.plan = &plan;
+        scan_tracker_init(&progress.tracker);
+        progress.last_checkpoint = time(NULL);
+        progress.completed = 0;
+        progress.total = plan.total;
+        progress.report_every = plan.total / 100 > 100 ? plan.total / 100 : 100;
+        progress.failed = 0;
+        progress.socket_errors = 0;
+        
+        // Reanudar: resultados parciales y sondas pendientes del checkpoint
+        if (scanner->resume) {
+            int restored = scan_checkpoint_restore(scanner->resume, hosts, &plan, &progress.tracker);
+            scan_checkpoint_destroy(scanner->resume);
+            scanner->resume = NULL;
+            if (restored != 0) {
+                scan_log(scanner, SCAN_LOG_ERROR, "El checkpoint no corresponde a estos objetivos y puertos");
+                scan_plan_destroy(&plan);
+                return -1;
             }
+            progress.completed = progress.tracker.completed;
+            scan_log(scanner, SCAN_LOG_INFO, "Reanudando: %llu/%llu sondas ya completadas",
+                     (unsigned long long)progress.completed, (unsigned long long)plan.total);
         }
         
-        // Encontrar puertos cerrados
-        for (int i = 0; i < scanner->previous_count; i++) {
-            int found = 0;
-            for (int j = 0; j < open_count; j++) {
-                if (scanner->previous_open_ports[i] == open_ports[j]) {
-                    found = 1;
-                    break;
-                }
+        if (!scanner->pacer && (scanner->rate > 0 || scanner->congestion || udp)) {
+            // En UDP, sin --rate, ir al ritmo al que el kernel genera ICMP de puerto cerrado
+            double rate = scanner->rate;
+            if (udp && rate <= 0) {
+                rate = scan_engine_udp_icmp_rate();
+                scan_log(scanner, SCAN_LOG_INFO, "UDP: tasa limitada a %.0f sondas/s (límite ICMP del kernel)",
+                         rate);
             }
-            if (!found) {
-                closed_ports[closed_count++] = scanner->previous_open_ports[i];
+            scanner->pacer = scan_pacer_create(hosts->count, rate, scanner->congestion,
+                                               scanner->max_inflight);
+            if (!scanner->pacer) {
+                scan_tracker_destroy(&progress.tracker);
+                scan_plan_destroy(&plan);
+                return -1;
             }
         }
         
-        // Mostrar cambios
-        if (new_count > 0) {
-            printf("\n[CAMBIO] Nuevos puertos abiertos: ");
-            for (int i = 0; i < new_count; i++) {
-                printf("%d%s", new_ports[i], i < new_count - 1 ? "," : "");
-            }
-            printf("\n");
+        ScanEngineOptions options;
+        options.max_inflight = scanner->max_inflight;
+        options.timeout_ms = scanner->timeout_ms;
+        options.max_retries = scanner->max_retries;
+        options.pacer = scanner->pacer;
+        options.fds = scanner->fds;
+        options.stats = scanner->stats;
+        options.running = scanner->running;
+        
+        ScanEngineType used_engine;
+        uint64_t started_us = rtt_now_us();
+        uint64_t completed_before = progress.completed;
+        int status = scan_engine_run(scanner->engine, hosts, &plan, &options,
+                                     collect_scan_result, &progress, &used_engine);
+        if (scanner->pacer) {
+            scanner->pacer->plan = NULL;
+        }
+        if (scanner->stats) {
+            scanner->stats->elapsed_us += rtt_now_us() - started_us;
+            scanner->stats->probes += progress.completed - completed_before;
         }
         
-        if (closed_count > 0) {
-            printf("[CAMBIO] Puertos cerrados: ");
-            for (int i = 0; i < closed_count; i++) {
-                printf("%d%s", closed_ports[i], i < closed_count - 1 ? "," : "");
-            }
-            printf("\n");
+        // Ciclo parcial interrumpido: no hay barrido que reanudar
+        if (status == 0 && !progress.failed && scan_engine_stopped(&options) &&
+            progress.tracker.completed < plan.total && scanner->quiet) {
+            scanner->interrupted = 1;
+            scan_tracker_destroy(&progress.tracker);
+            scan_plan_destroy(&plan);
+            return 0;
         }
         
-        if (new_count == 0 && closed_count == 0) {
-            printf("[INFO] Sin cambios detectados\n");
+        // Interrumpido: guardar el progreso y no analizar un escaneo incompleto
+        if (status == 0 && !progress.failed && scan_engine_stopped(&options) &&
+            progress.tracker.completed < plan.total) {
+            const char *path = scanner->checkpoint_path ? scanner->checkpoint_path : SCAN_CHECKPOINT_DEFAULT_PATH;
+            if (save_checkpoint(scanner, &plan, &progress.tracker, path) == 0) {
+                scan_log(scanner, SCAN_LOG_INFO,
+                         "Escaneo interrumpido: %llu/%llu sondas completadas, progreso guardado en %s",
+                         (unsigned long long)progress.tracker.completed, (unsigned long long)plan.total, path);
+                scan_log(scanner, SCAN_LOG_INFO, "Para continuar: --resume %s", path);
+            } else {
+                scan_log(scanner, SCAN_LOG_ERROR, "Escaneo interrumpido y no se pudo guardar el checkpoint en %s",
+                         path);
+            }
+            scanner->interrupted = 1;
+            scan_tracker_destroy(&progress.tracker);
+            scan_plan_destroy(&plan);
+            return 0;
+        }
+        scan_tracker_destroy(&progress.tracker);
+        scan_plan_destroy(&plan);
+        if (status != 0 || progress.failed) {
+            scan_log(scanner, SCAN_LOG_ERROR, "No se pudo inicializar el motor de escaneo");
+            return -1;
+        }
+        // Barrido completo: el checkpoint ya no hace falta
+        if (scanner->checkpoint_path) {
+            unlink(scanner->checkpoint_path);
+        }
+        if (used_engine != scanner->engine) {
+            scan_log(scanner, SCAN_LOG_WARNING,
+                     "Motor '%s' no disponible (kernel, privilegios o IPv6), usando '%s'",
+                     scan_engine_type_to_string(scanner->engine), scan_engine_type_to_string(used_engine));
+            scanner->engine = used_engine;
+        }
+        if (progress.socket_errors > 0) {
+            scan_log(scanner, SCAN_LOG_WARNING, "%llu sondas sin socket o sin enviar (error local, su estado no se conoce; "
+                     "no se cuentan como cerradas)", (unsigned long long)progress.socket_errors);
+        }
+        if (scanner->fds && scanner->fds->exhausted > 0) {
+            scan_log(scanner, SCAN_LOG_INFO,
+                     "Descriptores agotados %llu veces: sondas reencoladas, capacidad ajustada a %d",
+                     scanner->fds->exhausted, scanner->fds->capacity);
+        }
+        if (scanner->congestion) {
+            scan_log(scanner, SCAN_LOG_INFO,
+                     "Control de congestión: ventana %.0f sondas, %llu pérdidas / %llu respuestas",
+                     scanner->pacer->global.cwnd, scanner->pacer->losses, scanner->pacer->responses);
         }
     }
     
-    // Analizar puertos abiertos
-    if (open_count > 0) {
-        printf("\n[RESULTADO] %d puertos abiertos encontrados:\n", open_count);
-        
-        for (int i = 0; i < open_count; i++) {
-            int port = open_ports[i];
-            const char *service = get_service_name(port);
-            const char *suspicious_desc = get_suspicious_description(port);
-            
-            const char *status;
-            const char *emoji;
-            AlertLevel alert_level;
-            
-            if (suspicious_desc) {
-                status = "ALERTA";
-                emoji = "🔴";
-                alert_level = ALERT_HIGH;
-            } else if (port > 1024 && strcmp(service, "Desconocido") == 0) {
-                status = "ADVERTENCIA";
-                emoji = "🟡";
-                alert_level = ALERT_MEDIUM;
-            } else if (strcmp(service, "Desconocido") == 0) {
-                status = "ADVERTENCIA";
-                emoji = "🟡";
-                alert_level = ALERT_MEDIUM;
-            } else {
-                status = "OK";
-                emoji = "🟢";
-                alert_level = ALERT_LOW;
+    // Identificar servicios leyendo el banner de cada puerto abierto
+    free(scanner->banners);
+    scanner->banners = NULL;
+    scanner->banner_count = 0;
+    if (scanner->grab_banners && !udp) {
+        if (!scanner->matcher) {
+            scanner->matcher = service_matcher_create();
+        }
+        if (!scanner->matcher ||
+            banner_grab(hosts, scanner->matcher, scanner->fds, scanner->max_inflight, scanner->timeout_ms,
+                        scanner->running, &scanner->banners, &scanner->banner_count) != 0) {
+            scan_log(scanner, SCAN_LOG_WARNING, "No se pudieron leer los banners de los servicios");
+        } else if (scanner->banner_count > 0) {
+            int identified = 0;
+            for (int i = 0; i < scanner->banner_count; i++) {
+                if (scanner->banners[i].signature >= 0) identified++;
             }
+            scan_log(scanner, SCAN_LOG_INFO, "Servicios identificados por banner: %d/%d puertos abiertos",
+                     identified, scanner->banner_count);
+        }
+    }
+    
+    // Detectar cambios desde el último escaneo (solo entre los puertos sondeados)
+    if (!scanner->first_scan) {
+        int any_change = 0;
+        for (int h = 0; h < hosts->count; h++) {
+            char address[HOST_TABLE_FORMAT_SIZE];
+            host_table_format(&hosts->hosts[h], address, sizeof(address));
             
-            char message[512];
-            if (suspicious_desc) {
-                snprintf(message, sizeof(message), "[%s] Puerto %d/tcp abierto (%s)", 
-                        status, port, suspicious_desc);
-            } else {
-                snprintf(message, sizeof(message), "[%s] Puerto %d/tcp (%s) abierto", 
-                        status, port, service);
+            int changed = report_host_changes(scanner, h, ports, multi_host ? address : NULL);
+            if (changed < 0) {
+                free(listeners);
+                return -1;
             }
+            any_change |= changed;
+        }
+        if (!any_change && !scanner->quiet) {
+            scan_log(scanner, SCAN_LOG_INFO, "Sin cambios detectados");
+        }
+    }
+    
+    // Ciclos del planificador: clasificar y alertar sólo los puertos recién abiertos
+    int partial = scanner->quiet && !scanner->first_scan;
+    if (partial) {
+        PortSet *fresh = malloc(sizeof(PortSet));
+        if (!fresh) {
+            free(listeners);
+            return -1;
+        }
+        for (int h = 0; h < hosts->count; h++) {
+            ScanHost *entry = &hosts->hosts[h];
+            if (!entry->current_open) continue;
+            *fresh = *entry->current_open;
+            if (entry->previous_open) {
+                port_set_difference(fresh, entry->previous_open);
+            }
+            if (port_set_next(fresh, 0) < 0) continue;
             
-            printf("%s %s\n", emoji, message);
-            
-            // Registrar alerta si es necesario
-            if (scanner->alert_manager && (alert_level == ALERT_HIGH || alert_level == ALERT_MEDIUM)) {
-                Alert alert;
-                alert.level = alert_level;
-                strncpy(alert.message, message, sizeof(alert.message) - 1);
-                alert.message[sizeof(alert.message) - 1] = '\0';
-                alert.port = port;
-                strncpy(alert.service, suspicious_desc ? suspicious_desc : service, sizeof(alert.service) - 1);
-                alert.service[sizeof(alert.service) - 1] = '\0';
-                alert.timestamp = time(NULL);
-                
-                alert_manager_add_alert(scanner->alert_manager, &alert);
+            char address[HOST_TABLE_FORMAT_SIZE];
+            char host_suffix[HOST_TABLE_FORMAT_SIZE + 8] = "";
+            if (multi_host) {
+                snprintf(host_suffix, sizeof(host_suffix), " en %s",
+                         host_table_format(entry, address, sizeof(address)));
             }
+            report_host_ports(scanner, h, fresh, host_suffix, listeners, listener_count);
         }
-    } else {
-        printf("\n[INFO] No se encontraron puertos abiertos\n");
+        free(fresh);
     }
     
-    // Actualizar estado anterior
-    if (scanner->previous_open_ports) {
-        free(scanner->previous_open_ports);
+    // Analizar puertos abiertos
+    int hosts_with_open = 0;
+    for (int h = 0; h < hosts->count && !partial; h++) {
+        ScanHost *entry = &hosts->hosts[h];
+        int open_count = entry->current_open ? port_set_count(entry->current_open) : 0;
+        if (open_count == 0) continue;
+        hosts_with_open++;
+        
+        char address[HOST_TABLE_FORMAT_SIZE];
+        char host_suffix[HOST_TABLE_FORMAT_SIZE + 8] = "";
+        if (multi_host) {
+            host_table_format(entry, address, sizeof(address));
+            snprintf(host_suffix, sizeof(host_suffix), " en %s", address);
+        }
+        if (wants_event(scanner, SCAN_EVENT_HOST)) {
+            ScanEvent event;
+            init_event(&event, SCAN_EVENT_HOST, h, 0);
+            event.port_count = open_count;
+            event.text = multi_host ? address : NULL;
+            emit_event(scanner, &event);
+        }
+        report_host_ports(scanner, h, entry->current_open, host_suffix, listeners, listener_count);
     }
-    scanner->previous_open_ports = malloc(open_count * sizeof(int));
-    if (scanner->previous_open_ports) {
-        memcpy(scanner->previous_open_ports, open_ports, open_count * sizeof(int));
-        scanner->previous_count = open_count;
+    
+    // En UDP el silencio y los ICMP de filtrado son ambiguos: se resumen en lugar de listarse
+    for (int h = 0; h < hosts->count && !partial; h++) {
+        if (hosts->hosts[h].unanswered == 0) continue;
+        char address[HOST_TABLE_FORMAT_SIZE];
+        char host_suffix[HOST_TABLE_FORMAT_SIZE + 8] = "";
+        if (multi_host) {
+            snprintf(host_suffix, sizeof(host_suffix), " en %s",
+                     host_table_format(&hosts->hosts[h], address, sizeof(address)));
+        }
+        scan_log(scanner, SCAN_LOG_INFO, "%d puertos UDP sin respuesta o filtrados (open|filtered)%s",
+                 hosts->hosts[h].unanswered, host_suffix);
+    }
+    
+    // Actualizar estado anterior: los puertos no sondeados conservan su valor
+    time_t now = time(NULL);
+    int history_errors = 0;
+    for (int h = 0; h < hosts->count; h++) {
+        ScanHost *entry = &hosts->hosts[h];
+        if (entry->previous_open) {
+            port_set_difference(entry->previous_open, ports);
+            if (entry->current_open) {
+                port_set_union(entry->previous_open, entry->current_open);
+            }
+            free(entry->current_open);
+        } else {
+            entry->previous_open = entry->current_open;
+        }
+        entry->current_open = NULL;
+        
+        // Persistir el nuevo estado (sólo se escribe si cambió)
+        if (scanner->history && scan_history_record(scanner->history, entry, now, entry->previous_open) < 0) {
+            history_errors++;
+        }
+    }
+    if (history_errors > 0) {
+        scan_log(scanner, SCAN_LOG_WARNING, "No se pudo guardar el historial de %d hosts en %s",
+                 history_errors, scanner->history->directory);
     }
     scanner->first_scan = 0;
+    scanner->scan_round++;
+    
+    if (wants_event(scanner, SCAN_EVENT_END)) {
+        ScanEvent event;
+        init_event(&event, SCAN_EVENT_END, -1, 0);
+        event.completed = (uint64_t)port_count * hosts->count;
+        event.total = event.completed;
+        event.host_count = hosts->count;
+        event.open_hosts = hosts_with_open;
+        event.partial = partial;
+        emit_event(scanner, &event);
+    }
     
     // Limpieza
-    free(ports);
-    free(results);
-    free(open_ports);
+    free(listeners);
     
     return 0;
 }
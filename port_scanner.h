@@ -5,34 +5,118 @@
 #ifndef PORT_SCANNER_H
 #define PORT_SCANNER_H
 
+#include <stdint.h>
+#include <time.h>
 #include "alert_manager.h"
+#include "port_set.h"
+#include "host_table.h"
+#include "scan_engine.h"
+#include "banner_grabber.h"
+#include "scan_checkpoint.h"
+#include "scan_history.h"
 
-typedef struct {
-    char target_host[256];
-    int timeout;
-    AlertManager *alert_manager;
-    int *previous_open_ports;
-    int previous_count;
-    int first_scan;
-} PortScanner;
+#define PORT_SCANNER_MAX_SUBSCRIBERS 8
+
+// Eventos que emite port_scanner_scan() a medida que avanza
+typedef enum {
+    SCAN_EVENT_START,       // Comienza un escaneo (total de sondas, hosts y puertos)
+    SCAN_EVENT_RESULT,      // Resultado de una sonda según llega (camino caliente)
+    SCAN_EVENT_PROGRESS,    // Cada 1% de las sondas (o cada 100)
+    SCAN_EVENT_CHANGES,     // Puertos abiertos y cerrados de un host desde el escaneo anterior
+    SCAN_EVENT_HOST,        // Un host con puertos abiertos; le siguen sus SCAN_EVENT_PORT
+    SCAN_EVENT_PORT,        // Puerto abierto ya clasificado (servicio, severidad, banner, proceso)
+    SCAN_EVENT_END,         // Fin del escaneo (no se emite si se interrumpió)
+    SCAN_EVENT_LOG          // Aviso de diagnóstico
+} ScanEventType;
+
+#define SCAN_EVENT_MASK(type) (1u << (type))
+#define SCAN_EVENT_ALL 0xffffffffu
+
+typedef enum {
+    SCAN_LOG_INFO,
+    SCAN_LOG_WARNING,
+    SCAN_LOG_ERROR
+} ScanLogLevel;
 
+// Los punteros sólo son válidos durante la llamada al callback
 typedef struct {
+    ScanEventType type;
+    int host;               // Índice en scanner->hosts (-1 si no aplica)
     int port;
-    const char *service;
-} ServiceMapping;
+    ScanResult result;      // RESULT
+    uint64_t completed;     // PROGRESS y END: sondas completadas
+    uint64_t total;         // START, PROGRESS y END: sondas del escaneo
+    int host_count;         // START y END
+    int port_count;         // START; HOST: puertos abiertos del host
+    int open_hosts;         // END: hosts con puertos abiertos
+    int partial;            // END: ciclo parcial (sólo se informaron puertos recién abiertos)
+    const PortSet *opened;  // CHANGES
+    const PortSet *closed;
+    AlertLevel level;       // PORT: severidad sugerida
+    const char *protocol;   // PORT: "tcp" o "udp"
+    const char *service;    // PORT: servicio por número de puerto ("Desconocido" si no hay)
+    const char *suspicious; // PORT: descripción de la amenaza (NULL si no es sospechoso)
+    const char *identified; // PORT: servicio identificado por banner (NULL si no se hizo)
+    const char *banner;     // PORT: primera línea del banner (NULL si no hay)
+    const char *address;    // PORT: dirección del host
+    const char *process;    // PORT: proceso dueño según sock_diag (NULL si no se conoce)
+    int pid;
+    ScanLogLevel log_level; // LOG
+    const char *text;       // START: objetivo; HOST y CHANGES: dirección (NULL con un solo
+                            // host); PORT: descripción completa; PROGRESS: método; LOG: mensaje
+    time_t timestamp;
+} ScanEvent;
+
+typedef void (*ScanEventCallback)(const ScanEvent *event, void *user_data);
 
 typedef struct {
-    int port;
-    const char *description;
-} SuspiciousPort;
+    unsigned int mask;      // SCAN_EVENT_MASK(...) de los eventos que interesan
+    ScanEventCallback callback;
+    void *user_data;
+} ScanSubscriber;
+
+typedef struct {
+    char *target_spec;      // Objetivos tal como se indicaron en --target
+    HostTable *hosts;       // Objetivos ya parseados con su estado por host
+    int timeout_ms;         // Tope del plazo adaptativo por sonda
+    int max_retries;        // Reintentos de sondas sin respuesta
+    int max_inflight;
+    ScanEngineType engine;
+    int use_netlink;        // Enumerar listeners vía sock_diag si el objetivo es local
+    int random_order;       // Recorrer host x puerto en una permutación aleatoria
+    uint64_t seed;          // Semilla de la permutación (reproducible)
+    unsigned int scan_round;    // Escaneos realizados; cada uno usa un orden distinto
+    double rate;            // Sondas por segundo (0 = sin límite)
+    int congestion;         // Ventanas AIMD por host y global
+    ScanPacer *pacer;       // Se conserva entre escaneos (ventanas y tokens aprendidos)
+    FdBudget *fds;          // Presupuesto de descriptores del proceso (NULL = sin control)
+    ProbeStats *stats;      // Tasa y latencias acumuladas de los motores (NULL = no medir)
+    volatile int *running;  // Bandera de SIGINT: al ponerse a 0 el escaneo se detiene
+    const char *port_spec;  // Puertos tal como se indicaron, para el checkpoint
+    const char *checkpoint_path;    // Checkpoint periódico (NULL = sólo al interrumpir)
+    ScanCheckpoint *resume; // Checkpoint a aplicar en el próximo escaneo (se consume)
+    int interrupted;        // El último escaneo se detuvo por una señal
+    int quiet;              // Escaneos parciales del planificador: sólo cambios, sin progreso
+    ScanHistory *history;   // Historial en disco: línea base al arrancar (NULL = sólo en memoria)
+    int grab_banners;       // Identificar servicios leyendo el banner de cada puerto abierto
+    ServiceMatcher *matcher;    // Autómata de firmas (se construye en el primer uso)
+    BannerResult *banners;  // Servicios identificados en el último escaneo
+    int banner_count;
+    AlertManager *alert_manager;
+    int first_scan;
+    ScanSubscriber subscribers[PORT_SCANNER_MAX_SUBSCRIBERS];
+    int subscriber_count;
+    unsigned int event_mask;    // Unión de las máscaras suscritas
+} PortScanner;
 
 // Funciones públicas
-PortScanner* port_scanner_create(const char *target_host, int timeout, AlertManager *alert_manager);
+PortScanner* port_scanner_create(const char *target_spec, int timeout_ms, AlertManager *alert_manager);
 void port_scanner_destroy(PortScanner *scanner);
-int port_scanner_scan(PortScanner *scanner, const char *port_range_string);
+int port_scanner_scan(PortScanner *scanner, const PortSet *ports);
+int port_scanner_subscribe(PortScanner *scanner, unsigned int mask, ScanEventCallback callback,
+                           void *user_data);
 
 // Funciones auxiliares
-int* parse_port_range(const char *port_string, int *count);
 int scan_single_port(const char *host, int port, int timeout);
 const char* get_service_name(int port);
 const char* get_suspicious_description(int port);
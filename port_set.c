@@ -0,0 +1,141 @@
+/*
+ * Port Set - Implementación del conjunto de puertos
+ *
+ * Todas las operaciones trabajan palabra a palabra (64 puertos por palabra):
+ * los rangos se rellenan con máscaras, el conteo usa popcount y la iteración
+ * salta palabras vacías y localiza el siguiente bit con ctz.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "port_set.h"
+
+void port_set_clear(PortSet *set) {
+    memset(set->bits, 0, sizeof(set->bits));
+}
+
+void port_set_add(PortSet *set, int port) {
+    if (port < 0 || port > PORT_SET_MAX_PORT) return;
+    set->bits[port >> 6] |= 1ULL << (port & 63);
+}
+
+void port_set_remove(PortSet *set, int port) {
+    if (port < 0 || port > PORT_SET_MAX_PORT) return;
+    set->bits[port >> 6] &= ~(1ULL << (port & 63));
+}
+
+int port_set_contains(const PortSet *set, int port) {
+    if (port < 0 || port > PORT_SET_MAX_PORT) return 0;
+    return (set->bits[port >> 6] >> (port & 63)) & 1;
+}
+
+void port_set_add_range(PortSet *set, int start, int end) {
+    if (start < 0) start = 0;
+    if (end > PORT_SET_MAX_PORT) end = PORT_SET_MAX_PORT;
+    if (start > end) return;
+
+    int first_word = start >> 6;
+    int last_word = end >> 6;
+    uint64_t first_mask = ~0ULL << (start & 63);
+    uint64_t last_mask = ~0ULL >> (63 - (end & 63));
+
+    if (first_word == last_word) {
+        set->bits[first_word] |= first_mask & last_mask;
+        return;
+    }
+
+    set->bits[first_word] |= first_mask;
+    for (int w = first_word + 1; w < last_word; w++) {
+        set->bits[w] = ~0ULL;
+    }
+    set->bits[last_word] |= last_mask;
+}
+
+int port_set_count(const PortSet *set) {
+    int count = 0;
+    for (int w = 0; w < PORT_SET_WORDS; w++) {
+        count += __builtin_popcountll(set->bits[w]);
+    }
+    return count;
+}
+
+void port_set_union(PortSet *dst, const PortSet *src) {
+    for (int w = 0; w < PORT_SET_WORDS; w++) {
+        dst->bits[w] |= src->bits[w];
+    }
+}
+
+void port_set_difference(PortSet *dst, const PortSet *src) {
+    for (int w = 0; w < PORT_SET_WORDS; w++) {
+        dst->bits[w] &= ~src->bits[w];
+    }
+}
+
+/*
+ * Diferencia entre dos estados restringida a los puertos de mask:
+ * added = (after & ~before) & mask, removed = (before & ~after) & mask.
+ * Es un único recorrido XOR/AND-NOT de 1024 palabras sin dependencias entre
+ * iteraciones, que el compilador vectoriza; el coste no depende de cuántos
+ * puertos estén abiertos. Devuelve 1 si hubo algún cambio.
+ */
+int port_set_diff(const PortSet *before, const PortSet *after, const PortSet *mask,
+                  PortSet *added, PortSet *removed) {
+    uint64_t any = 0;
+    for (int w = 0; w < PORT_SET_WORDS; w++) {
+        uint64_t changed = (before->bits[w] ^ after->bits[w]) & mask->bits[w];
+        added->bits[w] = changed & after->bits[w];
+        removed->bits[w] = changed & before->bits[w];
+        any |= changed;
+    }
+    return any != 0;
+}
+
+int port_set_next(const PortSet *set, int from) {
+    if (from < 0) from = 0;
+    if (from > PORT_SET_MAX_PORT) return -1;
+
+    int w = from >> 6;
+    uint64_t word = set->bits[w] & (~0ULL << (from & 63));
+    while (word == 0) {
+        if (++w >= PORT_SET_WORDS) return -1;
+        word = set->bits[w];
+    }
+    return (w << 6) + __builtin_ctzll(word);
+}
+
+int port_set_parse(const char *port_string, PortSet *set) {
+    if (!port_string || !set) return -1;
+
+    port_set_clear(set);
+
+    char *str_copy = strdup(port_string);
+    if (!str_copy) return -1;
+
+    char *saveptr = NULL;
+    char *token = strtok_r(str_copy, ",", &saveptr);
+    while (token != NULL) {
+        // Remover espacios
+        while (*token == ' ') token++;
+
+        int start, end;
+        if (strchr(token, '-') != NULL) {
+            // Rango de puertos
+            if (sscanf(token, "%d-%d", &start, &end) == 2) {
+                if (start < 1) start = 1;
+                port_set_add_range(set, start, end);
+            }
+        } else {
+            // Puerto individual
+            start = atoi(token);
+            if (start > 0 && start <= PORT_SET_MAX_PORT) {
+                port_set_add(set, start);
+            }
+        }
+
+        token = strtok_r(NULL, ",", &saveptr);
+    }
+
+    free(str_copy);
+    return port_set_count(set) > 0 ? 0 : -1;
+}
@@ -0,0 +1,33 @@
+/*
+ * Port Set - Conjunto de puertos TCP/UDP como mapa de bits de 65536 bits
+ */
+
+#ifndef PORT_SET_H
+#define PORT_SET_H
+
+#include <stdint.h>
+
+#define PORT_SET_MAX_PORT 65535
+#define PORT_SET_WORDS 1024     // 65536 bits / 64
+
+typedef struct {
+    uint64_t bits[PORT_SET_WORDS];
+} PortSet;
+
+// Funciones públicas
+int port_set_parse(const char *port_string, PortSet *set);
+void port_set_clear(PortSet *set);
+void port_set_add(PortSet *set, int port);
+void port_set_add_range(PortSet *set, int start, int end);
+void port_set_remove(PortSet *set, int port);
+int port_set_contains(const PortSet *set, int port);
+int port_set_count(const PortSet *set);
+void port_set_union(PortSet *dst, const PortSet *src);
+void port_set_difference(PortSet *dst, const PortSet *src);
+int port_set_diff(const PortSet *before, const PortSet *after, const PortSet *mask,
+                  PortSet *added, PortSet *removed);
+
+// Iteración ascendente: for (p = port_set_next(s, 0); p >= 0; p = port_set_next(s, p + 1))
+int port_set_next(const PortSet *set, int from);
+
+#endif
@@ -0,0 +1,27 @@
+/*
+ * Probe Stats - Latencia por sonda y tasa del escáner (--stats, make bench-scan)
+ */
+
+#ifndef PROBE_STATS_H
+#define PROBE_STATS_H
+
+#include <stdint.h>
+
+#define PROBE_STATS_SUB_BITS 4      // 16 intervalos por potencia de dos (error < 6,25%)
+#define PROBE_STATS_BUCKETS ((32 - PROBE_STATS_SUB_BITS + 1) << PROBE_STATS_SUB_BITS)
+
+typedef struct {
+    uint64_t buckets[PROBE_STATS_BUCKETS];  // Histograma log-lineal en microsegundos
+    uint64_t samples;       // Sondas con respuesta (SYN-ACK o RST)
+    uint64_t probes;        // Sondas resueltas, con o sin respuesta
+    uint64_t elapsed_us;    // Tiempo dentro de los motores
+    uint64_t max_us;
+} ProbeStats;
+
+// Funciones públicas
+void probe_stats_init(ProbeStats *stats);
+void probe_stats_record(ProbeStats *stats, uint64_t latency_us);
+uint64_t probe_stats_percentile(const ProbeStats *stats, double percentile);
+double probe_stats_rate(const ProbeStats *stats);
+
+#endif
@@ -26,6 +26,35 @@ void report_generator_destroy(ReportGenerator *generator) {
     }
 }
 
+typedef struct {
+    FILE *file;
+    const char *css_class;
+} HtmlSection;
+
+static void write_html_alert(const AlertRecord *alert, void *user_data) {
+    HtmlSection *section = (HtmlSection*)user_data;
+    FILE *file = section->file;
+    
+    char alert_time_str[64];
+    struct tm *alert_tm_info = localtime(&alert->first_seen);
+    strftime(alert_time_str, sizeof(alert_time_str), "%H:%M:%S", alert_tm_info);
+    
+    fprintf(file, "            <div class=\"alert-item %s\">\n", section->css_class);
+    fprintf(file, "                <div class=\"alert-header\">%s</div>\n", alert->message);
+    fprintf(file, "                <div class=\"alert-details\">\n");
+    fprintf(file, "                    <strong>Puerto:</strong> %d | ", alert->port);
+    fprintf(file, "                    <strong>Servicio:</strong> %s | ", alert->service);
+    fprintf(file, "                    <strong>Hora:</strong> %s", alert_time_str);
+    if (alert->count > 1) {
+        strftime(alert_time_str, sizeof(alert_time_str), "%H:%M:%S", localtime(&alert->last_seen));
+        fprintf(file, " | <strong>Veces:</strong> %u | ", alert->count);
+        fprintf(file, "<strong>Última:</strong> %s", alert_time_str);
+    }
+    fprintf(file, "\n");
+    fprintf(file, "                </div>\n");
+    fprintf(file, "            </div>\n");
+}
+
 int generate_html_report(ReportGenerator *generator, const char *target, 
                         const char *port_range, const char *html_path) {
     if (!generator || !target || !port_range || !html_path) return -1;
@@ -86,6 +115,7 @@ int generate_html_report(ReportGenerator *generator, const char *target,
     
     // Resumen de alertas
     AlertManager *manager = generator->alert_manager;
+    alert_manager_drain(manager);
     fprintf(file, "        <div class=\"summary\">\n");
     fprintf(file, "            <div class=\"summary-item summary-total\">\n");
     fprintf(file, "                <h3>%d</h3>\n", manager->total_alerts);
@@ -111,39 +141,19 @@ int generate_html_report(ReportGenerator *generator, const char *target,
         const char* priority_names[] = {"🔴 Alertas Críticas", "🟡 Alertas Medias", "🟢 Alertas Bajas"};
         const char* css_classes[] = {"alert-high", "alert-medium", "alert-low"};
         
+        AlertQuery query;
+        alert_query_init(&query);
+        
         for (int p = 0; p < 3; p++) {
             AlertLevel priority = priorities[p];
-            int found_any = 0;
-            
-            // Contar alertas de esta prioridad
-            AlertNode *current = manager->head;
-            while (current) {
-                if (current->alert.level == priority) {
-                    if (!found_any) {
-                        fprintf(file, "        <div class=\"alert-section\">\n");
-                        fprintf(file, "            <h3>%s</h3>\n", priority_names[p]);
-                        found_any = 1;
-                    }
-                    
-                    char alert_time_str[64];
-                    struct tm *alert_tm_info = localtime(&current->alert.timestamp);
-                    strftime(alert_time_str, sizeof(alert_time_str), "%H:%M:%S", alert_tm_info);
-                    
-                    fprintf(file, "            <div class=\"alert-item %s\">\n", css_classes[p]);
-                    fprintf(file, "                <div class=\"alert-header\">%s</div>\n", current->alert.message);
-                    fprintf(file, "                <div class=\"alert-details\">\n");
-                    fprintf(file, "                    <strong>Puerto:</strong> %d | ", current->alert.port);
-                    fprintf(file, "                    <strong>Servicio:</strong> %s | ", current->alert.service);
-                    fprintf(file, "                    <strong>Hora:</strong> %s\n", alert_time_str);
-                    fprintf(file, "                </div>\n");
-                    fprintf(file, "            </div>\n");
-                }
-                current = current->next;
-            }
+            if (!manager->level_head[priority]) continue;
             
-            if (found_any) {
-                fprintf(file, "        </div>\n");
-            }
+            fprintf(file, "        <div class=\"alert-section\">\n");
+            fprintf(file, "            <h3>%s</h3>\n", priority_names[p]);
+            HtmlSection section = { file, css_classes[p] };
+            query.levels = ALERT_LEVEL_MASK(priority);
+            alert_manager_query(manager, &query, write_html_alert, &section);
+            fprintf(file, "        </div>\n");
         }
     } else {
         fprintf(file, "        <div class=\"alert-section\">\n");
@@ -0,0 +1,54 @@
+/*
+ * RTT Estimator - Implementación del estimador de RTT por host
+ *
+ * Sigue el cálculo de RTO de RFC 6298 con aritmética entera en
+ * microsegundos. Cada SYN respondido (SYN-ACK o RST) aporta una muestra; las
+ * sondas sin respuesta no aportan nada y sólo pueden reintentarse. Mientras
+ * un host no tenga muestras se usa el plazo máximo (--timeout).
+ */
+
+#include <time.h>
+#include "rtt_estimator.h"
+
+void rtt_estimator_init(RttEstimator *estimator) {
+    estimator->srtt_us = 0;
+    estimator->rttvar_us = 0;
+    estimator->samples = 0;
+}
+
+void rtt_estimator_sample(RttEstimator *estimator, uint64_t rtt_us) {
+    if (rtt_us > UINT32_MAX) rtt_us = UINT32_MAX;
+    uint32_t rtt = (uint32_t)rtt_us;
+
+    if (estimator->samples == 0) {
+        // Primera medida: SRTT = R, RTTVAR = R/2
+        estimator->srtt_us = rtt;
+        estimator->rttvar_us = rtt / 2;
+    } else {
+        // RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|;  SRTT = 7/8 SRTT + 1/8 R
+        uint32_t delta = estimator->srtt_us > rtt ? estimator->srtt_us - rtt : rtt - estimator->srtt_us;
+        estimator->rttvar_us = (uint32_t)(((uint64_t)estimator->rttvar_us * 3 + delta) / 4);
+        estimator->srtt_us = (uint32_t)(((uint64_t)estimator->srtt_us * 7 + rtt) / 8);
+    }
+    if (estimator->samples < UINT32_MAX) estimator->samples++;
+}
+
+int rtt_estimator_timeout_ms(const RttEstimator *estimator, int max_timeout_ms, int attempt) {
+    if (estimator->samples == 0) return max_timeout_ms;
+
+    // RTO = SRTT + max(G, 4 * RTTVAR), duplicado en cada reintento
+    uint64_t variance = (uint64_t)estimator->rttvar_us * 4;
+    if (variance < RTT_CLOCK_GRANULARITY_US) variance = RTT_CLOCK_GRANULARITY_US;
+    uint64_t rto_ms = (estimator->srtt_us + variance + 999) / 1000;
+    if (attempt > 0) rto_ms <<= attempt < 16 ? attempt : 16;
+
+    if (rto_ms < RTT_MIN_TIMEOUT_MS) rto_ms = RTT_MIN_TIMEOUT_MS;
+    if (rto_ms > (uint64_t)max_timeout_ms) rto_ms = (uint64_t)max_timeout_ms;
+    return (int)rto_ms;
+}
+
+uint64_t rtt_now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000ULL;
+}
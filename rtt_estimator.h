@@ -0,0 +1,25 @@
+/*
+ * RTT Estimator - Estimación del tiempo de ida y vuelta por host (RFC 6298)
+ */
+
+#ifndef RTT_ESTIMATOR_H
+#define RTT_ESTIMATOR_H
+
+#include <stdint.h>
+
+#define RTT_MIN_TIMEOUT_MS 50           // Piso del plazo adaptativo
+#define RTT_CLOCK_GRANULARITY_US 10000  // Resolución de la rueda de plazos (timer_wheel.h)
+
+typedef struct {
+    uint32_t srtt_us;       // RTT suavizado
+    uint32_t rttvar_us;     // Variación del RTT
+    uint32_t samples;       // 0 = sin medidas todavía
+} RttEstimator;
+
+// Funciones públicas
+void rtt_estimator_init(RttEstimator *estimator);
+void rtt_estimator_sample(RttEstimator *estimator, uint64_t rtt_us);
+int rtt_estimator_timeout_ms(const RttEstimator *estimator, int max_timeout_ms, int attempt);
+uint64_t rtt_now_us(void);
+
+#endif
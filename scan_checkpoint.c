@@ -0,0 +1,386 @@
+/*
+ * Scan Checkpoint - Implementación de los checkpoints de escaneo
+ *
+ * El progreso de un barrido se describe en el espacio de posiciones del
+ * plan (el orden en que scan_plan_next entrega las sondas). Las sondas se
+ * completan fuera de orden por la ventana y los reintentos, así que no basta
+ * con el cursor: ScanTracker guarda una marca de agua (toda posición
+ * anterior está completa) y un mapa de bits de las completadas por encima.
+ * Ese hueco nunca supera la ventana más los reintentos pendientes, de modo
+ * que el checkpoint ocupa unos pocos KB aunque el barrido tenga miles de
+ * millones de sondas.
+ *
+ * El archivo guarda también los parámetros que fijan el recorrido (objetivo,
+ * puertos, semilla) y los puertos abiertos encontrados hasta el momento.
+ * Se escribe en un temporal, se sincroniza y se renombra sobre el anterior,
+ * así que un corte en mitad de la escritura deja intacto el checkpoint
+ * previo; una suma FNV-1a al final detecta archivos truncados o dañados.
+ * El formato usa el orden de bytes de la máquina: sirve para reanudar en el
+ * mismo equipo, no para intercambiarse.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "scan_checkpoint.h"
+
+#define CHECKPOINT_MAX_STRING (1 << 20)
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+    FILE *file;
+    uint64_t hash;
+    int error;
+} CheckpointStream;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static void put(CheckpointStream *stream, const void *data, size_t length) {
+    if (stream->error) return;
+    if (length > 0 && fwrite(data, 1, length, stream->file) != length) {
+        stream->error = 1;
+        return;
+    }
+    stream->hash = fnv1a(stream->hash, data, length);
+}
+
+static void put_u32(CheckpointStream *stream, uint32_t value) {
+    put(stream, &value, sizeof(value));
+}
+
+static void put_u64(CheckpointStream *stream, uint64_t value) {
+    put(stream, &value, sizeof(value));
+}
+
+static void get(CheckpointStream *stream, void *data, size_t length) {
+    if (stream->error) return;
+    if (length > 0 && fread(data, 1, length, stream->file) != length) {
+        stream->error = 1;
+        return;
+    }
+    stream->hash = fnv1a(stream->hash, data, length);
+}
+
+static uint32_t get_u32(CheckpointStream *stream) {
+    uint32_t value = 0;
+    get(stream, &value, sizeof(value));
+    return value;
+}
+
+static uint64_t get_u64(CheckpointStream *stream) {
+    uint64_t value = 0;
+    get(stream, &value, sizeof(value));
+    return value;
+}
+
+static char* get_string(CheckpointStream *stream) {
+    uint32_t length = get_u32(stream);
+    if (stream->error || length > CHECKPOINT_MAX_STRING) {
+        stream->error = 1;
+        return NULL;
+    }
+    char *text = malloc(length + 1);
+    if (!text) {
+        stream->error = 1;
+        return NULL;
+    }
+    get(stream, text, length);
+    text[length] = '\0';
+    return text;
+}
+
+void scan_tracker_init(ScanTracker *tracker) {
+    tracker->base = 0;
+    tracker->bits = NULL;
+    tracker->words = 0;
+    tracker->capacity = 0;
+    tracker->completed = 0;
+}
+
+void scan_tracker_destroy(ScanTracker *tracker) {
+    if (!tracker) return;
+    free(tracker->bits);
+    scan_tracker_init(tracker);
+}
+
+int scan_tracker_done(const ScanTracker *tracker, uint64_t position) {
+    if (position < tracker->base) return 1;
+    uint64_t word = (position - tracker->base) / 64;
+    if (word >= (uint64_t)tracker->words) return 0;
+    return (tracker->bits[word] >> ((position - tracker->base) % 64)) & 1;
+}
+
+// Devuelve 1 si la posición no estaba marcada, 0 si ya lo estaba y -1 sin memoria
+int scan_tracker_mark(ScanTracker *tracker, uint64_t position) {
+    if (position < tracker->base) return 0;
+
+    uint64_t word = (position - tracker->base) / 64;
+    if (word >= (uint64_t)tracker->capacity) {
+        int capacity = tracker->capacity ? tracker->capacity : 64;
+        while ((uint64_t)capacity <= word) capacity *= 2;
+        uint64_t *grown = realloc(tracker->bits, capacity * sizeof(uint64_t));
+        if (!grown) return -1;
+        memset(grown + tracker->capacity, 0, (capacity - tracker->capacity) * sizeof(uint64_t));
+        tracker->bits = grown;
+        tracker->capacity = capacity;
+    }
+    if (word >= (uint64_t)tracker->words) tracker->words = (int)word + 1;
+
+    uint64_t bit = 1ULL << ((position - tracker->base) % 64);
+    if (tracker->bits[word] & bit) return 0;
+    tracker->bits[word] |= bit;
+    tracker->completed++;
+
+    // Avanzar la marca de agua por palabras completas
+    int full = 0;
+    while (full < tracker->words && tracker->bits[full] == ~0ULL) full++;
+    if (full > 0) {
+        memmove(tracker->bits, tracker->bits + full, (tracker->words - full) * sizeof(uint64_t));
+        memset(tracker->bits + tracker->words - full, 0, full * sizeof(uint64_t));
+        tracker->words -= full;
+        tracker->base += (uint64_t)full * 64;
+    }
+    return 1;
+}
+
+uint64_t scan_checkpoint_host_hash(const HostTable *hosts) {
+    uint64_t hash = FNV_OFFSET;
+    for (int h = 0; h < hosts->count; h++) {
+        const struct sockaddr_storage *addr = &hosts->hosts[h].addr;
+        hash = fnv1a(hash, &addr->ss_family, sizeof(addr->ss_family));
+        if (addr->ss_family == AF_INET6) {
+            const struct sockaddr_in6 *addr6 = (const struct sockaddr_in6*)addr;
+            hash = fnv1a(hash, &addr6->sin6_addr, sizeof(addr6->sin6_addr));
+        } else {
+            const struct sockaddr_in *addr4 = (const struct sockaddr_in*)addr;
+            hash = fnv1a(hash, &addr4->sin_addr, sizeof(addr4->sin_addr));
+        }
+    }
+    return hash;
+}
+
+int scan_checkpoint_save(const char *path, const ScanCheckpointInfo *info, const HostTable *hosts,
+                         const ScanPlan *plan, const ScanTracker *tracker) {
+    if (!path || !info || !hosts || !plan || !tracker) return -1;
+
+    size_t path_length = strlen(path);
+    char *temporary = malloc(path_length + 5);
+    if (!temporary) return -1;
+    memcpy(temporary, path, path_length);
+    memcpy(temporary + path_length, ".tmp", 5);
+
+    CheckpointStream stream;
+    stream.file = fopen(temporary, "wb");
+    stream.hash = FNV_OFFSET;
+    stream.error = 0;
+    if (!stream.file) {
+        free(temporary);
+        return -1;
+    }
+
+    put(&stream, SCAN_CHECKPOINT_MAGIC, 8);
+    put_u32(&stream, (uint32_t)strlen(info->target_spec));
+    put(&stream, info->target_spec, strlen(info->target_spec));
+    put_u32(&stream, (uint32_t)strlen(info->port_spec));
+    put(&stream, info->port_spec, strlen(info->port_spec));
+    put_u32(&stream, (uint32_t)info->udp);
+    put_u32(&stream, (uint32_t)info->randomized);
+    put_u32(&stream, info->scan_round);
+    put_u64(&stream, info->seed);
+
+    put_u32(&stream, (uint32_t)hosts->count);
+    put_u64(&stream, scan_checkpoint_host_hash(hosts));
+    put_u64(&stream, plan->total);
+    put_u64(&stream, plan->cursor);
+    put_u64(&stream, tracker->base);
+    put_u64(&stream, tracker->completed);
+    put_u32(&stream, (uint32_t)tracker->words);
+    put(&stream, tracker->bits, tracker->words * sizeof(uint64_t));
+
+    // Resultados parciales: puertos abiertos como lista y sin respuesta UDP
+    for (int h = 0; h < hosts->count; h++) {
+        const PortSet *open_set = hosts->hosts[h].current_open;
+        put_u32(&stream, (uint32_t)hosts->hosts[h].unanswered);
+        put_u32(&stream, open_set ? (uint32_t)port_set_count(open_set) : 0);
+        if (!open_set) continue;
+        for (int port = port_set_next(open_set, 0); port >= 0; port = port_set_next(open_set, port + 1)) {
+            uint16_t value = (uint16_t)port;
+            put(&stream, &value, sizeof(value));
+        }
+    }
+
+    uint64_t checksum = stream.hash;
+    if (!stream.error && fwrite(&checksum, sizeof(checksum), 1, stream.file) != 1) stream.error = 1;
+    if (!stream.error && (fflush(stream.file) != 0 || fsync(fileno(stream.file)) != 0)) stream.error = 1;
+    if (fclose(stream.file) != 0) stream.error = 1;
+
+    if (stream.error || rename(temporary, path) != 0) {
+        unlink(temporary);
+        free(temporary);
+        return -1;
+    }
+    free(temporary);
+    return 0;
+}
+
+ScanCheckpoint* scan_checkpoint_load(const char *path) {
+    if (!path) return NULL;
+
+    CheckpointStream stream;
+    stream.file = fopen(path, "rb");
+    stream.hash = FNV_OFFSET;
+    stream.error = 0;
+    if (!stream.file) return NULL;
+
+    ScanCheckpoint *checkpoint = calloc(1, sizeof(ScanCheckpoint));
+    if (!checkpoint) {
+        fclose(stream.file);
+        return NULL;
+    }
+    scan_tracker_init(&checkpoint->tracker);
+
+    char magic[8];
+    get(&stream, magic, sizeof(magic));
+    if (stream.error || memcmp(magic, SCAN_CHECKPOINT_MAGIC, sizeof(magic)) != 0) stream.error = 1;
+
+    checkpoint->target_spec = get_string(&stream);
+    checkpoint->port_spec = get_string(&stream);
+    checkpoint->udp = (int)get_u32(&stream);
+    checkpoint->randomized = (int)get_u32(&stream);
+    checkpoint->scan_round = get_u32(&stream);
+    checkpoint->seed = get_u64(&stream);
+
+    uint32_t host_count = get_u32(&stream);
+    checkpoint->host_hash = get_u64(&stream);
+    checkpoint->total = get_u64(&stream);
+    checkpoint->cursor = get_u64(&stream);
+    checkpoint->tracker.base = get_u64(&stream);
+    checkpoint->tracker.completed = get_u64(&stream);
+    uint32_t words = get_u32(&stream);
+    if (host_count == 0 || host_count > HOST_TABLE_MAX_HOSTS || checkpoint->cursor > checkpoint->total ||
+        (uint64_t)words * 64 > checkpoint->total + 64) {
+        stream.error = 1;
+    }
+
+    if (!stream.error && words > 0) {
+        checkpoint->tracker.bits = malloc(words * sizeof(uint64_t));
+        if (!checkpoint->tracker.bits) stream.error = 1;
+        checkpoint->tracker.words = checkpoint->tracker.capacity = (int)words;
+        get(&stream, checkpoint->tracker.bits, words * sizeof(uint64_t));
+    }
+
+    if (!stream.error) {
+        checkpoint->host_count = (int)host_count;
+        checkpoint->open = calloc(host_count, sizeof(PortSet*));
+        checkpoint->unanswered = calloc(host_count, sizeof(int));
+        if (!checkpoint->open || !checkpoint->unanswered) stream.error = 1;
+    }
+    for (uint32_t h = 0; !stream.error && h < host_count; h++) {
+        checkpoint->unanswered[h] = (int)get_u32(&stream);
+        uint32_t open_count = get_u32(&stream);
+        if (open_count > PORT_SET_MAX_PORT + 1) {
+            stream.error = 1;
+            break;
+        }
+        if (open_count == 0) continue;
+        checkpoint->open[h] = calloc(1, sizeof(PortSet));
+        if (!checkpoint->open[h]) {
+            stream.error = 1;
+            break;
+        }
+        for (uint32_t i = 0; i < open_count && !stream.error; i++) {
+            uint16_t port = 0;
+            get(&stream, &port, sizeof(port));
+            port_set_add(checkpoint->open[h], port);
+        }
+    }
+
+    uint64_t expected = stream.hash;
+    uint64_t checksum = 0;
+    if (!stream.error && (fread(&checksum, sizeof(checksum), 1, stream.file) != 1 || checksum != expected)) {
+        stream.error = 1;
+    }
+    fclose(stream.file);
+
+    if (stream.error) {
+        scan_checkpoint_destroy(checkpoint);
+        return NULL;
+    }
+    return checkpoint;
+}
+
+void scan_checkpoint_destroy(ScanCheckpoint *checkpoint) {
+    if (!checkpoint) return;
+    if (checkpoint->open) {
+        for (int h = 0; h < checkpoint->host_count; h++) {
+            free(checkpoint->open[h]);
+        }
+    }
+    free(checkpoint->open);
+    free(checkpoint->unanswered);
+    scan_tracker_destroy(&checkpoint->tracker);
+    free(checkpoint->target_spec);
+    free(checkpoint->port_spec);
+    free(checkpoint);
+}
+
+int scan_checkpoint_restore(const ScanCheckpoint *checkpoint, HostTable *hosts, ScanPlan *plan,
+                            ScanTracker *tracker) {
+    if (!checkpoint || !hosts || !plan || !tracker) return -1;
+
+    // El recorrido sólo es el mismo con los mismos hosts, puertos y semilla
+    if (checkpoint->host_count != hosts->count || checkpoint->total != plan->total ||
+        checkpoint->host_hash != scan_checkpoint_host_hash(hosts)) {
+        return -1;
+    }
+
+    ScanTracker restored = checkpoint->tracker;
+    restored.capacity = restored.words;
+    restored.bits = NULL;
+    if (restored.words > 0) {
+        restored.bits = malloc(restored.words * sizeof(uint64_t));
+        if (!restored.bits) return -1;
+        memcpy(restored.bits, checkpoint->tracker.bits, restored.words * sizeof(uint64_t));
+    }
+
+    // Las sondas por debajo del cursor sin completar (en vuelo o pendientes de
+    // reintento al interrumpir) vuelven a la cola antes que las nuevas
+    plan->cursor = checkpoint->cursor;
+    for (uint64_t position = restored.base; position < plan->cursor; position++) {
+        if (scan_tracker_done(&restored, position)) continue;
+        ScanProbe probe;
+        scan_plan_probe_at(plan, position, &probe);
+        if (scan_plan_defer(plan, &probe) != 0) {
+            free(restored.bits);
+            return -1;
+        }
+    }
+
+    for (int h = 0; h < hosts->count; h++) {
+        ScanHost *entry = &hosts->hosts[h];
+        free(entry->current_open);
+        entry->current_open = NULL;
+        entry->unanswered = checkpoint->unanswered[h];
+        if (checkpoint->open[h]) {
+            entry->current_open = malloc(sizeof(PortSet));
+            if (!entry->current_open) {
+                free(restored.bits);
+                return -1;
+            }
+            memcpy(entry->current_open, checkpoint->open[h], sizeof(PortSet));
+        }
+    }
+
+    scan_tracker_destroy(tracker);
+    *tracker = restored;
+    return 0;
+}
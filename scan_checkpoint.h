@@ -0,0 +1,67 @@
+/*
+ * Scan Checkpoint - Progreso persistente de barridos largos (--checkpoint, --resume)
+ */
+
+#ifndef SCAN_CHECKPOINT_H
+#define SCAN_CHECKPOINT_H
+
+#include <stdint.h>
+#include "host_table.h"
+#include "scan_plan.h"
+
+#define SCAN_CHECKPOINT_MAGIC "MGCKPT01"
+#define SCAN_CHECKPOINT_INTERVAL 10     // Segundos entre checkpoints periódicos
+#define SCAN_CHECKPOINT_DEFAULT_PATH "matcomguard.checkpoint"
+
+// Sondas completadas por posición en el recorrido del plan
+typedef struct {
+    uint64_t base;          // Toda posición anterior está completa (múltiplo de 64)
+    uint64_t *bits;         // Completadas en [base, base + 64 * words)
+    int words;
+    int capacity;
+    uint64_t completed;
+} ScanTracker;
+
+// Parámetros que fijan el recorrido; deben coincidir para reanudar
+typedef struct {
+    const char *target_spec;
+    const char *port_spec;
+    int udp;
+    int randomized;
+    uint64_t seed;
+    unsigned int scan_round;
+} ScanCheckpointInfo;
+
+typedef struct {
+    char *target_spec;
+    char *port_spec;
+    int udp;
+    int randomized;
+    uint64_t seed;
+    unsigned int scan_round;
+    int host_count;
+    uint64_t host_hash;     // Direcciones de la tabla (detecta objetivos que cambiaron)
+    uint64_t total;
+    uint64_t cursor;
+    ScanTracker tracker;
+    PortSet **open;         // Resultados parciales por host (NULL = ninguno abierto)
+    int *unanswered;
+} ScanCheckpoint;
+
+// Funciones públicas
+int scan_checkpoint_save(const char *path, const ScanCheckpointInfo *info, const HostTable *hosts,
+                         const ScanPlan *plan, const ScanTracker *tracker);
+ScanCheckpoint* scan_checkpoint_load(const char *path);
+void scan_checkpoint_destroy(ScanCheckpoint *checkpoint);
+int scan_checkpoint_restore(const ScanCheckpoint *checkpoint, HostTable *hosts, ScanPlan *plan,
+                            ScanTracker *tracker);
+
+void scan_tracker_init(ScanTracker *tracker);
+void scan_tracker_destroy(ScanTracker *tracker);
+int scan_tracker_mark(ScanTracker *tracker, uint64_t position);
+int scan_tracker_done(const ScanTracker *tracker, uint64_t position);
+
+// Funciones auxiliares
+uint64_t scan_checkpoint_host_hash(const HostTable *hosts);
+
+#endif
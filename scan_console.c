@@ -0,0 +1,97 @@
+/*
+ * Scan Console - Implementación de la salida por consola
+ *
+ * Consumidor de ScanEvent que reproduce la salida clásica de MatcomGuard:
+ * progreso, cambios entre escaneos, puertos abiertos con su semáforo y
+ * avisos. Se registra con port_scanner_subscribe(); quien embeba el escáner
+ * puede omitirlo y consumir los eventos directamente.
+ */
+
+#include <stdio.h>
+#include "scan_console.h"
+
+static void print_port_list(const char *label, const PortSet *set) {
+    printf("%s", label);
+    for (int port = port_set_next(set, 0); port >= 0; port = port_set_next(set, port + 1)) {
+        printf("%d%s", port, port_set_next(set, port + 1) >= 0 ? "," : "");
+    }
+    printf("\n");
+}
+
+static const char* level_emoji(AlertLevel level) {
+    if (level == ALERT_HIGH) return "🔴";
+    if (level == ALERT_MEDIUM) return "🟡";
+    return "🟢";
+}
+
+static const char* log_prefix(ScanLogLevel level) {
+    if (level == SCAN_LOG_ERROR) return "[ERROR]";
+    if (level == SCAN_LOG_WARNING) return "[ADVERTENCIA]";
+    return "[INFO]";
+}
+
+void scan_console_print(const ScanEvent *event, void *user_data) {
+    (void)user_data;
+    
+    switch (event->type) {
+        case SCAN_EVENT_START:
+            if (event->host_count > 1) {
+                printf("[INFO] Escaneando %d puertos en %d hosts (%s)...\n",
+                       event->port_count, event->host_count, event->text);
+            } else {
+                printf("[INFO] Escaneando %d puertos en %s...\n", event->port_count, event->text);
+            }
+            break;
+            
+        case SCAN_EVENT_PROGRESS:
+            printf("[INFO] Progreso: %llu/%llu puertos escaneados",
+                   (unsigned long long)event->completed, (unsigned long long)event->total);
+            if (event->text) {
+                printf(" (%s)", event->text);
+            }
+            printf("\n");
+            break;
+            
+        case SCAN_EVENT_CHANGES:
+            if (event->text) {
+                printf("\n[HOST] %s", event->text);
+            }
+            if (port_set_next(event->opened, 0) >= 0) {
+                printf("\n");
+                print_port_list("[CAMBIO] Nuevos puertos abiertos: ", event->opened);
+            }
+            if (port_set_next(event->closed, 0) >= 0) {
+                print_port_list("[CAMBIO] Puertos cerrados: ", event->closed);
+            }
+            break;
+            
+        case SCAN_EVENT_HOST:
+            if (event->text) {
+                printf("\n[RESULTADO] %d puertos abiertos en %s:\n", event->port_count, event->text);
+            } else {
+                printf("\n[RESULTADO] %d puertos abiertos encontrados:\n", event->port_count);
+            }
+            break;
+            
+        case SCAN_EVENT_PORT:
+            printf("%s %s\n", level_emoji(event->level), event->text);
+            break;
+            
+        case SCAN_EVENT_END:
+            if (event->partial) {
+                // Los ciclos parciales sólo informan cambios
+            } else if (event->open_hosts == 0) {
+                printf("\n[INFO] No se encontraron puertos abiertos\n");
+            } else if (event->host_count > 1) {
+                printf("\n[INFO] Hosts con puertos abiertos: %d/%d\n", event->open_hosts, event->host_count);
+            }
+            break;
+            
+        case SCAN_EVENT_LOG:
+            printf("%s %s\n", log_prefix(event->log_level), event->text);
+            break;
+            
+        default:
+            break;
+    }
+}
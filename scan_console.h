@@ -0,0 +1,16 @@
+/*
+ * Scan Console - Salida por consola de los eventos del escáner
+ */
+
+#ifndef SCAN_CONSOLE_H
+#define SCAN_CONSOLE_H
+
+#include "port_scanner.h"
+
+// Eventos que muestra la consola (los resultados por sonda no se imprimen)
+#define SCAN_CONSOLE_EVENTS (SCAN_EVENT_ALL & ~SCAN_EVENT_MASK(SCAN_EVENT_RESULT))
+
+// Funciones públicas
+void scan_console_print(const ScanEvent *event, void *user_data);
+
+#endif
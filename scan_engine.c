@@ -0,0 +1,501 @@
+/*
+ * Scan Engine - Implementación del motor asíncrono de conexiones TCP
+ *
+ * Mantiene hasta max_inflight connect() no bloqueantes sobre una única
+ * instancia de epoll. Los plazos de cada socket se guardan en una rueda de
+ * temporizadores (timer_wheel.c) con resolución de TIMER_WHEEL_TICK_MS, de
+ * modo que armar, cancelar y expirar un plazo cuesta O(1).
+ *
+ * El plazo de cada sonda sale del RTT medido para su host (RFC 6298) y
+ * --timeout sólo actúa como tope; las sondas que expiran se reintentan con
+ * el plazo duplicado hasta max_retries veces antes de darse por filtradas.
+ *
+ * Si hay un ScanPacer, cada sonda pide turno con scan_engine_next() y su
+ * desenlace se le notifica con scan_pacer_settle() exactamente una vez. Una
+ * sonda cuyo host tiene la ventana llena se aparca en el plan y el cursor
+ * sigue con los demás hosts; el pacer la libera cuando su host deja hueco.
+ *
+ * Contra una dirección local, un puerto del rango efímero puede "conectar"
+ * consigo mismo: el kernel elige como origen el mismo puerto que el destino
+ * y la apertura simultánea de TCP completa la conexión sin que nadie escuche.
+ * Esas conexiones se detectan con getsockname() y cuentan como cerradas.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/select.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include "scan_engine.h"
+#include "timer_wheel.h"
+
+typedef struct {
+    int fd;
+    ScanProbe probe;
+    uint64_t sent_us;       // Envío del SYN, para medir el RTT
+} ProbeSlot;
+
+// Estado del bucle epoll compartido con el callback de expiración
+typedef struct {
+    ProbeSlot *slots;
+    int *free_list;
+    int free_count;
+    int inflight;
+    ScanPlan *plan;
+    const ScanEngineOptions *options;
+    ScanResultCallback callback;
+    void *user_data;
+} EpollScan;
+
+static void expire_probe(int index, void *user_data) {
+    EpollScan *scan = (EpollScan*)user_data;
+    ProbeSlot *slot = &scan->slots[index];
+
+    close(slot->fd);
+    fd_budget_release(scan->options->fds);
+    scan->free_list[scan->free_count++] = index;
+    scan->inflight--;
+    scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt, PACER_TIMEOUT);
+    // Sin respuesta: resultado ambiguo, se reintenta antes de darlo por filtrado
+    if (!scan_engine_retry(scan->plan, &slot->probe, scan->options)) {
+        scan->callback(slot->probe.host, slot->probe.port, 0, scan->user_data);
+    }
+}
+
+const char* scan_engine_type_to_string(ScanEngineType type) {
+    switch (type) {
+        case SCAN_ENGINE_BLOCKING: return "blocking";
+        case SCAN_ENGINE_EPOLL: return "epoll";
+        case SCAN_ENGINE_URING: return "uring";
+        case SCAN_ENGINE_SYN: return "syn";
+        case SCAN_ENGINE_UDP: return "udp";
+        default: return "desconocido";
+    }
+}
+
+int scan_engine_parse_type(const char *name, ScanEngineType *type) {
+    if (!name || !type) return -1;
+
+    if (strcmp(name, "blocking") == 0) {
+        *type = SCAN_ENGINE_BLOCKING;
+    } else if (strcmp(name, "epoll") == 0) {
+        *type = SCAN_ENGINE_EPOLL;
+    } else if (strcmp(name, "uring") == 0) {
+        *type = SCAN_ENGINE_URING;
+    } else if (strcmp(name, "syn") == 0) {
+        *type = SCAN_ENGINE_SYN;
+    } else if (strcmp(name, "udp") == 0) {
+        *type = SCAN_ENGINE_UDP;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int scan_engine_stopped(const ScanEngineOptions *options) {
+    return options->running && !*options->running;
+}
+
+// sendmmsg sin espacio: con EAGAIN se espera a que el socket admita datos; con
+// ENOBUFS (cola del dispositivo llena, que poll no refleja) se espera un tick
+void scan_engine_send_backoff(int fd, int error) {
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+    poll(&pfd, error == EAGAIN ? 1 : 0, TIMER_WHEEL_TICK_MS);
+}
+
+int scan_engine_clamp_inflight(const FdBudget *fds, int requested) {
+    int window = requested > 0 ? requested : SCAN_ENGINE_DEFAULT_INFLIGHT;
+    return fd_budget_window(fds, window);
+}
+
+void scan_engine_socket_failed(ScanPlan *plan, const ScanEngineOptions *options, const ScanProbe *probe,
+                               int error, ScanResultCallback callback, void *user_data) {
+    scan_pacer_settle(options->pacer, probe->host, probe->attempt, PACER_ABORTED);
+
+    // Sin descriptores libres pero con sockets por cerrarse: la sonda espera su turno
+    if (fd_budget_exhausted(options->fds, error) && scan_plan_defer(plan, probe) == 0) {
+        return;
+    }
+    callback(probe->host, probe->port, SCAN_RESULT_ERROR, user_data);
+}
+
+void scan_engine_sample_rtt(HostTable *hosts, const ScanEngineOptions *options, int host, uint64_t rtt_us) {
+    rtt_estimator_sample(&hosts->hosts[host].rtt, rtt_us);
+    probe_stats_record(options->stats, rtt_us);
+}
+
+// El socket conectado tiene como origen el mismo extremo que su destino
+int scan_engine_self_connected(int fd, const struct sockaddr_storage *endpoint) {
+    struct sockaddr_storage local;
+    socklen_t len = sizeof(local);
+    if (getsockname(fd, (struct sockaddr*)&local, &len) != 0 || local.ss_family != endpoint->ss_family) {
+        return 0;
+    }
+
+    if (local.ss_family == AF_INET) {
+        const struct sockaddr_in *a = (const struct sockaddr_in*)&local;
+        const struct sockaddr_in *b = (const struct sockaddr_in*)endpoint;
+        return a->sin_port == b->sin_port && a->sin_addr.s_addr == b->sin_addr.s_addr;
+    }
+    if (local.ss_family == AF_INET6) {
+        const struct sockaddr_in6 *a = (const struct sockaddr_in6*)&local;
+        const struct sockaddr_in6 *b = (const struct sockaddr_in6*)endpoint;
+        return a->sin6_port == b->sin6_port &&
+               memcmp(&a->sin6_addr, &b->sin6_addr, sizeof(struct in6_addr)) == 0;
+    }
+    return 0;
+}
+
+// Puerto dentro del rango de puertos de origen del kernel (posible autoconexión)
+int scan_engine_in_local_range(int port) {
+    static int low = -1;
+    static int high = -1;
+
+    if (low < 0) {
+        low = 32768;
+        high = 60999;
+        FILE *file = fopen("/proc/sys/net/ipv4/ip_local_port_range", "r");
+        if (file) {
+            int a, b;
+            if (fscanf(file, "%d %d", &a, &b) == 2 && a > 0 && a <= b) {
+                low = a;
+                high = b;
+            }
+            fclose(file);
+        }
+    }
+    return port >= low && port <= high;
+}
+
+ScanResult scan_engine_probe_blocking(const struct sockaddr_storage *endpoint, socklen_t endpoint_len,
+                                      int timeout_ms, uint64_t *rtt_us) {
+    fd_set fdset;
+    struct timeval tv;
+    int error;
+    socklen_t len;
+    
+    if (rtt_us) *rtt_us = 0;
+    
+    int sock = socket(endpoint->ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (sock < 0) {
+        return SCAN_RESULT_ERROR;
+    }
+    
+    // Intentar conexión
+    uint64_t sent_us = rtt_now_us();
+    if (connect(sock, (const struct sockaddr*)endpoint, endpoint_len) == 0) {
+        int self = scan_engine_self_connected(sock, endpoint);
+        close(sock);
+        if (rtt_us) *rtt_us = rtt_now_us() - sent_us + 1;
+        return self ? SCAN_RESULT_CLOSED : SCAN_RESULT_OPEN;
+    }
+    if (errno != EINPROGRESS) {
+        if (errno == ECONNREFUSED && rtt_us) *rtt_us = rtt_now_us() - sent_us + 1;
+        close(sock);
+        return SCAN_RESULT_CLOSED;
+    }
+    
+    // Conexión en progreso, usar select para timeout
+    FD_ZERO(&fdset);
+    FD_SET(sock, &fdset);
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    
+    ScanResult result = SCAN_RESULT_TIMEOUT;
+    if (select(sock + 1, NULL, &fdset, NULL, &tv) > 0) {
+        // Verificar si la conexión fue exitosa; SYN-ACK y RST son medidas de RTT válidas
+        len = sizeof(error);
+        if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &error, &len) != 0) error = -1;
+        result = error == 0 && !scan_engine_self_connected(sock, endpoint) ? SCAN_RESULT_OPEN : SCAN_RESULT_CLOSED;
+        if ((error == 0 || error == ECONNREFUSED) && rtt_us) {
+            *rtt_us = rtt_now_us() - sent_us + 1;
+        }
+    }
+    
+    close(sock);
+    return result;
+}
+
+int scan_engine_probe_timeout(const HostTable *hosts, const ScanProbe *probe,
+                              const ScanEngineOptions *options) {
+    return rtt_estimator_timeout_ms(&hosts->hosts[probe->host].rtt, options->timeout_ms,
+                                    probe->attempt);
+}
+
+int scan_engine_retry(ScanPlan *plan, const ScanProbe *probe, const ScanEngineOptions *options) {
+    if (probe->attempt >= options->max_retries) return 0;
+    return scan_plan_retry(plan, probe) == 0;
+}
+
+int scan_engine_next(ScanPlan *plan, const ScanEngineOptions *options, ScanProbe *probe,
+                     ScanResultCallback callback, void *user_data) {
+    int deferred = 0;
+
+    while (scan_pacer_ready(options->pacer)) {
+        // Primero las sondas liberadas por su host; las nuevas de un host con
+        // sondas aparcadas van detrás de ellas
+        int released = scan_plan_next_released(plan, probe);
+        if (!released) {
+            if (plan->parked_count >= SCAN_ENGINE_PARKED_MAX || !scan_plan_next(plan, probe)) break;
+        }
+        if ((released || !scan_plan_held(plan, probe->host)) &&
+            scan_pacer_admit(options->pacer, probe->host)) {
+            return 1;
+        }
+
+        // Ventana del host llena: aparcar la sonda y seguir con otra
+        if (scan_plan_park(plan, probe, released) != 0) {
+            callback(probe->host, probe->port, 0, user_data);
+        }
+        if (++deferred >= SCAN_ENGINE_DEFER_LIMIT) break;
+    }
+    return 0;
+}
+
+int scan_engine_blocking(HostTable *hosts, ScanPlan *plan,
+                         const ScanEngineOptions *options, ScanResultCallback callback,
+                         void *user_data) {
+    if (!hosts || !plan || !options || !callback) return -1;
+
+    ScanProbe probe;
+    while (scan_plan_pending(plan)) {
+        if (scan_engine_stopped(options)) break;
+
+        if (!scan_engine_next(plan, options, &probe, callback, user_data)) {
+            // Presupuesto de tasa agotado: esperar al próximo token
+            int wait_ms = scan_pacer_wait_ms(options->pacer);
+            poll(NULL, 0, wait_ms > 0 ? wait_ms : 1);
+            continue;
+        }
+
+        uint64_t rtt_us;
+        struct sockaddr_storage endpoint;
+        socklen_t endpoint_len = host_table_endpoint(&hosts->hosts[probe.host], probe.port, &endpoint);
+        int timeout_ms = scan_engine_probe_timeout(hosts, &probe, options);
+        ScanResult result = scan_engine_probe_blocking(&endpoint, endpoint_len, timeout_ms, &rtt_us);
+        if (result == SCAN_RESULT_ERROR) {
+            scan_engine_socket_failed(plan, options, &probe, errno, callback, user_data);
+            continue;
+        }
+        if (rtt_us > 0) {
+            scan_engine_sample_rtt(hosts, options, probe.host, rtt_us);
+        }
+        scan_pacer_settle(options->pacer, probe.host, probe.attempt,
+                          rtt_us > 0 ? PACER_RESPONSE :
+                          result == SCAN_RESULT_TIMEOUT ? PACER_TIMEOUT : PACER_ABORTED);
+        if (result == SCAN_RESULT_TIMEOUT && scan_engine_retry(plan, &probe, options)) {
+            continue;
+        }
+        callback(probe.host, probe.port, result == SCAN_RESULT_OPEN, user_data);
+    }
+    return 0;
+}
+
+int scan_engine_run(ScanEngineType type, HostTable *hosts, ScanPlan *plan,
+                    const ScanEngineOptions *options, ScanResultCallback callback,
+                    void *user_data, ScanEngineType *used_type) {
+    int result;
+
+    // Las sondas aparcadas por congestión vuelven a este plan al liberarse
+    if (options->pacer) {
+        options->pacer->plan = plan;
+    }
+
+    if (type == SCAN_ENGINE_UDP) {
+        if (used_type) *used_type = type;
+        return scan_engine_udp(hosts, plan, options, callback, user_data);
+    }
+
+    if (type == SCAN_ENGINE_URING || type == SCAN_ENGINE_SYN) {
+        if (type == SCAN_ENGINE_URING) {
+            result = scan_engine_uring(hosts, plan, options, callback, user_data);
+        } else {
+            result = scan_engine_syn(hosts, plan, options, callback, user_data);
+        }
+        if (result != SCAN_ENGINE_UNSUPPORTED) {
+            if (used_type) *used_type = type;
+            return result;
+        }
+        // Sin io_uring (o sin las operaciones necesarias) o sin CAP_NET_RAW: usar epoll
+        type = SCAN_ENGINE_EPOLL;
+    }
+
+    if (type == SCAN_ENGINE_BLOCKING) {
+        result = scan_engine_blocking(hosts, plan, options, callback, user_data);
+    } else {
+        result = scan_engine_epoll(hosts, plan, options, callback, user_data);
+    }
+    if (used_type) *used_type = type;
+    return result;
+}
+
+int scan_engine_epoll(HostTable *hosts, ScanPlan *plan,
+                      const ScanEngineOptions *options, ScanResultCallback callback,
+                      void *user_data) {
+    if (!hosts || !plan || !options || !callback) return -1;
+
+    uint64_t remaining = plan->total - plan->cursor;
+    if (remaining == 0) return 0;
+
+    int window = scan_engine_clamp_inflight(options->fds, options->max_inflight);
+    if ((uint64_t)window > remaining) window = (int)remaining;
+
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) return -1;
+
+    ProbeSlot *slots = malloc(window * sizeof(ProbeSlot));
+    TimerLink *links = malloc(window * sizeof(TimerLink));
+    int *free_list = malloc(window * sizeof(int));
+    struct epoll_event *events = malloc(window * sizeof(struct epoll_event));
+    TimerWheel *wheel = malloc(sizeof(TimerWheel));
+    if (!slots || !links || !free_list || !events || !wheel) {
+        free(slots);
+        free(links);
+        free(free_list);
+        free(events);
+        free(wheel);
+        close(epfd);
+        return -1;
+    }
+
+    EpollScan scan;
+    scan.slots = slots;
+    scan.free_list = free_list;
+    scan.free_count = window;
+    scan.inflight = 0;
+    scan.plan = plan;
+    scan.options = options;
+    scan.callback = callback;
+    scan.user_data = user_data;
+    for (int i = 0; i < window; i++) {
+        free_list[i] = window - 1 - i;
+    }
+    timer_wheel_init(wheel, links, window);
+
+    ScanProbe probe;
+    int status = 0;
+
+    while (scan_plan_pending(plan) || scan.inflight > 0) {
+        // Interrupción (SIGINT): las sondas en vuelo quedan sin completar
+        if (scan_engine_stopped(options)) break;
+
+        // Lanzar nuevas conexiones hasta llenar la ventana o agotar los descriptores
+        while (scan.free_count > 0 && fd_budget_available(options->fds) &&
+               scan_engine_next(plan, options, &probe, callback, user_data)) {
+            struct sockaddr_storage addr;
+            socklen_t addr_len = host_table_endpoint(&hosts->hosts[probe.host], probe.port, &addr);
+            int fd = socket(addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if (fd < 0) {
+                scan_engine_socket_failed(plan, options, &probe, errno, callback, user_data);
+                continue;
+            }
+
+            uint64_t sent_us = rtt_now_us();
+            if (connect(fd, (struct sockaddr*)&addr, addr_len) == 0) {
+                // Conexión inmediata (habitual en loopback)
+                int open = !scan_engine_in_local_range(probe.port) || !scan_engine_self_connected(fd, &addr);
+                close(fd);
+                scan_engine_sample_rtt(hosts, options, probe.host, rtt_now_us() - sent_us);
+                scan_pacer_settle(options->pacer, probe.host, probe.attempt, PACER_RESPONSE);
+                callback(probe.host, probe.port, open, user_data);
+                continue;
+            }
+            if (errno != EINPROGRESS) {
+                int error = errno;
+                if (error == ECONNREFUSED) scan_engine_sample_rtt(hosts, options, probe.host, rtt_now_us() - sent_us);
+                close(fd);
+                scan_pacer_settle(options->pacer, probe.host, probe.attempt, scan_pacer_outcome(error));
+                callback(probe.host, probe.port, 0, user_data);
+                continue;
+            }
+
+            int index = free_list[--scan.free_count];
+            struct epoll_event ev;
+            ev.events = EPOLLOUT;
+            ev.data.u32 = (unsigned int)index;
+            if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                free_list[scan.free_count++] = index;
+                close(fd);
+                scan_pacer_settle(options->pacer, probe.host, probe.attempt, PACER_ABORTED);
+                callback(probe.host, probe.port, 0, user_data);
+                continue;
+            }
+
+            // Plazo adaptado al RTT del host, con --timeout como tope
+            slots[index].fd = fd;
+            slots[index].probe = probe;
+            slots[index].sent_us = sent_us;
+            timer_wheel_insert(wheel, index, scan_engine_probe_timeout(hosts, &probe, options));
+            fd_budget_acquire(options->fds);
+            scan.inflight++;
+        }
+
+        // Sin sondas en vuelo y con trabajo pendiente, el pacer está frenando:
+        // epoll_wait hace de espera hasta el próximo tick
+        int ready = epoll_wait(epfd, events, window, TIMER_WHEEL_TICK_MS);
+        if (ready < 0 && errno != EINTR) {
+            status = -1;
+            break;
+        }
+
+        // Resolver sockets con la conexión completada o rechazada
+        for (int i = 0; i < ready; i++) {
+            int index = (int)events[i].data.u32;
+            ProbeSlot *slot = &slots[index];
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(slot->fd, SOL_SOCKET, SO_ERROR, &error, &len) != 0) error = -1;
+
+            // SYN-ACK o RST: el host respondió y la espera es una medida de RTT
+            if (error == 0 || error == ECONNREFUSED) {
+                scan_engine_sample_rtt(hosts, options, slot->probe.host, rtt_now_us() - slot->sent_us);
+            }
+
+            // Autoconexión en el rango efímero: nadie escucha en ese puerto
+            int open = error == 0;
+            if (open && scan_engine_in_local_range(slot->probe.port)) {
+                struct sockaddr_storage addr;
+                host_table_endpoint(&hosts->hosts[slot->probe.host], slot->probe.port, &addr);
+                open = !scan_engine_self_connected(slot->fd, &addr);
+            }
+
+            timer_wheel_remove(wheel, index);
+            close(slot->fd);
+            fd_budget_release(options->fds);
+            free_list[scan.free_count++] = index;
+            scan.inflight--;
+            scan_pacer_settle(options->pacer, slot->probe.host, slot->probe.attempt,
+                              scan_pacer_outcome(error));
+            callback(slot->probe.host, slot->probe.port, open, user_data);
+        }
+
+        // Avanzar la rueda y expirar los plazos vencidos
+        timer_wheel_advance(wheel, expire_probe, &scan);
+    }
+
+    // Cerrar cualquier socket pendiente si el bucle terminó por error
+    for (int i = 0; i < window; i++) {
+        if (timer_wheel_armed(wheel, i)) {
+            close(slots[i].fd);
+            fd_budget_release(options->fds);
+            scan_pacer_settle(options->pacer, slots[i].probe.host, slots[i].probe.attempt, PACER_ABORTED);
+        }
+    }
+
+    free(slots);
+    free(links);
+    free(free_list);
+    free(events);
+    free(wheel);
+    close(epfd);
+    return status;
+}
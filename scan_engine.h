@@ -0,0 +1,97 @@
+/*
+ * Scan Engine - Motor asíncrono de conexiones TCP basado en epoll
+ */
+
+#ifndef SCAN_ENGINE_H
+#define SCAN_ENGINE_H
+
+#include <stdint.h>
+#include <netinet/in.h>
+#include "host_table.h"
+#include "scan_plan.h"
+#include "scan_pacer.h"
+#include "fd_budget.h"
+#include "probe_stats.h"
+
+#define SCAN_ENGINE_DEFAULT_INFLIGHT 1000
+#define SCAN_ENGINE_DEFAULT_RETRIES 1
+#define SCAN_ENGINE_DEFER_LIMIT 64     // Sondas aparcadas por llamada antes de esperar
+#define SCAN_ENGINE_PARKED_MAX 65536   // Aparcadas en total antes de dejar de avanzar el cursor
+
+// Código devuelto por un motor que el kernel no soporta
+#define SCAN_ENGINE_UNSUPPORTED -2
+
+typedef enum {
+    SCAN_ENGINE_BLOCKING,
+    SCAN_ENGINE_EPOLL,
+    SCAN_ENGINE_URING,
+    SCAN_ENGINE_SYN,
+    SCAN_ENGINE_UDP         // Escaneo UDP (otro protocolo, no una alternativa a los de TCP)
+} ScanEngineType;
+
+// Resultado de una sonda individual; sólo TIMEOUT es ambiguo y se reintenta
+typedef enum {
+    SCAN_RESULT_CLOSED,
+    SCAN_RESULT_OPEN,
+    SCAN_RESULT_TIMEOUT,
+    SCAN_RESULT_ERROR,      // Sin socket o sin poder enviar la sonda: estado desconocido
+    SCAN_RESULT_FILTERED    // UDP: ICMP inalcanzable distinto de puerto (host, red, prohibido)
+} ScanResult;
+
+// Callback invocado por cada sonda resuelta: open es un ScanResult (OPEN = 1 abierto,
+// CLOSED = 0 cerrado/filtrado); sólo el motor UDP informa TIMEOUT, que es open|filtered,
+// y FILTERED, y ERROR indica un fallo local que no dice nada del puerto
+typedef void (*ScanResultCallback)(int host, int port, int open, void *user_data);
+
+typedef struct {
+    int max_inflight;   // Ventana de conexiones simultáneas
+    int timeout_ms;     // Plazo máximo por conexión (el real se adapta al RTT del host)
+    int max_retries;    // Reenvíos de sondas sin respuesta
+    ScanPacer *pacer;   // Límite de tasa y ventanas de congestión (NULL = sin límite)
+    FdBudget *fds;      // Presupuesto de descriptores (NULL = sólo la ventana)
+    ProbeStats *stats;  // Latencia de cada sonda con respuesta (NULL = no medir)
+    volatile int *running;  // Al ponerse a 0 el motor aborta (NULL = nunca)
+} ScanEngineOptions;
+
+// Funciones públicas
+int scan_engine_run(ScanEngineType type, HostTable *hosts, ScanPlan *plan,
+                    const ScanEngineOptions *options, ScanResultCallback callback,
+                    void *user_data, ScanEngineType *used_type);
+int scan_engine_blocking(HostTable *hosts, ScanPlan *plan,
+                         const ScanEngineOptions *options, ScanResultCallback callback,
+                         void *user_data);
+int scan_engine_epoll(HostTable *hosts, ScanPlan *plan,
+                      const ScanEngineOptions *options, ScanResultCallback callback,
+                      void *user_data);
+int scan_engine_uring(HostTable *hosts, ScanPlan *plan,
+                      const ScanEngineOptions *options, ScanResultCallback callback,
+                      void *user_data);
+int scan_engine_syn(HostTable *hosts, ScanPlan *plan,
+                    const ScanEngineOptions *options, ScanResultCallback callback,
+                    void *user_data);
+int scan_engine_udp(HostTable *hosts, ScanPlan *plan,
+                    const ScanEngineOptions *options, ScanResultCallback callback,
+                    void *user_data);
+
+// Funciones auxiliares
+ScanResult scan_engine_probe_blocking(const struct sockaddr_storage *endpoint, socklen_t endpoint_len,
+                                      int timeout_ms, uint64_t *rtt_us);
+void scan_engine_sample_rtt(HostTable *hosts, const ScanEngineOptions *options, int host, uint64_t rtt_us);
+int scan_engine_self_connected(int fd, const struct sockaddr_storage *endpoint);
+int scan_engine_in_local_range(int port);
+int scan_engine_probe_timeout(const HostTable *hosts, const ScanProbe *probe,
+                              const ScanEngineOptions *options);
+int scan_engine_retry(ScanPlan *plan, const ScanProbe *probe, const ScanEngineOptions *options);
+int scan_engine_next(ScanPlan *plan, const ScanEngineOptions *options, ScanProbe *probe,
+                     ScanResultCallback callback, void *user_data);
+void scan_engine_socket_failed(ScanPlan *plan, const ScanEngineOptions *options, const ScanProbe *probe,
+                               int error, ScanResultCallback callback, void *user_data);
+void scan_engine_send_backoff(int fd, int error);
+int scan_engine_clamp_inflight(const FdBudget *fds, int requested);
+int scan_engine_stopped(const ScanEngineOptions *options);
+int scan_engine_parse_type(const char *name, ScanEngineType *type);
+const char* scan_engine_type_to_string(ScanEngineType type);
+const char* scan_engine_udp_payload(int port, size_t *length);
+int scan_engine_udp_icmp_rate(void);
+
+#endif
@@ -0,0 +1,467 @@
+/*
+ * Scan History - Implementación del historial persistente
+ *
+ * Cada host (y protocolo) tiene un archivo de sólo-añadir en el directorio
+ * de --history. Tras una cabecera fija, cada registro guarda el estado de los
+ * puertos abiertos en un instante:
+ *
+ *   int64 instante | uint32 tipo | uint32 longitud | uint32 suma | datos
+ *
+ * Sólo se escribe cuando el estado cambia, y casi siempre como delta (puertos
+ * abiertos y cerrados respecto al registro anterior); cada
+ * SCAN_HISTORY_KEYFRAME deltas se escribe una instantánea completa. Las
+ * listas de puertos se codifican como huecos ascendentes en varint, así que
+ * un cambio típico ocupa unos 25 bytes y años de escaneos cada 30 segundos
+ * caben en pocos MB.
+ *
+ * Un índice aparte (<archivo>.idx) guarda instante y posición de cada
+ * instantánea completa. Una consulta "qué estaba abierto en T" mapea el
+ * archivo con mmap, busca en el índice la última instantánea anterior a T y
+ * aplica los deltas que siguen hasta T. El índice es sólo una ayuda: si falta
+ * o no coincide con los datos se recorre el archivo desde el principio.
+ *
+ * Cada registro lleva una suma FNV-1a; un corte a mitad de escritura deja un
+ * registro incompleto al final que se ignora al leer y se descarta en la
+ * siguiente escritura. El formato usa el orden de bytes de la máquina.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "scan_history.h"
+
+#define RECORD_HEADER_SIZE 20
+#define FNV_OFFSET 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+typedef struct {
+    int64_t timestamp;
+    uint64_t offset;
+} HistoryIndexEntry;
+
+// Archivo mapeado en memoria (sólo lectura)
+typedef struct {
+    int fd;
+    const uint8_t *data;
+    size_t size;
+} HistoryMap;
+
+// Estado reconstruido al recorrer los registros
+typedef struct {
+    int found;              // Se aplicó al menos un registro
+    time_t since;           // Instante del último registro aplicado
+    size_t end;             // Fin del último registro válido
+    int since_key;          // Deltas desde la última instantánea completa
+} HistoryReplay;
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t length) {
+    const uint8_t *bytes = (const uint8_t*)data;
+    for (size_t i = 0; i < length; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+static uint32_t record_checksum(int64_t timestamp, uint32_t type, const uint8_t *payload, uint32_t length) {
+    uint64_t hash = FNV_OFFSET;
+    hash = fnv1a(hash, &timestamp, sizeof(timestamp));
+    hash = fnv1a(hash, &type, sizeof(type));
+    hash = fnv1a(hash, &length, sizeof(length));
+    hash = fnv1a(hash, payload, length);
+    return (uint32_t)(hash ^ (hash >> 32));
+}
+
+// Lista de puertos: cantidad y huecos ascendentes, todo en varint
+static size_t put_varint(uint8_t *out, uint32_t value) {
+    size_t length = 0;
+    while (value >= 0x80) {
+        out[length++] = (uint8_t)(value | 0x80);
+        value >>= 7;
+    }
+    out[length++] = (uint8_t)value;
+    return length;
+}
+
+static int get_varint(const uint8_t *data, size_t size, size_t *offset, uint32_t *value) {
+    uint32_t result = 0;
+    for (int shift = 0; shift <= 28; shift += 7) {
+        if (*offset >= size) return -1;
+        uint8_t byte = data[(*offset)++];
+        result |= (uint32_t)(byte & 0x7f) << shift;
+        if (!(byte & 0x80)) {
+            *value = result;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+static size_t encode_ports(uint8_t *out, const PortSet *set) {
+    size_t length = put_varint(out, (uint32_t)port_set_count(set));
+    int previous = -1;
+    for (int port = port_set_next(set, 0); port >= 0; port = port_set_next(set, port + 1)) {
+        length += put_varint(out + length, (uint32_t)(port - previous - 1));
+        previous = port;
+    }
+    return length;
+}
+
+// Aplica una lista codificada sobre el conjunto (add = 1 añade, 0 quita)
+static int decode_ports(const uint8_t *data, size_t size, size_t *offset, PortSet *set, int add) {
+    uint32_t count;
+    if (get_varint(data, size, offset, &count) != 0 || count > PORT_SET_MAX_PORT + 1) return -1;
+
+    long port = -1;
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t gap;
+        if (get_varint(data, size, offset, &gap) != 0) return -1;
+        port += (long)gap + 1;
+        if (port > PORT_SET_MAX_PORT) return -1;
+        if (add) {
+            port_set_add(set, (int)port);
+        } else {
+            port_set_remove(set, (int)port);
+        }
+    }
+    return 0;
+}
+
+static size_t encoded_size_bound(const PortSet *set) {
+    return 5 + 3 * (size_t)port_set_count(set);
+}
+
+int scan_history_path(const ScanHistory *history, const ScanHost *host, char *buffer, size_t size) {
+    char address[HOST_TABLE_FORMAT_SIZE];
+    host_table_address(host, address, sizeof(address));
+
+    // ':' y '%' de IPv6 no se usan en nombres de archivo
+    for (char *c = address; *c; c++) {
+        if (*c == ':' || *c == '%' || *c == '/') *c = '_';
+    }
+    int written = snprintf(buffer, size, "%s/%s-%s.hist", history->directory, address,
+                           history->udp ? "udp" : "tcp");
+    return written > 0 && (size_t)written < size ? 0 : -1;
+}
+
+static int map_file(const char *path, int flags, HistoryMap *map) {
+    struct stat info;
+    map->data = NULL;
+    map->size = 0;
+    map->fd = open(path, flags);
+    if (map->fd < 0) return -1;
+    if (fstat(map->fd, &info) != 0) {
+        close(map->fd);
+        map->fd = -1;
+        return -1;
+    }
+    map->size = (size_t)info.st_size;
+    if (map->size > 0) {
+        void *data = mmap(NULL, map->size, PROT_READ, MAP_SHARED, map->fd, 0);
+        if (data == MAP_FAILED) {
+            close(map->fd);
+            map->fd = -1;
+            return -1;
+        }
+        map->data = (const uint8_t*)data;
+    }
+    return 0;
+}
+
+static void unmap_file(HistoryMap *map) {
+    if (map->data) munmap((void*)map->data, map->size);
+    if (map->fd >= 0) close(map->fd);
+    map->data = NULL;
+    map->fd = -1;
+}
+
+static int read_record_header(const HistoryMap *map, size_t offset, int64_t *timestamp,
+                              uint32_t *type, uint32_t *length) {
+    if (offset + RECORD_HEADER_SIZE > map->size) return -1;
+    uint32_t checksum;
+    memcpy(timestamp, map->data + offset, 8);
+    memcpy(type, map->data + offset + 8, 4);
+    memcpy(length, map->data + offset + 12, 4);
+    memcpy(&checksum, map->data + offset + 16, 4);
+    if (*length > map->size - offset - RECORD_HEADER_SIZE) return -1;
+    if (*type != SCAN_HISTORY_FULL && *type != SCAN_HISTORY_DELTA) return -1;
+    if (record_checksum(*timestamp, *type, map->data + offset + RECORD_HEADER_SIZE, *length) != checksum) {
+        return -1;
+    }
+    return 0;
+}
+
+// Última instantánea completa del índice anterior o igual a 'when' (0 si no sirve)
+static size_t find_keyframe(const char *path, const HistoryMap *map, time_t when) {
+    char index_path[SCAN_HISTORY_PATH_SIZE + 8];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+
+    HistoryMap index;
+    if (map_file(index_path, O_RDONLY, &index) != 0) return 0;
+
+    const uint8_t *entries = index.data;
+    size_t count = index.size / sizeof(HistoryIndexEntry);
+    size_t low = 0;
+    size_t high = count;
+    while (low < high) {
+        size_t middle = (low + high) / 2;
+        HistoryIndexEntry entry;
+        memcpy(&entry, entries + middle * sizeof(entry), sizeof(entry));
+        if (entry.timestamp <= (int64_t)when) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+
+    // Retroceder si la entrada apunta más allá de los datos (corte antes de escribirlos)
+    size_t offset = 0;
+    while (low > 0 && offset == 0) {
+        HistoryIndexEntry entry;
+        memcpy(&entry, entries + (low - 1) * sizeof(entry), sizeof(entry));
+        low--;
+
+        int64_t timestamp;
+        uint32_t type;
+        uint32_t length;
+        if (entry.offset >= SCAN_HISTORY_HEADER_SIZE && entry.offset < map->size &&
+            read_record_header(map, entry.offset, &timestamp, &type, &length) == 0 &&
+            type == SCAN_HISTORY_FULL && timestamp == entry.timestamp) {
+            offset = entry.offset;
+        }
+    }
+    unmap_file(&index);
+    return offset;
+}
+
+// Reconstruye en 'state' los puertos abiertos en el instante 'when'
+static int replay(const char *path, const HistoryMap *map, time_t when, PortSet *state,
+                  HistoryReplay *result) {
+    port_set_clear(state);
+    result->found = 0;
+    result->since = 0;
+    result->end = SCAN_HISTORY_HEADER_SIZE;
+    result->since_key = 0;
+
+    if (map->size < SCAN_HISTORY_HEADER_SIZE ||
+        memcmp(map->data, SCAN_HISTORY_MAGIC, strlen(SCAN_HISTORY_MAGIC)) != 0) {
+        return -1;
+    }
+
+    size_t offset = find_keyframe(path, map, when);
+    if (offset == 0) offset = SCAN_HISTORY_HEADER_SIZE;
+
+    while (offset < map->size) {
+        int64_t timestamp;
+        uint32_t type;
+        uint32_t length;
+        if (read_record_header(map, offset, &timestamp, &type, &length) != 0) break;
+        if (timestamp > (int64_t)when) break;
+
+        const uint8_t *payload = map->data + offset + RECORD_HEADER_SIZE;
+        size_t position = 0;
+        if (type == SCAN_HISTORY_FULL) {
+            port_set_clear(state);
+            if (decode_ports(payload, length, &position, state, 1) != 0) break;
+            result->since_key = 0;
+        } else {
+            if (decode_ports(payload, length, &position, state, 1) != 0 ||
+                decode_ports(payload, length, &position, state, 0) != 0) {
+                break;
+            }
+            result->since_key++;
+        }
+        result->found = 1;
+        result->since = (time_t)timestamp;
+        offset += RECORD_HEADER_SIZE + length;
+        result->end = offset;
+    }
+    return 0;
+}
+
+ScanHistory* scan_history_open(const char *directory, int udp) {
+    if (!directory || !*directory) return NULL;
+    if (mkdir(directory, 0755) != 0 && errno != EEXIST) return NULL;
+
+    ScanHistory *history = malloc(sizeof(ScanHistory));
+    if (!history) return NULL;
+    history->directory = strdup(directory);
+    if (!history->directory) {
+        free(history);
+        return NULL;
+    }
+    history->udp = udp;
+    history->records = 0;
+    history->bytes = 0;
+    return history;
+}
+
+void scan_history_close(ScanHistory *history) {
+    if (history) {
+        free(history->directory);
+        free(history);
+    }
+}
+
+// Puertos abiertos del host en el instante 'when' (SCAN_HISTORY_LATEST = último estado).
+// Devuelve 1 si hay historial, 0 si no lo hay y -1 si el archivo está dañado
+int scan_history_at(const ScanHistory *history, const ScanHost *host, time_t when, PortSet *open_ports,
+                    time_t *since) {
+    char path[SCAN_HISTORY_PATH_SIZE];
+    if (!history || scan_history_path(history, host, path, sizeof(path)) != 0) return -1;
+
+    HistoryMap map;
+    if (map_file(path, O_RDONLY, &map) != 0) {
+        port_set_clear(open_ports);
+        return errno == ENOENT ? 0 : -1;
+    }
+
+    HistoryReplay result;
+    int status = replay(path, &map, when, open_ports, &result);
+    unmap_file(&map);
+    if (status != 0) return -1;
+    if (since) *since = result.since;
+    return result.found;
+}
+
+// Añade el estado del host si cambió respecto al último registro; 0 si no hizo falta
+int scan_history_record(ScanHistory *history, const ScanHost *host, time_t when, const PortSet *open_ports) {
+    static const PortSet empty_set;
+    char path[SCAN_HISTORY_PATH_SIZE];
+    if (!history || scan_history_path(history, host, path, sizeof(path)) != 0) return -1;
+    if (!open_ports) open_ports = &empty_set;
+
+    PortSet *sets = malloc(3 * sizeof(PortSet));
+    if (!sets) return -1;
+    PortSet *state = &sets[0];
+    PortSet *added = &sets[1];
+    PortSet *removed = &sets[2];
+
+    // Estado actual del archivo; sin archivo, un host sin puertos no necesita historial
+    HistoryReplay result;
+    HistoryMap map;
+    int fd;
+    int fresh = 0;
+    char index_path[SCAN_HISTORY_PATH_SIZE + 8];
+    snprintf(index_path, sizeof(index_path), "%s.idx", path);
+    if (map_file(path, O_RDWR, &map) == 0) {
+        // Un archivo sin cabecera completa es un corte durante su creación
+        int status = 0;
+        if (map.size < SCAN_HISTORY_HEADER_SIZE) {
+            fresh = 1;
+        } else {
+            status = replay(path, &map, SCAN_HISTORY_LATEST, state, &result);
+        }
+        fd = map.fd;
+        map.fd = -1;
+        unmap_file(&map);
+        if (status != 0) {
+            close(fd);
+            free(sets);
+            return -1;
+        }
+    } else if (errno == ENOENT) {
+        if (port_set_next(open_ports, 0) < 0) {
+            free(sets);
+            return 0;
+        }
+        fd = open(path, O_RDWR | O_CREAT, 0644);
+        fresh = 1;
+    } else {
+        free(sets);
+        return -1;
+    }
+    
+    if (fresh) {
+        uint8_t header[SCAN_HISTORY_HEADER_SIZE];
+        memset(header, 0, sizeof(header));
+        memcpy(header, SCAN_HISTORY_MAGIC, strlen(SCAN_HISTORY_MAGIC));
+        header[8] = history->udp ? 1 : 0;
+        host_table_address(host, (char*)header + 16, sizeof(header) - 16);
+        if (fd < 0 || pwrite(fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+            if (fd >= 0) close(fd);
+            free(sets);
+            return -1;
+        }
+        unlink(index_path);
+        port_set_clear(state);
+        result.found = 0;
+        result.since = 0;
+        result.end = SCAN_HISTORY_HEADER_SIZE;
+        result.since_key = 0;
+    }
+
+    *added = *open_ports;
+    port_set_difference(added, state);
+    *removed = *state;
+    port_set_difference(removed, open_ports);
+    if (port_set_next(added, 0) < 0 && port_set_next(removed, 0) < 0) {
+        close(fd);
+        free(sets);
+        return 0;
+    }
+
+    // Instantánea completa cuando toca; si no, delta salvo que ocupe más
+    size_t full_bound = encoded_size_bound(open_ports);
+    size_t delta_bound = encoded_size_bound(added) + encoded_size_bound(removed);
+    uint8_t *record = malloc(RECORD_HEADER_SIZE + full_bound + delta_bound);
+    if (!record) {
+        close(fd);
+        free(sets);
+        return -1;
+    }
+    uint8_t *payload = record + RECORD_HEADER_SIZE;
+    uint32_t type = SCAN_HISTORY_FULL;
+    size_t length = encode_ports(payload, open_ports);
+    if (result.found && result.since_key + 1 < SCAN_HISTORY_KEYFRAME) {
+        uint8_t *delta = payload + full_bound;
+        size_t delta_length = encode_ports(delta, added);
+        delta_length += encode_ports(delta + delta_length, removed);
+        if (delta_length < length) {
+            memmove(payload, delta, delta_length);
+            length = delta_length;
+            type = SCAN_HISTORY_DELTA;
+        }
+    }
+
+    // Los registros quedan ordenados por instante aunque el reloj retroceda
+    int64_t timestamp = (int64_t)(when < result.since ? result.since : when);
+    uint32_t stored_length = (uint32_t)length;
+    uint32_t checksum = record_checksum(timestamp, type, payload, stored_length);
+    memcpy(record, &timestamp, 8);
+    memcpy(record + 8, &type, 4);
+    memcpy(record + 12, &stored_length, 4);
+    memcpy(record + 16, &checksum, 4);
+
+    // Descartar un registro incompleto que hubiera dejado un corte anterior
+    size_t total = RECORD_HEADER_SIZE + length;
+    int status = ftruncate(fd, (off_t)result.end) == 0 &&
+                 pwrite(fd, record, total, (off_t)result.end) == (ssize_t)total &&
+                 fdatasync(fd) == 0 ? 0 : -1;
+    close(fd);
+    free(record);
+    free(sets);
+    if (status != 0) return -1;
+
+    history->records++;
+    history->bytes += total;
+
+    // El índice es sólo una ayuda: si no se puede escribir, las consultas recorren los datos
+    if (type == SCAN_HISTORY_FULL) {
+        int index_fd = open(index_path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+        if (index_fd >= 0) {
+            HistoryIndexEntry entry;
+            entry.timestamp = timestamp;
+            entry.offset = result.end;
+            ssize_t written = write(index_fd, &entry, sizeof(entry));
+            (void)written;
+            close(index_fd);
+        }
+    }
+    return 1;
+}
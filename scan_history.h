@@ -0,0 +1,41 @@
+/*
+ * Scan History - Historial persistente de puertos abiertos por host (--history)
+ */
+
+#ifndef SCAN_HISTORY_H
+#define SCAN_HISTORY_H
+
+#include <stdint.h>
+#include <time.h>
+#include "host_table.h"
+#include "port_set.h"
+
+#define SCAN_HISTORY_MAGIC "MGHIST01"
+#define SCAN_HISTORY_HEADER_SIZE 64
+#define SCAN_HISTORY_KEYFRAME 64        // Deltas como máximo entre dos instantáneas completas
+#define SCAN_HISTORY_PATH_SIZE 4096
+#define SCAN_HISTORY_LATEST ((time_t)INT64_MAX)
+
+typedef enum {
+    SCAN_HISTORY_FULL = 1,      // Instantánea completa de los puertos abiertos
+    SCAN_HISTORY_DELTA = 2      // Puertos abiertos y cerrados desde el registro anterior
+} ScanHistoryRecordType;
+
+typedef struct {
+    char *directory;
+    int udp;                    // Archivos del protocolo UDP (-udp.hist) o TCP (-tcp.hist)
+    unsigned long long records; // Registros añadidos en esta ejecución
+    unsigned long long bytes;
+} ScanHistory;
+
+// Funciones públicas
+ScanHistory* scan_history_open(const char *directory, int udp);
+void scan_history_close(ScanHistory *history);
+int scan_history_record(ScanHistory *history, const ScanHost *host, time_t when, const PortSet *open_ports);
+int scan_history_at(const ScanHistory *history, const ScanHost *host, time_t when, PortSet *open_ports,
+                    time_t *since);
+
+// Funciones auxiliares
+int scan_history_path(const ScanHistory *history, const ScanHost *host, char *buffer, size_t size);
+
+#endif
@@ -0,0 +1,173 @@
+/*
+ * Scan Pacer - Implementación del control de tasa y congestión
+ *
+ * El token bucket fija el presupuesto de sondas por segundo: se recarga con
+ * el reloj monotónico y su capacidad equivale a ~10 ms de tráfico, de modo
+ * que la tasa se mantiene suave aunque los motores despierten por ticks.
+ *
+ * Las ventanas AIMD siguen a TCP: slow start hasta ssthresh, luego +1 por
+ * ventana completa de respuestas, y a la mitad ante una pérdida. Un plazo
+ * vencido por sí solo es ambiguo (un puerto filtrado nunca responde), así
+ * que, como nmap, se considera pérdida que responda una sonda reenviada
+ * (el envío anterior se perdió) o que llegue un ICMP de inalcanzable. Cada
+ * host tiene su propia ventana además de la global, y las reducciones se
+ * limitan a una por SCAN_PACER_DECREASE_HOLD_US para no colapsar la ventana
+ * por una ráfaga de pérdidas del mismo evento.
+ *
+ * Una sonda que no cabe en la ventana de su host queda aparcada en el plan
+ * (scan_plan_park) y sólo se libera aquí, cuando ese host cierra una sonda y
+ * deja un hueco: los demás hosts siguen recibiendo sondas mientras tanto.
+ */
+
+#include <stdlib.h>
+#include <errno.h>
+#include "scan_pacer.h"
+#include "rtt_estimator.h"
+
+static void window_init(CongestionWindow *window, double initial, double ssthresh) {
+    window->cwnd = initial;
+    window->ssthresh = ssthresh;
+    window->last_decrease_us = 0;
+}
+
+static void window_grow(CongestionWindow *window, double max_window) {
+    if (window->cwnd < window->ssthresh) {
+        window->cwnd += 1.0;                    // Slow start: se duplica por RTT
+    } else {
+        window->cwnd += 1.0 / window->cwnd;     // Crecimiento lineal
+    }
+    if (window->cwnd > max_window) window->cwnd = max_window;
+}
+
+static int window_shrink(CongestionWindow *window, uint64_t now_us) {
+    if (now_us - window->last_decrease_us < SCAN_PACER_DECREASE_HOLD_US) return 0;
+
+    window->ssthresh = window->cwnd / 2.0;
+    if (window->ssthresh < SCAN_PACER_MIN_WINDOW) window->ssthresh = SCAN_PACER_MIN_WINDOW;
+    window->cwnd = window->ssthresh;
+    window->last_decrease_us = now_us;
+    return 1;
+}
+
+ScanPacer* scan_pacer_create(int host_count, double rate, int congestion, int max_inflight) {
+    ScanPacer *pacer = calloc(1, sizeof(ScanPacer));
+    if (!pacer) return NULL;
+
+    pacer->rate = rate > 0 ? rate : 0;
+    pacer->burst = rate / 100.0 > 1.0 ? rate / 100.0 : 1.0;
+    pacer->tokens = pacer->burst;
+    pacer->last_refill_us = rtt_now_us();
+
+    pacer->congestion = congestion;
+    pacer->max_window = max_inflight > 0 ? max_inflight : 1;
+    window_init(&pacer->global, SCAN_PACER_INITIAL_WINDOW, pacer->max_window);
+    pacer->host_count = host_count;
+    if (congestion) {
+        pacer->hosts = malloc(host_count * sizeof(CongestionWindow));
+        pacer->host_inflight = calloc(host_count, sizeof(uint16_t));
+        if (!pacer->hosts || !pacer->host_inflight) {
+            scan_pacer_destroy(pacer);
+            return NULL;
+        }
+        for (int i = 0; i < host_count; i++) {
+            window_init(&pacer->hosts[i], SCAN_PACER_HOST_WINDOW, pacer->max_window);
+        }
+    }
+    return pacer;
+}
+
+void scan_pacer_destroy(ScanPacer *pacer) {
+    if (!pacer) return;
+    free(pacer->hosts);
+    free(pacer->host_inflight);
+    free(pacer);
+}
+
+static void refill(ScanPacer *pacer) {
+    uint64_t now = rtt_now_us();
+    pacer->tokens += (double)(now - pacer->last_refill_us) * pacer->rate / 1000000.0;
+    if (pacer->tokens > pacer->burst) pacer->tokens = pacer->burst;
+    pacer->last_refill_us = now;
+}
+
+int scan_pacer_ready(ScanPacer *pacer) {
+    if (!pacer) return 1;
+
+    if (pacer->congestion && pacer->inflight >= (int)pacer->global.cwnd) return 0;
+    if (pacer->rate > 0) {
+        refill(pacer);
+        if (pacer->tokens < 1.0) return 0;
+    }
+    return 1;
+}
+
+int scan_pacer_admit(ScanPacer *pacer, int host) {
+    if (!pacer) return 1;
+
+    if (pacer->congestion) {
+        if (pacer->host_inflight[host] >= (int)pacer->hosts[host].cwnd ||
+            pacer->host_inflight[host] == UINT16_MAX) {
+            return 0;
+        }
+        pacer->host_inflight[host]++;
+        pacer->inflight++;
+    }
+    if (pacer->rate > 0) {
+        pacer->tokens -= 1.0;
+    }
+    return 1;
+}
+
+void scan_pacer_settle(ScanPacer *pacer, int host, int attempt, PacerOutcome outcome) {
+    if (!pacer || !pacer->congestion) return;
+
+    pacer->host_inflight[host]--;
+    pacer->inflight--;
+
+    // Respuesta a un reenvío: el envío anterior se perdió por el camino
+    int lost = outcome == PACER_UNREACHABLE || (outcome == PACER_RESPONSE && attempt > 0);
+    if (lost) {
+        uint64_t now = rtt_now_us();
+        pacer->losses++;
+        window_shrink(&pacer->hosts[host], now);
+        window_shrink(&pacer->global, now);
+    } else if (outcome == PACER_RESPONSE) {
+        pacer->responses++;
+        window_grow(&pacer->hosts[host], pacer->max_window);
+        window_grow(&pacer->global, pacer->max_window);
+    }
+    
+    // Huecos libres en la ventana del host: sus sondas aparcadas, en orden
+    ScanPlan *plan = pacer->plan;
+    if (plan && scan_plan_held(plan, host)) {
+        while (pacer->host_inflight[host] + plan->host_released[host] < (int)pacer->hosts[host].cwnd &&
+               scan_plan_release(plan, host)) {
+        }
+    }
+}
+
+int scan_pacer_wait_ms(ScanPacer *pacer) {
+    if (!pacer || pacer->rate <= 0) return 0;
+
+    refill(pacer);
+    if (pacer->tokens >= 1.0) return 0;
+    int wait = (int)((1.0 - pacer->tokens) * 1000.0 / pacer->rate) + 1;
+    return wait;
+}
+
+PacerOutcome scan_pacer_outcome(int error) {
+    switch (error) {
+        case 0:
+        case ECONNREFUSED:
+            return PACER_RESPONSE;
+        case EHOSTUNREACH:
+        case ENETUNREACH:
+        case EHOSTDOWN:
+            return PACER_UNREACHABLE;
+        case ETIMEDOUT:
+        case ECANCELED:
+            return PACER_TIMEOUT;
+        default:
+            return PACER_ABORTED;
+    }
+}
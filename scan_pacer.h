@@ -0,0 +1,63 @@
+/*
+ * Scan Pacer - Límite de tasa (token bucket) y control de congestión AIMD
+ */
+
+#ifndef SCAN_PACER_H
+#define SCAN_PACER_H
+
+#include <stdint.h>
+#include "scan_plan.h"
+
+#define SCAN_PACER_INITIAL_WINDOW 10.0      // Ventana global inicial (slow start)
+#define SCAN_PACER_HOST_WINDOW 4.0          // Ventana inicial por host
+#define SCAN_PACER_MIN_WINDOW 1.0
+#define SCAN_PACER_DECREASE_HOLD_US 200000  // Como mucho una reducción por intervalo
+
+// Desenlace de una sonda admitida por el pacer
+typedef enum {
+    PACER_RESPONSE,         // SYN-ACK o RST: el host respondió
+    PACER_TIMEOUT,          // Sin respuesta (ambiguo: filtrado o perdido)
+    PACER_UNREACHABLE,      // ICMP de host/red inalcanzable
+    PACER_ABORTED           // Fallo local, no dice nada de la red
+} PacerOutcome;
+
+typedef struct {
+    double cwnd;            // Sondas en vuelo permitidas
+    double ssthresh;        // Umbral entre slow start y crecimiento lineal
+    uint64_t last_decrease_us;
+} CongestionWindow;
+
+typedef struct {
+    // Token bucket global (rate = 0 desactiva el límite)
+    double rate;            // Sondas por segundo
+    double burst;           // Capacidad del bucket
+    double tokens;
+    uint64_t last_refill_us;
+
+    // Ventanas AIMD (congestion = 0 las desactiva)
+    int congestion;
+    double max_window;
+    CongestionWindow global;
+    int inflight;
+    CongestionWindow *hosts;
+    uint16_t *host_inflight;
+    int host_count;
+    ScanPlan *plan;         // Plan en curso: recibe las sondas aparcadas que se liberan
+
+    // Estadísticas
+    unsigned long long losses;
+    unsigned long long responses;
+} ScanPacer;
+
+// Funciones públicas
+ScanPacer* scan_pacer_create(int host_count, double rate, int congestion, int max_inflight);
+void scan_pacer_destroy(ScanPacer *pacer);
+int scan_pacer_ready(ScanPacer *pacer);
+int scan_pacer_admit(ScanPacer *pacer, int host);
+void scan_pacer_settle(ScanPacer *pacer, int host, int attempt, PacerOutcome outcome);
+int scan_pacer_wait_ms(ScanPacer *pacer);
+
+// Funciones auxiliares
+PacerOutcome scan_pacer_outcome(int error);
+
+#endif
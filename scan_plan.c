@@ -0,0 +1,323 @@
+/*
+ * Scan Plan - Implementación del planificador de sondas
+ *
+ * El espacio de sondas es host x puerto, recorrido con el host como índice
+ * rápido: la sonda i va al host i % H y al puerto de rango i / H. Así cada
+ * host recibe una sonda por vuelta y un host lento o filtrado sólo ocupa su
+ * parte proporcional de la ventana de conexiones, sin frenar al resto.
+ *
+ * En modo aleatorio el índice i pasa antes por una permutación con clave:
+ * una red Feistel sobre el menor dominio de 2^(2k) >= total, con "cycle
+ * walking" (se reaplica mientras el resultado caiga fuera de rango). Cada
+ * índice aparece exactamente una vez, el estado es sólo el cursor y las
+ * claves de ronda, y la misma semilla reproduce el mismo orden.
+ *
+ * El puerto de rango r se obtiene del PortSet con una búsqueda binaria sobre
+ * el número de puertos acumulado por palabra, sin expandir la lista.
+ *
+ * La red Feistel es invertible, así que una sonda (host, puerto) también se
+ * puede llevar de vuelta a su posición en el recorrido; los checkpoints usan
+ * esa posición para saber qué sondas completó un escaneo interrumpido.
+ *
+ * Las sondas que expiran sin respuesta vuelven a la cola de reintentos, que
+ * tiene prioridad sobre las sondas nuevas para que el escaneo no termine con
+ * resultados ambiguos pendientes. La misma cola recibe, sin contar como
+ * reintento, las sondas que no llegaron a enviarse (sin descriptores libres o
+ * en vuelo al guardar un checkpoint).
+ *
+ * Una sonda cuyo host tiene la ventana de congestión llena no vuelve a esa
+ * cola: queda aparcada en una cola FIFO propia del host mientras el cursor
+ * sigue avanzando con los demás. Cuando el host libera un hueco
+ * (scan_pacer_settle) su primera sonda aparcada pasa a la cola de liberadas,
+ * que se sirve antes que nada. Así un host lento sólo retiene sus sondas y no
+ * las del resto del barrido.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "scan_plan.h"
+
+static uint64_t mix64(uint64_t x) {
+    // Finalizador de splitmix64
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+int scan_plan_init(ScanPlan *plan, const PortSet *ports, int host_count) {
+    if (!plan || !ports || host_count <= 0) return -1;
+
+    uint32_t rank = 0;
+    for (int word = 0; word < PORT_SET_WORDS; word++) {
+        plan->word_rank[word] = rank;
+        rank += (uint32_t)__builtin_popcountll(ports->bits[word]);
+    }
+
+    plan->ports = ports;
+    plan->port_count = (int)rank;
+    plan->host_count = host_count;
+    plan->total = (uint64_t)host_count * (uint64_t)plan->port_count;
+    plan->cursor = 0;
+    plan->randomized = 0;
+    plan->half_bits = 0;
+    memset(plan->round_keys, 0, sizeof(plan->round_keys));
+    plan->retries = NULL;
+    plan->retry_head = 0;
+    plan->retry_tail = 0;
+    plan->retry_capacity = 0;
+    plan->parked = NULL;
+    plan->parked_capacity = 0;
+    plan->parked_free = -1;
+    plan->parked_count = 0;
+    plan->host_parked_head = NULL;
+    plan->host_parked_tail = NULL;
+    plan->host_released = NULL;
+    plan->released_head = -1;
+    plan->released_tail = -1;
+    return 0;
+}
+
+void scan_plan_randomize(ScanPlan *plan, uint64_t seed) {
+    // Dominio de 2k bits con 2^(2k) >= total (mínimo 2 bits)
+    int bits = 2;
+    while (bits < 64 && (1ULL << bits) < plan->total) {
+        bits += 2;
+    }
+
+    plan->randomized = 1;
+    plan->half_bits = bits / 2;
+    uint64_t state = seed;
+    for (int round = 0; round < SCAN_PLAN_FEISTEL_ROUNDS; round++) {
+        state = mix64(state);
+        plan->round_keys[round] = state;
+    }
+}
+
+void scan_plan_destroy(ScanPlan *plan) {
+    if (!plan) return;
+    free(plan->retries);
+    plan->retries = NULL;
+    free(plan->parked);
+    plan->parked = NULL;
+    free(plan->host_parked_head);
+    plan->host_parked_head = NULL;
+}
+
+uint64_t scan_plan_permute(const ScanPlan *plan, uint64_t index) {
+    if (!plan->randomized) return index;
+
+    uint64_t mask = (1ULL << plan->half_bits) - 1;
+    do {
+        uint64_t left = index >> plan->half_bits;
+        uint64_t right = index & mask;
+        for (int round = 0; round < SCAN_PLAN_FEISTEL_ROUNDS; round++) {
+            uint64_t next = left ^ (mix64(right ^ plan->round_keys[round]) & mask);
+            left = right;
+            right = next;
+        }
+        index = (left << plan->half_bits) | right;
+    } while (index >= plan->total);     // Cycle walking: como máximo ~4 vueltas en promedio
+    return index;
+}
+
+uint64_t scan_plan_unpermute(const ScanPlan *plan, uint64_t index) {
+    if (!plan->randomized) return index;
+
+    // Rondas en orden inverso; el cycle walking se deshace igual que se hizo
+    uint64_t mask = (1ULL << plan->half_bits) - 1;
+    do {
+        uint64_t left = index >> plan->half_bits;
+        uint64_t right = index & mask;
+        for (int round = SCAN_PLAN_FEISTEL_ROUNDS - 1; round >= 0; round--) {
+            uint64_t previous = right ^ (mix64(left ^ plan->round_keys[round]) & mask);
+            right = left;
+            left = previous;
+        }
+        index = (left << plan->half_bits) | right;
+    } while (index >= plan->total);
+    return index;
+}
+
+int scan_plan_rank_of(const ScanPlan *plan, int port) {
+    int word = port / 64;
+    uint64_t below = plan->ports->bits[word] & ((1ULL << (port % 64)) - 1);
+    return (int)plan->word_rank[word] + __builtin_popcountll(below);
+}
+
+int scan_plan_port_at(const ScanPlan *plan, int rank) {
+    // Última palabra cuyo acumulado no supera el rango
+    int low = 0;
+    int high = PORT_SET_WORDS - 1;
+    while (low < high) {
+        int middle = (low + high + 1) / 2;
+        if (plan->word_rank[middle] <= (uint32_t)rank) {
+            low = middle;
+        } else {
+            high = middle - 1;
+        }
+    }
+
+    // Saltar los bits previos dentro de la palabra
+    uint64_t bits = plan->ports->bits[low];
+    for (uint32_t skip = (uint32_t)rank - plan->word_rank[low]; skip > 0; skip--) {
+        bits &= bits - 1;
+    }
+    return low * 64 + __builtin_ctzll(bits);
+}
+
+int scan_plan_next(ScanPlan *plan, ScanProbe *probe) {
+    if (plan->retry_head < plan->retry_tail) {
+        *probe = plan->retries[plan->retry_head++];
+        if (plan->retry_head == plan->retry_tail) {
+            plan->retry_head = plan->retry_tail = 0;
+        }
+        return 1;
+    }
+    if (plan->cursor >= plan->total) return 0;
+
+    scan_plan_probe_at(plan, plan->cursor++, probe);
+    return 1;
+}
+
+void scan_plan_probe_at(const ScanPlan *plan, uint64_t position, ScanProbe *probe) {
+    uint64_t index = scan_plan_permute(plan, position);
+    probe->host = (int)(index % (uint64_t)plan->host_count);
+    probe->port = scan_plan_port_at(plan, (int)(index / (uint64_t)plan->host_count));
+    probe->attempt = 0;
+}
+
+uint64_t scan_plan_position(const ScanPlan *plan, int host, int port) {
+    uint64_t index = (uint64_t)scan_plan_rank_of(plan, port) * (uint64_t)plan->host_count + (uint64_t)host;
+    return scan_plan_unpermute(plan, index);
+}
+
+static int push_retry(ScanPlan *plan, const ScanProbe *probe, int increment) {
+    if (plan->retry_tail >= plan->retry_capacity) {
+        // Compactar antes de crecer: la cola se vacía desde el principio
+        if (plan->retry_head > 0) {
+            memmove(plan->retries, plan->retries + plan->retry_head,
+                    (plan->retry_tail - plan->retry_head) * sizeof(ScanProbe));
+            plan->retry_tail -= plan->retry_head;
+            plan->retry_head = 0;
+        } else {
+            int new_capacity = plan->retry_capacity == 0 ? 256 : plan->retry_capacity * 2;
+            ScanProbe *grown = realloc(plan->retries, new_capacity * sizeof(ScanProbe));
+            if (!grown) return -1;
+            plan->retries = grown;
+            plan->retry_capacity = new_capacity;
+        }
+    }
+
+    plan->retries[plan->retry_tail] = *probe;
+    plan->retries[plan->retry_tail].attempt += increment;
+    plan->retry_tail++;
+    return 0;
+}
+
+int scan_plan_retry(ScanPlan *plan, const ScanProbe *probe) {
+    return push_retry(plan, probe, 1);
+}
+
+int scan_plan_defer(ScanPlan *plan, const ScanProbe *probe) {
+    return push_retry(plan, probe, 0);
+}
+
+// Las aparcadas no cuentan: esperan a que su host responda o expire, y el motor ya
+// sigue en marcha mientras tenga sondas en vuelo
+int scan_plan_pending(const ScanPlan *plan) {
+    return plan->released_head >= 0 || plan->retry_head < plan->retry_tail || plan->cursor < plan->total;
+}
+
+static int alloc_parked(ScanPlan *plan) {
+    if (!plan->host_parked_head) {
+        // Cabeza, cola y liberadas por host en un solo bloque
+        int *hosts = malloc(3 * (size_t)plan->host_count * sizeof(int));
+        if (!hosts) return -1;
+        plan->host_parked_head = hosts;
+        plan->host_parked_tail = hosts + plan->host_count;
+        plan->host_released = hosts + 2 * plan->host_count;
+        for (int h = 0; h < plan->host_count; h++) {
+            plan->host_parked_head[h] = -1;
+            plan->host_parked_tail[h] = -1;
+            plan->host_released[h] = 0;
+        }
+    }
+    if (plan->parked_free < 0) {
+        int capacity = plan->parked_capacity == 0 ? 256 : plan->parked_capacity * 2;
+        ScanParkedProbe *grown = realloc(plan->parked, capacity * sizeof(ScanParkedProbe));
+        if (!grown) return -1;
+        for (int i = capacity - 1; i >= plan->parked_capacity; i--) {
+            grown[i].next = plan->parked_free;
+            plan->parked_free = i;
+        }
+        plan->parked = grown;
+        plan->parked_capacity = capacity;
+    }
+    int node = plan->parked_free;
+    plan->parked_free = plan->parked[node].next;
+    return node;
+}
+
+// Aparca la sonda en la cola de su host (al principio si 'front': vuelve a esperar turno)
+int scan_plan_park(ScanPlan *plan, const ScanProbe *probe, int front) {
+    int node = alloc_parked(plan);
+    if (node < 0) return -1;
+
+    int host = probe->host;
+    plan->parked[node].probe = *probe;
+    if (front) {
+        plan->parked[node].next = plan->host_parked_head[host];
+        plan->host_parked_head[host] = node;
+        if (plan->host_parked_tail[host] < 0) plan->host_parked_tail[host] = node;
+    } else {
+        plan->parked[node].next = -1;
+        if (plan->host_parked_tail[host] >= 0) {
+            plan->parked[plan->host_parked_tail[host]].next = node;
+        } else {
+            plan->host_parked_head[host] = node;
+        }
+        plan->host_parked_tail[host] = node;
+    }
+    plan->parked_count++;
+    return 0;
+}
+
+// Pasa la primera sonda aparcada del host a la cola de liberadas; 0 si no tenía
+int scan_plan_release(ScanPlan *plan, int host) {
+    if (!plan->host_parked_head || plan->host_parked_head[host] < 0) return 0;
+
+    int node = plan->host_parked_head[host];
+    plan->host_parked_head[host] = plan->parked[node].next;
+    if (plan->host_parked_head[host] < 0) plan->host_parked_tail[host] = -1;
+
+    plan->parked[node].next = -1;
+    if (plan->released_tail >= 0) {
+        plan->parked[plan->released_tail].next = node;
+    } else {
+        plan->released_head = node;
+    }
+    plan->released_tail = node;
+    plan->host_released[host]++;
+    return 1;
+}
+
+int scan_plan_next_released(ScanPlan *plan, ScanProbe *probe) {
+    int node = plan->released_head;
+    if (node < 0) return 0;
+
+    plan->released_head = plan->parked[node].next;
+    if (plan->released_head < 0) plan->released_tail = -1;
+    *probe = plan->parked[node].probe;
+    plan->host_released[probe->host]--;
+    plan->parked_count--;
+    plan->parked[node].next = plan->parked_free;
+    plan->parked_free = node;
+    return 1;
+}
+
+// El host tiene sondas aparcadas o liberadas por entregar: las nuevas van detrás
+int scan_plan_held(const ScanPlan *plan, int host) {
+    return plan->host_parked_head &&
+           (plan->host_parked_head[host] >= 0 || plan->host_released[host] > 0);
+}
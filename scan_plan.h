@@ -0,0 +1,71 @@
+/*
+ * Scan Plan - Planificador de sondas host x puerto compartido por los motores
+ */
+
+#ifndef SCAN_PLAN_H
+#define SCAN_PLAN_H
+
+#include <stdint.h>
+#include "port_set.h"
+
+#define SCAN_PLAN_FEISTEL_ROUNDS 4
+
+typedef struct {
+    int host;               // Índice en la tabla de hosts
+    int port;
+    int attempt;            // 0 = primer envío
+} ScanProbe;
+
+// Sonda aparcada: la ventana de su host estaba llena
+typedef struct {
+    ScanProbe probe;
+    int next;               // Siguiente del mismo host, de liberadas o libre (-1 = fin)
+} ScanParkedProbe;
+
+typedef struct {
+    const PortSet *ports;   // Conjunto a recorrer (no se copia ni se expande)
+    uint32_t word_rank[PORT_SET_WORDS];     // Puertos en las palabras anteriores
+    int port_count;
+    int host_count;
+    uint64_t total;         // host_count * port_count
+    uint64_t cursor;        // Índice de la próxima sonda
+    int randomized;         // Recorrer una permutación con clave en lugar de en orden
+    int half_bits;          // Ancho de cada mitad de la red Feistel
+    uint64_t round_keys[SCAN_PLAN_FEISTEL_ROUNDS];
+    ScanProbe *retries;     // Cola FIFO de sondas sin respuesta a reintentar
+    int retry_head;
+    int retry_tail;
+    int retry_capacity;
+    ScanParkedProbe *parked;    // Nodos de las sondas aparcadas por host
+    int parked_capacity;
+    int parked_free;            // Lista de nodos libres
+    int parked_count;           // Aparcadas y liberadas aún sin entregar
+    int *host_parked_head;      // Por host: cola FIFO de aparcadas (-1 = vacía)
+    int *host_parked_tail;
+    int *host_released;         // Por host: liberadas aún sin entregar
+    int released_head;          // Cola de liberadas, servida antes que todo lo demás
+    int released_tail;
+} ScanPlan;
+
+// Funciones públicas
+int scan_plan_init(ScanPlan *plan, const PortSet *ports, int host_count);
+void scan_plan_randomize(ScanPlan *plan, uint64_t seed);
+void scan_plan_destroy(ScanPlan *plan);
+int scan_plan_next(ScanPlan *plan, ScanProbe *probe);
+int scan_plan_retry(ScanPlan *plan, const ScanProbe *probe);
+int scan_plan_defer(ScanPlan *plan, const ScanProbe *probe);
+int scan_plan_pending(const ScanPlan *plan);
+int scan_plan_park(ScanPlan *plan, const ScanProbe *probe, int front);
+int scan_plan_release(ScanPlan *plan, int host);
+int scan_plan_next_released(ScanPlan *plan, ScanProbe *probe);
+int scan_plan_held(const ScanPlan *plan, int host);
+
+// Funciones auxiliares
+void scan_plan_probe_at(const ScanPlan *plan, uint64_t position, ScanProbe *probe);
+uint64_t scan_plan_position(const ScanPlan *plan, int host, int port);
+uint64_t scan_plan_permute(const ScanPlan *plan, uint64_t index);
+uint64_t scan_plan_unpermute(const ScanPlan *plan, uint64_t index);
+int scan_plan_port_at(const ScanPlan *plan, int rank);
+int scan_plan_rank_of(const ScanPlan *plan, int port);
+
+#endif
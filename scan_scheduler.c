@@ -0,0 +1,175 @@
+/*
+ * Scan Scheduler - Implementación del planificador por niveles
+ *
+ * En modo continuo clásico cada intervalo se vuelve a barrer el rango entero,
+ * de modo que el 31337 se comprueba tan a menudo como el 40000. Aquí cada
+ * puerto tiene su propio periodo según su nivel:
+ *
+ *   caliente  sospechosos o de severidad alta, cada pocos segundos
+ *   templado  servicios conocidos, cada --interval
+ *   frío      puertos sin clasificar, repartido en porciones para cubrirlo en
+ *             SCAN_SCHEDULER_COLD_FACTOR intervalos
+ *
+ * Los puertos que cambian de estado (abierto <-> cerrado) pasan a caliente
+ * durante SCAN_SCHEDULER_VOLATILE_HOLD segundos por cambio reciente. El
+ * periodo del nivel frío se alarga si hace falta para que el total de sondas
+ * no supere al del barrido completo cada intervalo.
+ *
+ * El plan de escaneo sondea el mismo conjunto de puertos en todos los hosts,
+ * así que la planificación es por puerto: un cambio en cualquier host adelanta
+ * ese puerto en todos.
+ */
+
+#include <stdlib.h>
+#include "scan_scheduler.h"
+#include "port_classifier.h"
+
+static ScanTier classify_port(int port) {
+    const PortClass *entry = port_classifier_lookup(port);
+    if ((entry->flags & PORT_FLAG_SUSPICIOUS) || entry->severity == ALERT_HIGH) {
+        return SCAN_TIER_HOT;
+    }
+    if (entry->flags & PORT_FLAG_SERVICE) {
+        return SCAN_TIER_WARM;
+    }
+    return SCAN_TIER_COLD;
+}
+
+// Redondea un periodo hacia arriba al múltiplo del ciclo (periodo caliente)
+static int round_to_tick(int period, int tick) {
+    return (period + tick - 1) / tick * tick;
+}
+
+static ScheduledPort* find_port(ScanScheduler *scheduler, int port) {
+    int low = 0;
+    int high = scheduler->count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (scheduler->entries[middle].port == port) return &scheduler->entries[middle];
+        if (scheduler->entries[middle].port < port) {
+            low = middle + 1;
+        } else {
+            high = middle - 1;
+        }
+    }
+    return NULL;
+}
+
+ScanScheduler* scan_scheduler_create(const PortSet *ports, int hot_period, int interval, time_t now) {
+    int count = ports ? port_set_count(ports) : 0;
+    if (count == 0 || hot_period < 1 || interval < 1) return NULL;
+
+    ScanScheduler *scheduler = calloc(1, sizeof(ScanScheduler));
+    if (!scheduler) return NULL;
+    scheduler->entries = malloc(count * sizeof(ScheduledPort));
+    if (!scheduler->entries) {
+        free(scheduler);
+        return NULL;
+    }
+
+    int index = 0;
+    for (int port = port_set_next(ports, 0); port >= 0; port = port_set_next(ports, port + 1)) {
+        ScheduledPort *entry = &scheduler->entries[index++];
+        entry->port = (uint16_t)port;
+        entry->tier = (uint8_t)classify_port(port);
+        entry->flips = 0;
+        entry->last_flip = 0;
+        scheduler->tier_count[entry->tier]++;
+    }
+    scheduler->count = count;
+
+    // Periodos: el caliente marca el ciclo y el resto son múltiplos suyos
+    int tick = hot_period < interval ? hot_period : interval;
+    scheduler->period[SCAN_TIER_HOT] = tick;
+    scheduler->period[SCAN_TIER_WARM] = round_to_tick(interval, tick);
+
+    // La cola no debe superar las sondas que sobran del barrido completo
+    int cold = SCAN_SCHEDULER_COLD_FACTOR * interval;
+    double budget = (double)count / interval;
+    double spare = budget - (double)scheduler->tier_count[SCAN_TIER_HOT] / scheduler->period[SCAN_TIER_HOT]
+                          - (double)scheduler->tier_count[SCAN_TIER_WARM] / scheduler->period[SCAN_TIER_WARM];
+    if (spare > 0 && scheduler->tier_count[SCAN_TIER_COLD] / spare > cold) {
+        cold = (int)(scheduler->tier_count[SCAN_TIER_COLD] / spare) + 1;
+    }
+    scheduler->period[SCAN_TIER_COLD] = round_to_tick(cold, tick);
+
+    // Escalonar cada nivel a lo largo de su periodo (la línea base ya los sondeó todos)
+    int seen[SCAN_TIER_COUNT] = {0, 0, 0};
+    for (int i = 0; i < count; i++) {
+        ScheduledPort *entry = &scheduler->entries[i];
+        long long period = scheduler->period[entry->tier];
+        long long slot = ++seen[entry->tier];
+        entry->next_due = now + (time_t)(period * slot / scheduler->tier_count[entry->tier]);
+    }
+    return scheduler;
+}
+
+void scan_scheduler_destroy(ScanScheduler *scheduler) {
+    if (scheduler) {
+        free(scheduler->entries);
+        free(scheduler);
+    }
+}
+
+// Llena 'due' con los puertos que tocan en este ciclo; devuelve cuántos son
+int scan_scheduler_next(ScanScheduler *scheduler, time_t now, PortSet *due) {
+    port_set_clear(due);
+    for (int tier = 0; tier < SCAN_TIER_COUNT; tier++) {
+        scheduler->last_due[tier] = 0;
+    }
+
+    int total = 0;
+    for (int i = 0; i < scheduler->count; i++) {
+        ScheduledPort *entry = &scheduler->entries[i];
+
+        // La volatilidad caduca si el puerto se mantuvo estable lo suficiente
+        if (entry->flips && now - entry->last_flip >= (time_t)SCAN_SCHEDULER_VOLATILE_HOLD * entry->flips) {
+            entry->flips = 0;
+            scheduler->volatile_count--;
+        }
+        if (now < entry->next_due) continue;
+
+        int tier = entry->flips ? SCAN_TIER_HOT : entry->tier;
+        port_set_add(due, entry->port);
+        scheduler->last_due[tier]++;
+        total++;
+
+        entry->next_due += scheduler->period[tier];
+        if (entry->next_due <= now) {
+            entry->next_due = now + scheduler->period[tier];
+        }
+    }
+    return total;
+}
+
+// Un cambio de estado observado en el puerto: subirlo a caliente
+void scan_scheduler_observe(ScanScheduler *scheduler, int port, time_t when) {
+    if (!scheduler) return;
+    ScheduledPort *entry = find_port(scheduler, port);
+    if (!entry) return;
+
+    if (entry->flips == 0) scheduler->volatile_count++;
+    if (entry->flips < SCAN_SCHEDULER_MAX_FLIPS) entry->flips++;
+    entry->last_flip = when;
+
+    time_t soon = when + scheduler->period[SCAN_TIER_HOT];
+    if (entry->next_due > soon) entry->next_due = soon;
+}
+
+// Sondas por segundo y host en régimen estable (sin puertos volátiles)
+double scan_scheduler_rate(const ScanScheduler *scheduler) {
+    double rate = 0;
+    for (int tier = 0; tier < SCAN_TIER_COUNT; tier++) {
+        rate += (double)scheduler->tier_count[tier] / scheduler->period[tier];
+    }
+    return rate;
+}
+
+const char* scan_tier_to_string(ScanTier tier) {
+    switch (tier) {
+        case SCAN_TIER_HOT: return "caliente";
+        case SCAN_TIER_WARM: return "templado";
+        case SCAN_TIER_COLD: return "frío";
+        default: return "desconocido";
+    }
+}
@@ -0,0 +1,51 @@
+/*
+ * Scan Scheduler - Planificador por niveles para el modo continuo (--tiered)
+ */
+
+#ifndef SCAN_SCHEDULER_H
+#define SCAN_SCHEDULER_H
+
+#include <stdint.h>
+#include <time.h>
+#include "port_set.h"
+
+#define SCAN_SCHEDULER_HOT_PERIOD 5         // Segundos entre sondeos de puertos de riesgo
+#define SCAN_SCHEDULER_COLD_FACTOR 10       // La cola larga se recorre en 10 intervalos
+#define SCAN_SCHEDULER_VOLATILE_HOLD 300    // Segundos en caliente por cada cambio observado
+#define SCAN_SCHEDULER_MAX_FLIPS 8
+
+typedef enum {
+    SCAN_TIER_HOT,          // Sospechosos, severidad alta o volátiles
+    SCAN_TIER_WARM,         // Servicios conocidos
+    SCAN_TIER_COLD,         // Sin clasificar: barrido gradual en segundo plano
+    SCAN_TIER_COUNT
+} ScanTier;
+
+typedef struct {
+    uint16_t port;
+    uint8_t tier;           // Nivel por riesgo (fijo)
+    uint8_t flips;          // Cambios abierto/cerrado recientes (0 = estable)
+    time_t last_flip;
+    time_t next_due;
+} ScheduledPort;
+
+typedef struct {
+    ScheduledPort *entries; // Ordenadas por puerto
+    int count;
+    int period[SCAN_TIER_COUNT];
+    int tier_count[SCAN_TIER_COUNT];    // Puertos de cada nivel por riesgo
+    int last_due[SCAN_TIER_COUNT];      // Puertos del último ciclo por nivel efectivo
+    int volatile_count;
+} ScanScheduler;
+
+// Funciones públicas
+ScanScheduler* scan_scheduler_create(const PortSet *ports, int hot_period, int interval, time_t now);
+void scan_scheduler_destroy(ScanScheduler *scheduler);
+int scan_scheduler_next(ScanScheduler *scheduler, time_t now, PortSet *due);
+void scan_scheduler_observe(ScanScheduler *scheduler, int port, time_t when);
+
+// Funciones auxiliares
+double scan_scheduler_rate(const ScanScheduler *scheduler);
+const char* scan_tier_to_string(ScanTier tier);
+
+#endif
@@ -0,0 +1,421 @@
+/*
+ * Scan SYN - Motor de escaneo semiabierto (SYN) sobre sockets raw
+ *
+ * En lugar de un connect() por sonda se construyen los segmentos SYN a mano
+ * y se envían en lotes con sendmmsg() por un único socket raw. Las respuestas
+ * (SYN-ACK = abierto, RST = cerrado) llegan por el mismo socket, filtradas
+ * en el kernel con BPF por nuestro puerto de origen.
+ *
+ * Cada SYN lleva una cookie en el número de secuencia: los 16 bits bajos son
+ * la ranura de la sonda y los 16 altos un hash con clave secreta de
+ * (dirección, puerto). La respuesta trae la cookie + 1 en el ACK, así que se
+ * localiza la sonda en O(1) sin tablas hash y se descartan respuestas
+ * tardías o falsificadas. Nunca se completa el handshake: el kernel local
+ * responde con RST al SYN-ACK porque no hay socket para esa conexión.
+ *
+ * Requiere CAP_NET_RAW; sin privilegios devuelve SCAN_ENGINE_UNSUPPORTED.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/random.h>
+#include <netinet/in.h>
+#include <netinet/ip.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <linux/filter.h>
+#include "scan_engine.h"
+#include "timer_wheel.h"
+
+// La ranura viaja en los 16 bits bajos de la cookie
+#define SYN_MAX_INFLIGHT 65536
+#define SYN_SEND_BATCH 64
+#define SYN_RECV_BUFFER (8 * 1024 * 1024)
+#define SYN_MSS 1460
+
+typedef struct {
+    struct tcphdr tcp;
+    uint8_t options[4];     // MSS, como un SYN normal
+} SynPacket;
+
+typedef struct {
+    ScanProbe probe;
+    uint32_t cookie;
+    uint64_t sent_us;
+    struct sockaddr_in addr;
+    SynPacket packet;
+} SynSlot;
+
+// Estado del bucle compartido con el callback de expiración
+typedef struct {
+    SynSlot *slots;
+    int *free_list;
+    int free_count;
+    int inflight;
+    ScanPlan *plan;
+    const ScanEngineOptions *options;
+    ScanResultCallback callback;
+    void *user_data;
+} SynScan;
+
+static uint32_t mix32(uint32_t h) {
+    // Finalizador de MurmurHash3
+    h ^= h >> 16;
+    h *= 0x85ebca6bU;
+    h ^= h >> 13;
+    h *= 0xc2b2ae35U;
+    h ^= h >> 16;
+    return h;
+}
+
+static uint32_t probe_cookie(uint32_t secret, uint32_t addr, int port, int slot) {
+    uint32_t h = mix32(secret ^ addr);
+    h = mix32(h ^ (uint32_t)port);
+    return (h & 0xffff0000U) | (uint32_t)slot;
+}
+
+static uint16_t tcp_checksum(uint32_t src, uint32_t dst, const void *segment, int length) {
+    const uint8_t *bytes = (const uint8_t*)segment;
+    uint32_t sum = 0;
+
+    // Pseudo-cabecera IPv4 (direcciones ya en orden de red)
+    sum += (ntohl(src) >> 16) + (ntohl(src) & 0xffff);
+    sum += (ntohl(dst) >> 16) + (ntohl(dst) & 0xffff);
+    sum += IPPROTO_TCP;
+    sum += (uint32_t)length;
+
+    for (int i = 0; i + 1 < length; i += 2) {
+        sum += (uint32_t)(bytes[i] << 8 | bytes[i + 1]);
+    }
+    if (length & 1) {
+        sum += (uint32_t)(bytes[length - 1] << 8);
+    }
+    while (sum >> 16) {
+        sum = (sum & 0xffff) + (sum >> 16);
+    }
+    return htons((uint16_t)~sum);
+}
+
+// Dirección de origen que el kernel usará hacia el destino (sin enviar nada)
+static int route_source(const struct sockaddr_in *target, uint32_t *source) {
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_in addr = *target;
+    struct sockaddr_in local;
+    socklen_t len = sizeof(local);
+    addr.sin_port = htons(9);
+    int status = -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+        getsockname(fd, (struct sockaddr*)&local, &len) == 0) {
+        *source = local.sin_addr.s_addr;
+        status = 0;
+    }
+    close(fd);
+    return status;
+}
+
+// Reserva un puerto de origen con un socket TCP sin conectar para que ninguna
+// otra aplicación lo use durante el escaneo
+static int reserve_source_port(int *port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_in addr;
+    socklen_t len = sizeof(addr);
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        getsockname(fd, (struct sockaddr*)&addr, &len) != 0) {
+        close(fd);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return fd;
+}
+
+// Filtro BPF: sólo segmentos TCP dirigidos a nuestro puerto de origen
+static int attach_port_filter(int fd, int port) {
+    struct sock_filter code[] = {
+        BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),             // X = longitud cabecera IP
+        BPF_STMT(BPF_LD | BPF_H | BPF_IND, 2),              // A = puerto destino TCP
+        BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, (uint32_t)port, 0, 1),
+        BPF_STMT(BPF_RET | BPF_K, 0xffff),
+        BPF_STMT(BPF_RET | BPF_K, 0),
+    };
+    struct sock_fprog program;
+    program.len = sizeof(code) / sizeof(code[0]);
+    program.filter = code;
+    return setsockopt(fd, SOL_SOCKET, SO_ATTACH_FILTER, &program, sizeof(program));
+}
+
+static void build_syn(SynSlot *slot, uint32_t source, int source_port) {
+    SynPacket *packet = &slot->packet;
+
+    memset(packet, 0, sizeof(*packet));
+    packet->tcp.source = htons((uint16_t)source_port);
+    packet->tcp.dest = htons((uint16_t)slot->probe.port);
+    packet->tcp.seq = htonl(slot->cookie);
+    packet->tcp.doff = sizeof(SynPacket) / 4;
+    packet->tcp.syn = 1;
+    packet->tcp.window = htons(1024);
+    packet->options[0] = TCPOPT_MAXSEG;
+    packet->options[1] = TCPOLEN_MAXSEG;
+    packet->options[2] = SYN_MSS >> 8;
+    packet->options[3] = SYN_MSS & 0xff;
+    packet->tcp.check = tcp_checksum(source, slot->addr.sin_addr.s_addr, packet, sizeof(*packet));
+}
+
+static void release_slot(SynScan *scan, int index) {
+    scan->free_list[scan->free_count++] = index;
+    scan->inflight--;
+}
+
+static void expire_probe(int index, void *user_data) {
+    SynScan *scan = (SynScan*)user_data;
+    SynSlot *slot = &scan->slots[index];
+
+    release_slot(scan, index);
+    scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt, PACER_TIMEOUT);
+    // Sin respuesta: resultado ambiguo, se reintenta antes de darlo por filtrado
+    if (!scan_engine_retry(scan->plan, &slot->probe, scan->options)) {
+        scan->callback(slot->probe.host, slot->probe.port, 0, scan->user_data);
+    }
+}
+
+// Envía el lote y arma los plazos; una sonda que no se pudo enviar es un error
+// local (sin ruta, cortafuegos de salida...) y no dice nada del puerto
+static void flush_batch(SynScan *scan, HostTable *hosts, TimerWheel *wheel, int fd,
+                        struct mmsghdr *messages, const int *batch, int count) {
+    int sent = 0;
+    while (sent < count) {
+        int ret = sendmmsg(fd, messages + sent, (unsigned)(count - sent), 0);
+        if (ret > 0) {
+            for (int i = sent; i < sent + ret; i++) {
+                SynSlot *slot = &scan->slots[batch[i]];
+                timer_wheel_insert(wheel, batch[i],
+                                   scan_engine_probe_timeout(hosts, &slot->probe, scan->options));
+            }
+            sent += ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && (errno == ENOBUFS || errno == EAGAIN)) {
+            scan_engine_send_backoff(fd, errno);
+            continue;
+        }
+        // El primer mensaje pendiente falló: resolverlo y seguir con el resto
+        SynSlot *slot = &scan->slots[batch[sent]];
+        release_slot(scan, batch[sent]);
+        scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt,
+                          scan_pacer_outcome(errno));
+        scan->callback(slot->probe.host, slot->probe.port, SCAN_RESULT_ERROR, scan->user_data);
+        sent++;
+    }
+}
+
+static void handle_reply(SynScan *scan, HostTable *hosts, TimerWheel *wheel, int window,
+                         uint32_t secret, const uint8_t *buffer, ssize_t length) {
+    if (length < (ssize_t)sizeof(struct iphdr)) return;
+
+    const struct iphdr *ip = (const struct iphdr*)buffer;
+    int ip_length = ip->ihl * 4;
+    if (ip->protocol != IPPROTO_TCP || length < ip_length + (ssize_t)sizeof(struct tcphdr)) return;
+
+    const struct tcphdr *tcp = (const struct tcphdr*)(buffer + ip_length);
+    int open;
+    if (tcp->syn && tcp->ack) {
+        open = 1;
+    } else if (tcp->rst) {
+        open = 0;
+    } else {
+        return;
+    }
+
+    uint32_t cookie = ntohl(tcp->ack_seq) - 1;
+    int index = (int)(cookie & 0xffff);
+    if (index >= window || !timer_wheel_armed(wheel, index)) return;
+
+    // Verificar que la respuesta corresponde a la sonda de esa ranura
+    SynSlot *slot = &scan->slots[index];
+    int port = ntohs(tcp->source);
+    if (slot->addr.sin_addr.s_addr != ip->saddr || slot->probe.port != port ||
+        probe_cookie(secret, ip->saddr, port, index) != cookie) {
+        return;
+    }
+
+    timer_wheel_remove(wheel, index);
+    scan_engine_sample_rtt(hosts, scan->options, slot->probe.host, rtt_now_us() - slot->sent_us);
+    release_slot(scan, index);
+    scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt, PACER_RESPONSE);
+    scan->callback(slot->probe.host, slot->probe.port, open, scan->user_data);
+}
+
+int scan_engine_syn(HostTable *hosts, ScanPlan *plan,
+                    const ScanEngineOptions *options, ScanResultCallback callback,
+                    void *user_data) {
+    if (!hosts || !plan || !options || !callback) return -1;
+
+    uint64_t remaining = plan->total - plan->cursor;
+    if (remaining == 0) return 0;
+
+    // Los SYN se construyen sobre IPv4: con objetivos IPv6 se usa otro motor
+    for (int h = 0; h < hosts->count; h++) {
+        if (hosts->hosts[h].addr.ss_family != AF_INET) return SCAN_ENGINE_UNSUPPORTED;
+    }
+
+    // Sin descriptores por sonda: la ventana sólo la limita la cookie
+    int window = options->max_inflight > 0 ? options->max_inflight : SCAN_ENGINE_DEFAULT_INFLIGHT;
+    if (window > SYN_MAX_INFLIGHT) window = SYN_MAX_INFLIGHT;
+    if ((uint64_t)window > remaining) window = (int)remaining;
+
+    int fd = socket(AF_INET, SOCK_RAW | SOCK_CLOEXEC, IPPROTO_TCP);
+    if (fd < 0) {
+        return (errno == EPERM || errno == EACCES) ? SCAN_ENGINE_UNSUPPORTED : -1;
+    }
+
+    int source_port;
+    int port_fd = reserve_source_port(&source_port);
+    if (port_fd < 0 || attach_port_filter(fd, source_port) != 0) {
+        if (port_fd >= 0) close(port_fd);
+        close(fd);
+        return -1;
+    }
+    int buffer_size = SYN_RECV_BUFFER;
+    if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &buffer_size, sizeof(buffer_size)) != 0) {
+        setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    }
+
+    uint32_t secret;
+    if (getrandom(&secret, sizeof(secret), 0) != sizeof(secret)) {
+        secret = (uint32_t)rtt_now_us() ^ ((uint32_t)getpid() << 16);
+    }
+
+    SynSlot *slots = malloc(window * sizeof(SynSlot));
+    TimerLink *links = malloc(window * sizeof(TimerLink));
+    int *free_list = malloc(window * sizeof(int));
+    uint32_t *sources = calloc(hosts->count, sizeof(uint32_t));
+    TimerWheel *wheel = malloc(sizeof(TimerWheel));
+    uint8_t *buffer = malloc(65536);
+    if (!slots || !links || !free_list || !sources || !wheel || !buffer) {
+        free(slots);
+        free(links);
+        free(free_list);
+        free(sources);
+        free(wheel);
+        free(buffer);
+        close(port_fd);
+        close(fd);
+        return -1;
+    }
+
+    SynScan scan;
+    scan.slots = slots;
+    scan.free_list = free_list;
+    scan.free_count = window;
+    scan.inflight = 0;
+    scan.plan = plan;
+    scan.options = options;
+    scan.callback = callback;
+    scan.user_data = user_data;
+    for (int i = 0; i < window; i++) {
+        free_list[i] = window - 1 - i;
+    }
+    timer_wheel_init(wheel, links, window);
+
+    struct mmsghdr messages[SYN_SEND_BATCH];
+    struct iovec iovs[SYN_SEND_BATCH];
+    int batch[SYN_SEND_BATCH];
+    ScanProbe probe;
+    int status = 0;
+
+    while (scan_plan_pending(plan) || scan.inflight > 0) {
+        // Interrupción (SIGINT): las sondas en vuelo quedan sin completar
+        if (scan_engine_stopped(options)) break;
+
+        // Preparar un lote de SYN mientras haya ranuras libres
+        int count = 0;
+        while (count < SYN_SEND_BATCH && scan.free_count > 0 &&
+               scan_engine_next(plan, options, &probe, callback, user_data)) {
+            ScanHost *host = &hosts->hosts[probe.host];
+            const struct sockaddr_in *addr = (const struct sockaddr_in*)&host->addr;
+            if (sources[probe.host] == 0 && route_source(addr, &sources[probe.host]) != 0) {
+                // Sin ruta al host: fallo local, el puerto queda sin estado
+                scan_pacer_settle(options->pacer, probe.host, probe.attempt, PACER_UNREACHABLE);
+                callback(probe.host, probe.port, SCAN_RESULT_ERROR, user_data);
+                continue;
+            }
+
+            int index = free_list[--scan.free_count];
+            SynSlot *slot = &slots[index];
+            slot->probe = probe;
+            slot->addr = *addr;
+            slot->cookie = probe_cookie(secret, addr->sin_addr.s_addr, probe.port, index);
+            build_syn(slot, sources[probe.host], source_port);
+            slot->sent_us = rtt_now_us();
+            scan.inflight++;
+
+            iovs[count].iov_base = &slot->packet;
+            iovs[count].iov_len = sizeof(slot->packet);
+            memset(&messages[count], 0, sizeof(messages[count]));
+            messages[count].msg_hdr.msg_name = &slot->addr;
+            messages[count].msg_hdr.msg_namelen = sizeof(slot->addr);
+            messages[count].msg_hdr.msg_iov = &iovs[count];
+            messages[count].msg_hdr.msg_iovlen = 1;
+            batch[count++] = index;
+        }
+        if (count > 0) {
+            flush_batch(&scan, hosts, wheel, fd, messages, batch, count);
+        }
+
+        // Lote incompleto con ranuras libres y trabajo pendiente: frena el pacer
+        int throttled = count < SYN_SEND_BATCH && scan.free_count > 0 && scan_plan_pending(plan);
+        if (scan.inflight == 0 && !throttled) continue;
+
+        // Sin esperar si aún quedan sondas por enviar y ranuras libres
+        int wait_ms = !throttled && scan.free_count > 0 && scan_plan_pending(plan) ? 0 : TIMER_WHEEL_TICK_MS;
+        struct pollfd pfd;
+        pfd.fd = fd;
+        pfd.events = POLLIN;
+        int ready = poll(&pfd, 1, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            status = -1;
+            break;
+        }
+
+        // Vaciar todas las respuestas disponibles
+        if (ready > 0) {
+            for (;;) {
+                ssize_t length = recv(fd, buffer, 65536, MSG_DONTWAIT);
+                if (length < 0) break;
+                handle_reply(&scan, hosts, wheel, window, secret, buffer, length);
+            }
+        }
+
+        // Avanzar la rueda y expirar los plazos vencidos
+        timer_wheel_advance(wheel, expire_probe, &scan);
+    }
+
+    // Sondas que quedaron en vuelo si el bucle terminó por interrupción o error
+    for (int i = 0; i < window; i++) {
+        if (timer_wheel_armed(wheel, i)) {
+            scan_pacer_settle(options->pacer, slots[i].probe.host, slots[i].probe.attempt, PACER_ABORTED);
+        }
+    }
+
+    free(slots);
+    free(links);
+    free(free_list);
+    free(sources);
+    free(wheel);
+    free(buffer);
+    close(port_fd);
+    close(fd);
+    return status;
+}
@@ -0,0 +1,541 @@
+/*
+ * Scan UDP - Motor de escaneo UDP con sendmmsg/recvmmsg
+ *
+ * Un socket UDP sin conectar por familia (el IPv6 sólo si hay objetivos
+ * IPv6) envía las sondas en lotes con sendmmsg.
+ * Cada puerto recibe una carga útil propia de su protocolo (consulta DNS,
+ * petición NTP, GetNext SNMP...) para que el servicio conteste; el resto
+ * recibe un datagrama vacío. Con IP_RECVERR e IPV6_RECVERR el kernel encola
+ * en la cola de errores del socket los ICMP e ICMPv6 que provocan las
+ * sondas, junto con la dirección de destino original, y ambas colas se
+ * vacían con recvmmsg:
+ *
+ *   respuesta UDP             -> abierto
+ *   ICMP puerto inalcanzable  -> cerrado
+ *   otro ICMP inalcanzable    -> filtrado (SCAN_RESULT_FILTERED)
+ *   sin respuesta             -> open|filtered (SCAN_RESULT_TIMEOUT)
+ *   envío rechazado localmente -> error local (SCAN_RESULT_ERROR)
+ *
+ * Los hosts limitan los ICMP que generan (en Linux icmp_msgs_per_sec global
+ * e icmp_ratelimit por destino), así que esperar un ICMP por cada puerto
+ * cerrado haría impracticable un barrido completo. Por eso el escaneo UDP
+ * va a la tasa ICMP del kernel por defecto, y una sonda sin respuesta de un
+ * host que acaba de enviar ICMP no se reintenta: el silencio se debe casi
+ * seguro al límite y reenviar sólo duplicaría la duración del barrido.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/ip_icmp.h>
+#include <netinet/icmp6.h>
+#include <arpa/inet.h>
+#include <linux/errqueue.h>
+#include "scan_engine.h"
+#include "timer_wheel.h"
+
+#define UDP_BATCH 64
+#define UDP_RECV_BUFFER (4 * 1024 * 1024)
+#define UDP_DATAGRAM_SIZE 2048
+#define UDP_ICMP_RECENT_US 1000000      // Un ICMP en el último segundo indica host limitado
+#define UDP_DEFAULT_ICMP_RATE 1000      // icmp_msgs_per_sec por defecto en Linux
+#define UDP_ICMP_RATE_PATH "/proc/sys/net/ipv4/icmp_msgs_per_sec"
+
+#define UDP_PAYLOAD(port, data) {port, data, sizeof(data) - 1}
+
+typedef struct {
+    int port;
+    const char *data;
+    size_t length;
+} UdpPayload;
+
+// Cargas útiles por protocolo (las secuencias \x se cortan antes de letras hexadecimales)
+static const UdpPayload udp_payloads[] = {
+    // DNS: consulta TXT CHAOS version.bind
+    UDP_PAYLOAD(53, "\x00\x06\x01\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                    "\x07version\x04" "bind\x00\x00\x10\x00\x03"),
+    // TFTP: lectura de un archivo inexistente
+    UDP_PAYLOAD(69, "\x00\x01" "r7tftp.txt\x00octet\x00"),
+    // Portmapper: llamada RPC NULL
+    UDP_PAYLOAD(111, "\x72\xfe\x1d\x13\x00\x00\x00\x00\x00\x00\x00\x02\x00\x01\x86\xa0"
+                     "\x00\x00\x00\x02\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                     "\x00\x00\x00\x00\x00\x00\x00\x00"),
+    // NTP: petición de cliente versión 4
+    UDP_PAYLOAD(123, "\xe3\x00\x04\xfa\x00\x01\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                     "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"
+                     "\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"),
+    // NetBIOS: consulta de estado del nodo "*"
+    UDP_PAYLOAD(137, "\x80\xf0\x00\x10\x00\x01\x00\x00\x00\x00\x00\x00\x20"
+                     "CKAAAAAAAAAAAAAAAAAAAAAAAAAAAAAA\x00\x00\x21\x00\x01"),
+    // SNMP v1: GetNext de 1.3.6.1.2.1 con comunidad public
+    UDP_PAYLOAD(161, "\x30\x26\x02\x01\x00\x04\x06public\xa1\x19\x02\x04\x71\x64\xfe\xf1"
+                     "\x02\x01\x00\x02\x01\x00\x30\x0b\x30\x09\x06\x05\x2b\x06\x01\x02"
+                     "\x01\x05\x00"),
+    // OpenVPN: reinicio de control del cliente
+    UDP_PAYLOAD(1194, "\x38\x01\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00\x00"),
+    // SSDP: descubrimiento UPnP
+    UDP_PAYLOAD(1900, "M-SEARCH * HTTP/1.1\r\nHOST: 239.255.255.250:1900\r\n"
+                      "MAN: \"ssdp:discover\"\r\nMX: 1\r\nST: ssdp:all\r\n\r\n"),
+    // mDNS: enumeración de servicios
+    UDP_PAYLOAD(5353, "\x00\x00\x00\x00\x00\x01\x00\x00\x00\x00\x00\x00"
+                      "\x09_services\x07_dns-sd\x04_udp\x05local\x00\x00\x0c\x00\x01"),
+    // Memcached: stats con cabecera de trama UDP
+    UDP_PAYLOAD(11211, "\x00\x01\x00\x00\x00\x01\x00\x00stats\r\n"),
+    {0, NULL, 0} // Terminador
+};
+
+typedef struct {
+    ScanProbe probe;
+    struct sockaddr_storage addr;   // Destino (puerto incluido)
+    socklen_t addr_len;
+    uint64_t sent_us;
+    int chain;                  // Siguiente ranura en el mismo bucket del índice
+} UdpSlot;
+
+typedef struct {
+    UdpSlot *slots;
+    int *free_list;
+    int free_count;
+    int inflight;
+    int *buckets;               // Índice (dirección, puerto) -> ranura en vuelo
+    unsigned bucket_mask;
+    uint64_t *last_unreach_us;  // Último ICMP de puerto inalcanzable por host
+    HostTable *hosts;
+    TimerWheel *wheel;
+    ScanPlan *plan;
+    const ScanEngineOptions *options;
+    ScanResultCallback callback;
+    void *user_data;
+} UdpScan;
+
+const char* scan_engine_udp_payload(int port, size_t *length) {
+    for (int i = 0; udp_payloads[i].data != NULL; i++) {
+        if (udp_payloads[i].port == port) {
+            *length = udp_payloads[i].length;
+            return udp_payloads[i].data;
+        }
+    }
+    *length = 0;
+    return "";
+}
+
+int scan_engine_udp_icmp_rate(void) {
+    int rate = UDP_DEFAULT_ICMP_RATE;
+    FILE *file = fopen(UDP_ICMP_RATE_PATH, "r");
+    if (file) {
+        if (fscanf(file, "%d", &rate) != 1 || rate <= 0) rate = UDP_DEFAULT_ICMP_RATE;
+        fclose(file);
+    }
+    return rate;
+}
+
+static unsigned bucket_of(const UdpScan *scan, const struct sockaddr_storage *endpoint) {
+    uint32_t key;
+    if (endpoint->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *addr = (const struct sockaddr_in6*)endpoint;
+        uint32_t words[4];
+        memcpy(words, &addr->sin6_addr, sizeof(words));
+        key = words[0] ^ words[1] ^ words[2] ^ words[3] ^ ((uint32_t)addr->sin6_port * 0x9e3779b1u);
+    } else {
+        const struct sockaddr_in *addr = (const struct sockaddr_in*)endpoint;
+        key = addr->sin_addr.s_addr ^ ((uint32_t)addr->sin_port * 0x9e3779b1u);
+    }
+    key ^= key >> 16;
+    key *= 0x85ebca6bu;
+    key ^= key >> 13;
+    return key & scan->bucket_mask;
+}
+
+static int same_endpoint(const struct sockaddr_storage *a, const struct sockaddr_storage *b) {
+    if (a->ss_family != b->ss_family) return 0;
+    if (a->ss_family == AF_INET6) {
+        const struct sockaddr_in6 *a6 = (const struct sockaddr_in6*)a;
+        const struct sockaddr_in6 *b6 = (const struct sockaddr_in6*)b;
+        return a6->sin6_port == b6->sin6_port &&
+               memcmp(&a6->sin6_addr, &b6->sin6_addr, sizeof(a6->sin6_addr)) == 0;
+    }
+    const struct sockaddr_in *a4 = (const struct sockaddr_in*)a;
+    const struct sockaddr_in *b4 = (const struct sockaddr_in*)b;
+    return a4->sin_port == b4->sin_port && a4->sin_addr.s_addr == b4->sin_addr.s_addr;
+}
+
+static void index_insert(UdpScan *scan, int index) {
+    UdpSlot *slot = &scan->slots[index];
+    unsigned bucket = bucket_of(scan, &slot->addr);
+    slot->chain = scan->buckets[bucket];
+    scan->buckets[bucket] = index;
+}
+
+// Quita la ranura del destino del índice y la devuelve (-1 si no está en vuelo)
+static int index_take(UdpScan *scan, const struct sockaddr_storage *endpoint) {
+    int *link = &scan->buckets[bucket_of(scan, endpoint)];
+    while (*link >= 0) {
+        UdpSlot *slot = &scan->slots[*link];
+        if (same_endpoint(&slot->addr, endpoint)) {
+            int index = *link;
+            *link = slot->chain;
+            return index;
+        }
+        link = &slot->chain;
+    }
+    return -1;
+}
+
+static void release_slot(UdpScan *scan, int index) {
+    if (timer_wheel_armed(scan->wheel, index)) {
+        timer_wheel_remove(scan->wheel, index);
+    }
+    scan->free_list[scan->free_count++] = index;
+    scan->inflight--;
+}
+
+static void resolve_probe(UdpScan *scan, int index, ScanResult result, PacerOutcome outcome) {
+    UdpSlot *slot = &scan->slots[index];
+    if (outcome == PACER_RESPONSE) {
+        scan_engine_sample_rtt(scan->hosts, scan->options, slot->probe.host, rtt_now_us() - slot->sent_us);
+    }
+    release_slot(scan, index);
+    scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt, outcome);
+    scan->callback(slot->probe.host, slot->probe.port, result, scan->user_data);
+}
+
+static void expire_probe(int index, void *user_data) {
+    UdpScan *scan = (UdpScan*)user_data;
+    UdpSlot *slot = &scan->slots[index];
+
+    index_take(scan, &slot->addr);
+    release_slot(scan, index);
+    scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt, PACER_TIMEOUT);
+
+    // Con el host limitando sus ICMP el reintento no aclararía nada
+    int limited = rtt_now_us() - scan->last_unreach_us[slot->probe.host] < UDP_ICMP_RECENT_US;
+    if (limited || !scan_engine_retry(scan->plan, &slot->probe, scan->options)) {
+        scan->callback(slot->probe.host, slot->probe.port, SCAN_RESULT_TIMEOUT, scan->user_data);
+    }
+}
+
+// Envía el lote y arma los plazos; un envío rechazado resuelve la sonda
+static void flush_batch(UdpScan *scan, int fd, struct mmsghdr *messages, const int *batch, int count) {
+    int sent = 0;
+    while (sent < count) {
+        int ret = sendmmsg(fd, messages + sent, (unsigned)(count - sent), 0);
+        if (ret > 0) {
+            for (int i = sent; i < sent + ret; i++) {
+                UdpSlot *slot = &scan->slots[batch[i]];
+                index_insert(scan, batch[i]);
+                timer_wheel_insert(scan->wheel, batch[i],
+                                   scan_engine_probe_timeout(scan->hosts, &slot->probe, scan->options));
+            }
+            sent += ret;
+            continue;
+        }
+        if (ret < 0 && errno == EINTR) continue;
+        if (ret < 0 && (errno == ENOBUFS || errno == EAGAIN)) {
+            scan_engine_send_backoff(fd, errno);
+            continue;
+        }
+        // El primer mensaje pendiente falló (sin ruta, cortafuegos local...): error
+        // local que no dice nada del puerto
+        int index = batch[sent];
+        UdpSlot *slot = &scan->slots[index];
+        PacerOutcome outcome = scan_pacer_outcome(errno);
+        scan->free_list[scan->free_count++] = index;
+        scan->inflight--;
+        scan_pacer_settle(scan->options->pacer, slot->probe.host, slot->probe.attempt, outcome);
+        scan->callback(slot->probe.host, slot->probe.port, SCAN_RESULT_ERROR, scan->user_data);
+        sent++;
+    }
+}
+
+// Vacía las respuestas UDP: cada datagrama de un destino en vuelo lo marca abierto
+static void drain_replies(UdpScan *scan, int fd, struct mmsghdr *messages, struct sockaddr_storage *sources,
+                          struct iovec *iovs, uint8_t *buffers) {
+    for (;;) {
+        for (int i = 0; i < UDP_BATCH; i++) {
+            iovs[i].iov_base = buffers + (size_t)i * UDP_DATAGRAM_SIZE;
+            iovs[i].iov_len = UDP_DATAGRAM_SIZE;
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_name = &sources[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(sources[i]);
+            messages[i].msg_hdr.msg_iov = &iovs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int received = recvmmsg(fd, messages, UDP_BATCH, MSG_DONTWAIT, NULL);
+        if (received < 0) {
+            // Un error ICMP pendiente se informa una vez en recv: seguir leyendo
+            if (errno == EINTR || errno == ECONNREFUSED || errno == EHOSTUNREACH ||
+                errno == ENETUNREACH || errno == EHOSTDOWN) {
+                continue;
+            }
+            return;
+        }
+        for (int i = 0; i < received; i++) {
+            int index = index_take(scan, &sources[i]);
+            if (index >= 0) {
+                resolve_probe(scan, index, SCAN_RESULT_OPEN, PACER_RESPONSE);
+            }
+        }
+        if (received < UDP_BATCH) return;
+    }
+}
+
+// Vacía la cola de errores: ICMP de destino inalcanzable con el destino original
+static void drain_errors(UdpScan *scan, int fd, struct mmsghdr *messages, struct sockaddr_storage *targets,
+                         struct iovec *iovs, uint8_t *buffers, uint8_t *controls, size_t control_size) {
+    for (;;) {
+        for (int i = 0; i < UDP_BATCH; i++) {
+            iovs[i].iov_base = buffers + (size_t)i * UDP_DATAGRAM_SIZE;
+            iovs[i].iov_len = UDP_DATAGRAM_SIZE;
+            memset(&messages[i], 0, sizeof(messages[i]));
+            messages[i].msg_hdr.msg_name = &targets[i];
+            messages[i].msg_hdr.msg_namelen = sizeof(targets[i]);
+            messages[i].msg_hdr.msg_iov = &iovs[i];
+            messages[i].msg_hdr.msg_iovlen = 1;
+            messages[i].msg_hdr.msg_control = controls + (size_t)i * control_size;
+            messages[i].msg_hdr.msg_controllen = control_size;
+        }
+
+        int received = recvmmsg(fd, messages, UDP_BATCH, MSG_ERRQUEUE | MSG_DONTWAIT, NULL);
+        if (received < 0) {
+            if (errno == EINTR) continue;
+            return;
+        }
+        for (int i = 0; i < received; i++) {
+            struct msghdr *header = &messages[i].msg_hdr;
+            const struct sock_extended_err *error = NULL;
+            for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(header); cmsg; cmsg = CMSG_NXTHDR(header, cmsg)) {
+                if ((cmsg->cmsg_level == IPPROTO_IP && cmsg->cmsg_type == IP_RECVERR) ||
+                    (cmsg->cmsg_level == IPPROTO_IPV6 && cmsg->cmsg_type == IPV6_RECVERR)) {
+                    error = (const struct sock_extended_err*)CMSG_DATA(cmsg);
+                }
+            }
+            if (!error) continue;
+
+            // Los códigos de ICMPv6 difieren de los de ICMPv4
+            int port_unreach, host_unreach;
+            if (error->ee_origin == SO_EE_ORIGIN_ICMP && error->ee_type == ICMP_DEST_UNREACH) {
+                port_unreach = error->ee_code == ICMP_PORT_UNREACH;
+                host_unreach = error->ee_code == ICMP_NET_UNREACH || error->ee_code == ICMP_HOST_UNREACH;
+            } else if (error->ee_origin == SO_EE_ORIGIN_ICMP6 && error->ee_type == ICMP6_DST_UNREACH) {
+                port_unreach = error->ee_code == ICMP6_DST_UNREACH_NOPORT;
+                host_unreach = error->ee_code == ICMP6_DST_UNREACH_NOROUTE ||
+                               error->ee_code == ICMP6_DST_UNREACH_ADDR;
+            } else {
+                continue;
+            }
+
+            int index = index_take(scan, &targets[i]);
+            if (index < 0) continue;
+
+            int host = scan->slots[index].probe.host;
+            if (port_unreach) {
+                scan->last_unreach_us[host] = rtt_now_us();
+                resolve_probe(scan, index, SCAN_RESULT_CLOSED, PACER_RESPONSE);
+            } else if (host_unreach) {
+                resolve_probe(scan, index, SCAN_RESULT_FILTERED, PACER_UNREACHABLE);
+            } else {
+                // Prohibido por administración u otro: filtrado, pero el camino responde
+                resolve_probe(scan, index, SCAN_RESULT_FILTERED, PACER_RESPONSE);
+            }
+        }
+        if (received < UDP_BATCH) return;
+    }
+}
+
+// Socket sin conectar de la familia con la cola de errores ICMP activada
+static int open_socket(int family) {
+    int fd = socket(family, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    int enable = 1;
+    int buffer_size = UDP_RECV_BUFFER;
+    int ret = family == AF_INET6
+        ? setsockopt(fd, IPPROTO_IPV6, IPV6_RECVERR, &enable, sizeof(enable))
+        : setsockopt(fd, IPPROTO_IP, IP_RECVERR, &enable, sizeof(enable));
+    if (ret < 0) {
+        close(fd);
+        return -1;
+    }
+    setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    return fd;
+}
+
+int scan_engine_udp(HostTable *hosts, ScanPlan *plan,
+                    const ScanEngineOptions *options, ScanResultCallback callback,
+                    void *user_data) {
+    if (!hosts || !plan || !options || !callback) return -1;
+
+    uint64_t remaining = plan->total - plan->cursor;
+    if (remaining == 0) return 0;
+
+    // Todas las sondas comparten uno o dos sockets: la ventana no gasta descriptores
+    int window = options->max_inflight > 0 ? options->max_inflight : SCAN_ENGINE_DEFAULT_INFLIGHT;
+    if ((uint64_t)window > remaining) window = (int)remaining;
+
+    // Un socket por familia: [0] IPv4, [1] IPv6, sólo las que aparecen en la tabla
+    int fds[2] = {-1, -1};
+    for (int h = 0; h < hosts->count; h++) {
+        int family = hosts->hosts[h].addr.ss_family == AF_INET6;
+        if (fds[family] < 0) {
+            fds[family] = open_socket(family ? AF_INET6 : AF_INET);
+            if (fds[family] < 0) {
+                if (fds[!family] >= 0) close(fds[!family]);
+                return -1;
+            }
+        }
+        if (fds[0] >= 0 && fds[1] >= 0) break;
+    }
+
+    unsigned bucket_count = 16;
+    while (bucket_count < (unsigned)window * 2) bucket_count <<= 1;
+
+    size_t control_size = CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6));
+    UdpSlot *slots = malloc(window * sizeof(UdpSlot));
+    TimerLink *links = malloc(window * sizeof(TimerLink));
+    int *free_list = malloc(window * sizeof(int));
+    int *buckets = malloc(bucket_count * sizeof(int));
+    uint64_t *last_unreach = calloc(hosts->count, sizeof(uint64_t));
+    TimerWheel *wheel = malloc(sizeof(TimerWheel));
+    uint8_t *buffers = malloc((size_t)UDP_BATCH * UDP_DATAGRAM_SIZE);
+    uint8_t *controls = malloc((size_t)UDP_BATCH * control_size);
+    if (!slots || !links || !free_list || !buckets || !last_unreach || !wheel || !buffers || !controls) {
+        free(slots);
+        free(links);
+        free(free_list);
+        free(buckets);
+        free(last_unreach);
+        free(wheel);
+        free(buffers);
+        free(controls);
+        for (int f = 0; f < 2; f++) {
+            if (fds[f] >= 0) close(fds[f]);
+        }
+        return -1;
+    }
+
+    UdpScan scan;
+    scan.slots = slots;
+    scan.free_list = free_list;
+    scan.free_count = window;
+    scan.inflight = 0;
+    scan.buckets = buckets;
+    scan.bucket_mask = bucket_count - 1;
+    scan.last_unreach_us = last_unreach;
+    scan.hosts = hosts;
+    scan.wheel = wheel;
+    scan.plan = plan;
+    scan.options = options;
+    scan.callback = callback;
+    scan.user_data = user_data;
+    for (int i = 0; i < window; i++) {
+        free_list[i] = window - 1 - i;
+    }
+    for (unsigned i = 0; i < bucket_count; i++) {
+        buckets[i] = -1;
+    }
+    timer_wheel_init(wheel, links, window);
+
+    // Cada lote se reparte por familia porque sendmmsg va a un único socket
+    struct mmsghdr messages[2][UDP_BATCH];
+    struct iovec iovs[2][UDP_BATCH];
+    struct sockaddr_storage addresses[UDP_BATCH];
+    int batch[2][UDP_BATCH];
+    ScanProbe probe;
+    int status = 0;
+
+    while (scan_plan_pending(plan) || scan.inflight > 0) {
+        // Interrupción (SIGINT): las sondas en vuelo quedan sin completar
+        if (scan_engine_stopped(options)) break;
+
+        // Preparar un lote de datagramas mientras haya ranuras libres
+        int count = 0;
+        int counts[2] = {0, 0};
+        while (count < UDP_BATCH && scan.free_count > 0 &&
+               scan_engine_next(plan, options, &probe, callback, user_data)) {
+            int index = free_list[--scan.free_count];
+            UdpSlot *slot = &slots[index];
+            slot->probe = probe;
+            slot->addr_len = host_table_endpoint(&hosts->hosts[probe.host], probe.port, &slot->addr);
+            slot->sent_us = rtt_now_us();
+            scan.inflight++;
+
+            int family = slot->addr.ss_family == AF_INET6;
+            int position = counts[family]++;
+            size_t length;
+            const char *payload = scan_engine_udp_payload(probe.port, &length);
+            iovs[family][position].iov_base = (void*)payload;
+            iovs[family][position].iov_len = length;
+            memset(&messages[family][position], 0, sizeof(messages[family][position]));
+            messages[family][position].msg_hdr.msg_name = &slot->addr;
+            messages[family][position].msg_hdr.msg_namelen = slot->addr_len;
+            messages[family][position].msg_hdr.msg_iov = &iovs[family][position];
+            messages[family][position].msg_hdr.msg_iovlen = 1;
+            batch[family][position] = index;
+            count++;
+        }
+        for (int f = 0; f < 2; f++) {
+            if (counts[f] > 0) {
+                flush_batch(&scan, fds[f], messages[f], batch[f], counts[f]);
+            }
+        }
+
+        // Lote incompleto con ranuras libres y trabajo pendiente: frena el pacer
+        int throttled = count < UDP_BATCH && scan.free_count > 0 && scan_plan_pending(plan);
+        if (scan.inflight == 0 && !throttled) continue;
+
+        int wait_ms = !throttled && scan.free_count > 0 && scan_plan_pending(plan) ? 0 : TIMER_WHEEL_TICK_MS;
+        struct pollfd pfds[2];
+        int polled = 0;
+        for (int f = 0; f < 2; f++) {
+            if (fds[f] < 0) continue;
+            pfds[polled].fd = fds[f];
+            pfds[polled].events = POLLIN;
+            pfds[polled].revents = 0;
+            polled++;
+        }
+        int ready = poll(pfds, polled, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            status = -1;
+            break;
+        }
+
+        for (int p = 0; ready > 0 && p < polled; p++) {
+            // POLLERR indica ICMP en la cola de errores
+            if (pfds[p].revents & POLLERR) {
+                drain_errors(&scan, pfds[p].fd, messages[0], addresses, iovs[0], buffers, controls, control_size);
+            }
+            if (pfds[p].revents & POLLIN) {
+                drain_replies(&scan, pfds[p].fd, messages[0], addresses, iovs[0], buffers);
+            }
+        }
+
+        timer_wheel_advance(wheel, expire_probe, &scan);
+    }
+
+    // Sondas que quedaron en vuelo si el bucle terminó por error
+    for (int i = 0; i < window; i++) {
+        if (timer_wheel_armed(wheel, i)) {
+            scan_pacer_settle(options->pacer, slots[i].probe.host, slots[i].probe.attempt, PACER_ABORTED);
+        }
+    }
+
+    free(slots);
+    free(links);
+    free(free_list);
+    free(buckets);
+    free(last_unreach);
+    free(wheel);
+    free(buffers);
+    free(controls);
+    for (int f = 0; f < 2; f++) {
+        if (fds[f] >= 0) close(fds[f]);
+    }
+    return status;
+}
@@ -0,0 +1,377 @@
+/*
+ * Scan Uring - Motor de escaneo TCP sobre io_uring (syscalls directas)
+ *
+ * Cada sonda se envía como una cadena de SQEs enlazadas sobre un descriptor
+ * directo (tabla de archivos registrada):
+ *
+ *   SOCKET -> CONNECT -> LINK_TIMEOUT -> CLOSE
+ *
+ * CONNECT y LINK_TIMEOUT usan IOSQE_IO_HARDLINK para que CLOSE se ejecute
+ * siempre, haya conectado, sido rechazado o expirado el plazo. Una sola
+ * llamada a io_uring_enter envía y recoge lotes completos de sondas.
+ *
+ * El plazo de LINK_TIMEOUT se calcula por sonda a partir del RTT del host;
+ * el RTT se mide al recoger la completion de CONNECT.
+ *
+ * Los descriptores directos no admiten getsockname(): un puerto abierto del
+ * rango efímero se confirma con una sonda bloqueante, que descarta las
+ * autoconexiones (ver scan_engine.c).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <stdint.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+#include "scan_engine.h"
+#include "timer_wheel.h"
+
+// Máximo de sondas simultáneas (cada una ocupa 4 SQEs)
+#define URING_MAX_INFLIGHT 4096
+#define URING_SQES_PER_PROBE 4
+
+enum {
+    URING_OP_SOCKET,
+    URING_OP_CONNECT,
+    URING_OP_TIMEOUT,
+    URING_OP_CLOSE
+};
+
+typedef struct {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_sqe *sqes;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_len;
+    size_t cq_len;
+    size_t sqes_len;
+    unsigned sq_entries;
+    unsigned to_submit;
+} UringRing;
+
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t addr_len;
+    struct __kernel_timespec timeout;
+    ScanProbe probe;
+    uint64_t sent_us;
+    ScanResult result;
+    int completions;    // CQEs recibidas de la cadena (4 al terminar)
+    PacerOutcome outcome;   // Desenlace del CONNECT para el pacer
+    int socket_error;   // errno de la operación SOCKET (0 = socket creado)
+} UringProbe;
+
+static int uring_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int uring_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int uring_register(int fd, unsigned opcode, void *arg, unsigned nr_args) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, nr_args);
+}
+
+static void ring_release(UringRing *ring) {
+    if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_len);
+    if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr) {
+        munmap(ring->cq_ptr, ring->cq_len);
+    }
+    if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED) munmap(ring->sq_ptr, ring->sq_len);
+    if (ring->fd >= 0) close(ring->fd);
+}
+
+static int ring_init(UringRing *ring, unsigned entries) {
+    struct io_uring_params params;
+
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    ring->fd = uring_setup(entries, &params);
+    if (ring->fd < 0) return -1;
+
+    ring->sq_len = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_len = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_len > ring->sq_len) ring->sq_len = ring->cq_len;
+        ring->cq_len = ring->sq_len;
+    }
+
+    ring->sq_ptr = mmap(NULL, ring->sq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) goto fail;
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) goto fail;
+    }
+
+    ring->sqes_len = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_len, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) goto fail;
+
+    char *sq = ring->sq_ptr;
+    char *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    ring->sq_entries = params.sq_entries;
+    return 0;
+
+fail:
+    ring_release(ring);
+    return -1;
+}
+
+// Verifica que el kernel soporte todas las operaciones de la cadena
+static int ring_supports_ops(UringRing *ring) {
+    size_t size = sizeof(struct io_uring_probe) + 256 * sizeof(struct io_uring_probe_op);
+    struct io_uring_probe *probe = calloc(1, size);
+    if (!probe) return 0;
+
+    int supported = 0;
+    if (uring_register(ring->fd, IORING_REGISTER_PROBE, probe, 256) == 0) {
+        const int ops[] = {IORING_OP_SOCKET, IORING_OP_CONNECT, IORING_OP_LINK_TIMEOUT, IORING_OP_CLOSE};
+        supported = 1;
+        for (size_t i = 0; i < sizeof(ops) / sizeof(ops[0]); i++) {
+            if (ops[i] > probe->last_op || !(probe->ops[ops[i]].flags & IO_URING_OP_SUPPORTED)) {
+                supported = 0;
+            }
+        }
+    }
+    free(probe);
+    return supported;
+}
+
+static int ring_register_sparse_files(UringRing *ring, unsigned count) {
+    struct io_uring_rsrc_register reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.nr = count;
+    reg.flags = IORING_RSRC_REGISTER_SPARSE;
+    return uring_register(ring->fd, IORING_REGISTER_FILES2, &reg, sizeof(reg));
+}
+
+static unsigned ring_sq_space(UringRing *ring) {
+    unsigned head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+    return ring->sq_entries - (*ring->sq_tail + ring->to_submit - head);
+}
+
+static struct io_uring_sqe* ring_get_sqe(UringRing *ring) {
+    unsigned tail = *ring->sq_tail + ring->to_submit;
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->to_submit++;
+    return sqe;
+}
+
+static void ring_publish(UringRing *ring) {
+    __atomic_store_n(ring->sq_tail, *ring->sq_tail + ring->to_submit, __ATOMIC_RELEASE);
+}
+
+static void queue_probe(UringRing *ring, UringProbe *probes, int slot) {
+    UringProbe *probe = &probes[slot];
+    unsigned long long tag = (unsigned long long)slot << 2;
+    struct io_uring_sqe *sqe;
+
+    sqe = ring_get_sqe(ring);
+    sqe->opcode = IORING_OP_SOCKET;
+    sqe->fd = probe->addr.ss_family;
+    sqe->off = SOCK_STREAM;
+    sqe->file_index = (unsigned)slot + 1;
+    sqe->flags = IOSQE_IO_LINK;
+    sqe->user_data = tag | URING_OP_SOCKET;
+
+    sqe = ring_get_sqe(ring);
+    sqe->opcode = IORING_OP_CONNECT;
+    sqe->fd = slot;
+    sqe->addr = (unsigned long long)(unsigned long)&probe->addr;
+    sqe->off = probe->addr_len;
+    sqe->flags = IOSQE_FIXED_FILE | IOSQE_IO_HARDLINK;
+    sqe->user_data = tag | URING_OP_CONNECT;
+
+    sqe = ring_get_sqe(ring);
+    sqe->opcode = IORING_OP_LINK_TIMEOUT;
+    sqe->addr = (unsigned long long)(unsigned long)&probe->timeout;
+    sqe->len = 1;
+    sqe->flags = IOSQE_IO_HARDLINK;
+    sqe->user_data = tag | URING_OP_TIMEOUT;
+
+    sqe = ring_get_sqe(ring);
+    sqe->opcode = IORING_OP_CLOSE;
+    sqe->file_index = (unsigned)slot + 1;
+    sqe->user_data = tag | URING_OP_CLOSE;
+}
+
+int scan_engine_uring(HostTable *hosts, ScanPlan *plan,
+                      const ScanEngineOptions *options, ScanResultCallback callback,
+                      void *user_data) {
+    if (!hosts || !plan || !options || !callback) return -1;
+
+    uint64_t remaining = plan->total - plan->cursor;
+    if (remaining == 0) return 0;
+
+    int window = scan_engine_clamp_inflight(options->fds, options->max_inflight);
+    if (window > URING_MAX_INFLIGHT) window = URING_MAX_INFLIGHT;
+    if ((uint64_t)window > remaining) window = (int)remaining;
+
+    UringRing ring;
+    if (ring_init(&ring, (unsigned)window * URING_SQES_PER_PROBE) != 0) {
+        return SCAN_ENGINE_UNSUPPORTED;
+    }
+    if (!ring_supports_ops(&ring) || ring_register_sparse_files(&ring, (unsigned)window) != 0) {
+        ring_release(&ring);
+        return SCAN_ENGINE_UNSUPPORTED;
+    }
+
+    UringProbe *probes = calloc(window, sizeof(UringProbe));
+    int *free_list = malloc(window * sizeof(int));
+    if (!probes || !free_list) {
+        free(probes);
+        free(free_list);
+        ring_release(&ring);
+        return -1;
+    }
+
+    int free_count = window;
+    for (int i = 0; i < window; i++) {
+        free_list[i] = window - 1 - i;
+    }
+
+    ScanProbe next;
+    int inflight = 0;
+    int status = 0;
+
+    while (scan_plan_pending(plan) || inflight > 0) {
+        // Interrupción (SIGINT): las sondas en vuelo quedan sin completar
+        if (scan_engine_stopped(options)) break;
+
+        // Encolar cadenas completas mientras haya ranuras y espacio en la SQ
+        while (free_count > 0 && ring_sq_space(&ring) >= URING_SQES_PER_PROBE &&
+               fd_budget_available(options->fds) &&
+               scan_engine_next(plan, options, &next, callback, user_data)) {
+            int slot = free_list[--free_count];
+            UringProbe *probe = &probes[slot];
+            int timeout_ms = scan_engine_probe_timeout(hosts, &next, options);
+
+            probe->addr_len = host_table_endpoint(&hosts->hosts[next.host], next.port, &probe->addr);
+            probe->timeout.tv_sec = timeout_ms / 1000;
+            probe->timeout.tv_nsec = (long long)(timeout_ms % 1000) * 1000000LL;
+            probe->probe = next;
+            probe->result = SCAN_RESULT_CLOSED;
+            probe->completions = 0;
+            probe->outcome = PACER_ABORTED;
+            probe->socket_error = 0;
+            probe->sent_us = rtt_now_us();
+
+            queue_probe(&ring, probes, slot);
+            fd_budget_acquire(options->fds);
+            inflight++;
+        }
+
+        ring_publish(&ring);
+        ring.to_submit = 0;
+        unsigned submit = *ring.sq_tail - __atomic_load_n(ring.sq_head, __ATOMIC_ACQUIRE);
+
+        // Si el pacer frena, no bloquear esperando una completion que puede
+        // tardar todo el plazo: enviar, dormir un tick y recoger lo que haya
+        int throttled = free_count > 0 && ring_sq_space(&ring) >= URING_SQES_PER_PROBE &&
+                        scan_plan_pending(plan);
+        int ret = uring_enter(ring.fd, submit, throttled ? 0 : 1,
+                              throttled ? 0 : IORING_ENTER_GETEVENTS);
+        if (ret < 0 && errno != EINTR && errno != EAGAIN && errno != EBUSY) {
+            status = -1;
+            break;
+        }
+        if (throttled) {
+            poll(NULL, 0, TIMER_WHEEL_TICK_MS);
+        }
+
+        // Recoger todas las completions disponibles
+        unsigned head = *ring.cq_head;
+        unsigned tail = __atomic_load_n(ring.cq_tail, __ATOMIC_ACQUIRE);
+        while (head != tail) {
+            struct io_uring_cqe *cqe = &ring.cqes[head & *ring.cq_mask];
+            int slot = (int)(cqe->user_data >> 2);
+            int op = (int)(cqe->user_data & 3);
+            UringProbe *probe = &probes[slot];
+
+            if (op == URING_OP_SOCKET && cqe->res < 0) {
+                probe->socket_error = -cqe->res;
+            }
+            if (op == URING_OP_CONNECT) {
+                probe->outcome = scan_pacer_outcome(-cqe->res);
+            }
+            if (op == URING_OP_CONNECT && (cqe->res == 0 || cqe->res == -ECONNREFUSED)) {
+                // SYN-ACK o RST: el host respondió y la espera es una medida de RTT
+                scan_engine_sample_rtt(hosts, options, probe->probe.host, rtt_now_us() - probe->sent_us);
+                if (cqe->res == 0) probe->result = SCAN_RESULT_OPEN;
+            } else if (op == URING_OP_TIMEOUT && cqe->res == -ETIME) {
+                // LINK_TIMEOUT venció sin respuesta: resultado ambiguo
+                probe->result = SCAN_RESULT_TIMEOUT;
+            }
+            if (++probe->completions == URING_SQES_PER_PROBE) {
+                free_list[free_count++] = slot;
+                inflight--;
+                fd_budget_release(options->fds);
+                if (probe->socket_error) {
+                    // Sin socket la cadena entera se canceló: no hay resultado del puerto
+                    scan_engine_socket_failed(plan, options, &probe->probe, probe->socket_error,
+                                              callback, user_data);
+                } else {
+                    // Abierto en el rango efímero: confirmar que no fue una autoconexión
+                    if (probe->result == SCAN_RESULT_OPEN && scan_engine_in_local_range(probe->probe.port)) {
+                        int timeout_ms = scan_engine_probe_timeout(hosts, &probe->probe, options);
+                        ScanResult confirmed = scan_engine_probe_blocking(&probe->addr, probe->addr_len,
+                                                                          timeout_ms, NULL);
+                        if (confirmed != SCAN_RESULT_ERROR) probe->result = confirmed;
+                    }
+                    scan_pacer_settle(options->pacer, probe->probe.host, probe->probe.attempt,
+                                      probe->result == SCAN_RESULT_TIMEOUT ? PACER_TIMEOUT : probe->outcome);
+                    if (probe->result != SCAN_RESULT_TIMEOUT ||
+                        !scan_engine_retry(plan, &probe->probe, options)) {
+                        callback(probe->probe.host, probe->probe.port,
+                                 probe->result == SCAN_RESULT_OPEN, user_data);
+                    }
+                }
+            }
+            head++;
+        }
+        __atomic_store_n(ring.cq_head, head, __ATOMIC_RELEASE);
+    }
+
+    // Cadenas abortadas: cerrar el anillo las cancela y libera sus descriptores
+    for (int i = 0; i < inflight; i++) {
+        fd_budget_release(options->fds);
+    }
+
+    free(probes);
+    free(free_list);
+    ring_release(&ring);
+    return status;
+}
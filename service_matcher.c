@@ -0,0 +1,224 @@
+/*
+ * Service Matcher - Implementación del autómata de firmas
+ *
+ * Todas las firmas se buscan en una sola pasada sobre los bytes recibidos
+ * con un autómata Aho-Corasick. Al construirlo, los enlaces de fallo se
+ * resuelven dentro de la tabla de transiciones (DFA completo), así que cada
+ * byte cuesta una lectura de la tabla sin retrocesos. Para que la tabla sea
+ * pequeña, los bytes se agrupan en clases: sólo los que aparecen en alguna
+ * firma tienen clase propia (mayúsculas y minúsculas comparten la suya) y
+ * el resto cae en la clase 0, que siempre vuelve a la raíz.
+ *
+ * El orden de la base de firmas es su prioridad: las más específicas van
+ * primero y, si varias aparecen en el mismo banner, gana la de menor índice.
+ * El estado del autómata se conserva entre lecturas, de modo que una firma
+ * partida entre dos segmentos TCP también se reconoce.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "service_matcher.h"
+
+#define SIGNATURE(pattern, service) {pattern, sizeof(pattern) - 1, service}
+
+// Base de firmas, de la más específica a la más genérica
+static const ServiceSignature default_signatures[] = {
+    // Accesos remotos y puertas traseras
+    SIGNATURE("command not found", "Shell remota"),
+    SIGNATURE("is not recognized as an internal or external command", "Shell remota (cmd.exe)"),
+    SIGNATURE("Microsoft Windows [Version", "Shell remota (cmd.exe)"),
+    SIGNATURE("uid=0(root)", "Shell remota (root)"),
+    SIGNATURE("NOTICE AUTH", "IRC"),
+    SIGNATURE("*** Looking up your hostname", "IRC"),
+    SIGNATURE("\xff\xfb\x01", "Telnet"),
+    SIGNATURE("\xff\xfd\x18", "Telnet"),
+
+    // SSH
+    SIGNATURE("SSH-2.0-OpenSSH", "SSH (OpenSSH)"),
+    SIGNATURE("SSH-2.0-dropbear", "SSH (Dropbear)"),
+    SIGNATURE("SSH-2.0-libssh", "SSH (libssh)"),
+    SIGNATURE("SSH-1.", "SSH"),
+    SIGNATURE("SSH-2.0-", "SSH"),
+
+    // Bases de datos y colas
+    SIGNATURE("MariaDB", "MySQL (MariaDB)"),
+    SIGNATURE("mysql_native_password", "MySQL"),
+    SIGNATURE("caching_sha2_password", "MySQL"),
+    SIGNATURE("invalid length of startup packet", "PostgreSQL"),
+    SIGNATURE("unsupported frontend protocol", "PostgreSQL"),
+    SIGNATURE("-NOAUTH", "Redis"),
+    SIGNATURE("-DENIED Redis", "Redis"),
+    SIGNATURE("+PONG", "Redis"),
+    SIGNATURE("redis_version", "Redis"),
+    SIGNATURE("trying to access MongoDB over HTTP", "MongoDB"),
+    SIGNATURE("You Know, for Search", "Elasticsearch"),
+    SIGNATURE("\"cluster_name\"", "Elasticsearch"),
+    SIGNATURE("\"couchdb\"", "CouchDB"),
+    SIGNATURE("AMQP\x00", "AMQP (RabbitMQ)"),
+
+    // Correo y transferencia de archivos
+    SIGNATURE("ESMTP Postfix", "SMTP (Postfix)"),
+    SIGNATURE("ESMTP Exim", "SMTP (Exim)"),
+    SIGNATURE("ESMTP Sendmail", "SMTP (Sendmail)"),
+    SIGNATURE("Microsoft ESMTP", "SMTP (Exchange)"),
+    SIGNATURE("ESMTP", "SMTP"),
+    SIGNATURE("+OK Dovecot", "POP3 (Dovecot)"),
+    SIGNATURE("Dovecot ready", "IMAP (Dovecot)"),
+    SIGNATURE("IMAP4rev1", "IMAP"),
+    SIGNATURE("+OK POP3", "POP3"),
+    SIGNATURE("vsFTPd", "FTP (vsftpd)"),
+    SIGNATURE("ProFTPD", "FTP (ProFTPD)"),
+    SIGNATURE("Pure-FTPd", "FTP (Pure-FTPd)"),
+    SIGNATURE("FileZilla Server", "FTP (FileZilla)"),
+    SIGNATURE("220 FTP", "FTP"),
+    SIGNATURE("FTP server", "FTP"),
+
+    // Escritorio remoto
+    SIGNATURE("RFB 00", "VNC"),
+
+    // TLS: alerta ante la sonda en texto plano
+    SIGNATURE("The plain HTTP request was sent to HTTPS port", "HTTPS"),
+    SIGNATURE("\x15\x03\x01\x00\x02\x02", "TLS/SSL"),
+    SIGNATURE("\x15\x03\x03\x00\x02\x02", "TLS/SSL"),
+
+    // HTTP: primero el servidor concreto, al final cualquier respuesta HTTP
+    SIGNATURE("Server: Docker", "Docker API"),
+    SIGNATURE("Jupyter", "Jupyter Notebook"),
+    SIGNATURE("Server: nginx", "HTTP (nginx)"),
+    SIGNATURE("Server: Apache", "HTTP (Apache)"),
+    SIGNATURE("Server: Microsoft-IIS", "HTTP (IIS)"),
+    SIGNATURE("Server: lighttpd", "HTTP (lighttpd)"),
+    SIGNATURE("Server: Caddy", "HTTP (Caddy)"),
+    SIGNATURE("Server: Jetty", "HTTP (Jetty)"),
+    SIGNATURE("Server: gunicorn", "HTTP (gunicorn)"),
+    SIGNATURE("Server: Werkzeug", "HTTP (Werkzeug)"),
+    SIGNATURE("Server: SimpleHTTP", "HTTP (Python http.server)"),
+    SIGNATURE("Server: BaseHTTP", "HTTP (Python http.server)"),
+    SIGNATURE("HTTP/1.", "HTTP"),
+
+    // Genéricas
+    SIGNATURE("-ERR wrong number of arguments", "Redis"),
+    SIGNATURE("-ERR unknown command", "Redis"),
+};
+
+ServiceMatcher* service_matcher_create(void) {
+    return service_matcher_build(default_signatures,
+                                 (int)(sizeof(default_signatures) / sizeof(default_signatures[0])));
+}
+
+void service_matcher_destroy(ServiceMatcher *matcher) {
+    if (!matcher) return;
+    free(matcher->delta);
+    free(matcher->match);
+    free(matcher);
+}
+
+ServiceMatcher* service_matcher_build(const ServiceSignature *signatures, int count) {
+    ServiceMatcher *matcher = calloc(1, sizeof(ServiceMatcher));
+    if (!matcher) return NULL;
+
+    // Alfabeto reducido: una clase por letra sin distinguir mayúsculas
+    int classes = 1;
+    size_t max_states = 1;
+    for (int i = 0; i < count; i++) {
+        for (size_t j = 0; j < signatures[i].length; j++) {
+            unsigned char byte = (unsigned char)tolower((unsigned char)signatures[i].pattern[j]);
+            if (matcher->classes[byte] == 0) {
+                matcher->classes[byte] = (uint8_t)classes;
+                matcher->classes[toupper(byte)] = (uint8_t)classes;
+                classes++;
+            }
+        }
+        max_states += signatures[i].length;
+    }
+
+    matcher->class_count = classes;
+    matcher->signatures = signatures;
+    matcher->signature_count = count;
+    matcher->delta = calloc(max_states * classes, sizeof(int32_t));
+    matcher->match = malloc(max_states * sizeof(int32_t));
+    int32_t *fail = calloc(max_states, sizeof(int32_t));
+    int32_t *queue = malloc(max_states * sizeof(int32_t));
+    if (!matcher->delta || !matcher->match || !fail || !queue) {
+        free(fail);
+        free(queue);
+        service_matcher_destroy(matcher);
+        return NULL;
+    }
+
+    // Trie de firmas; en el trie ninguna arista vuelve a la raíz, así que 0 = sin arista
+    matcher->state_count = 1;
+    matcher->match[0] = -1;
+    for (int i = 0; i < count; i++) {
+        int state = 0;
+        for (size_t j = 0; j < signatures[i].length; j++) {
+            int32_t *edge = &matcher->delta[state * classes +
+                                            matcher->classes[(unsigned char)signatures[i].pattern[j]]];
+            if (*edge == 0) {
+                *edge = matcher->state_count;
+                matcher->match[matcher->state_count++] = -1;
+            }
+            state = *edge;
+        }
+        if (matcher->match[state] < 0) matcher->match[state] = i;
+    }
+
+    // Enlaces de fallo en anchura, incorporados directamente a delta
+    int head = 0;
+    int tail = 0;
+    for (int c = 1; c < classes; c++) {
+        int32_t next = matcher->delta[c];
+        if (next != 0) {
+            fail[next] = 0;
+            queue[tail++] = next;
+        }
+    }
+    while (head < tail) {
+        int32_t state = queue[head++];
+        int32_t *row = &matcher->delta[state * classes];
+        const int32_t *fail_row = &matcher->delta[fail[state] * classes];
+
+        // La firma del sufijo más largo también se reconoce en este estado
+        int32_t inherited = matcher->match[fail[state]];
+        if (inherited >= 0 && (matcher->match[state] < 0 || inherited < matcher->match[state])) {
+            matcher->match[state] = inherited;
+        }
+
+        for (int c = 1; c < classes; c++) {
+            if (row[c] != 0) {
+                fail[row[c]] = fail_row[c];
+                queue[tail++] = row[c];
+            } else {
+                row[c] = fail_row[c];
+            }
+        }
+    }
+
+    free(fail);
+    free(queue);
+    return matcher;
+}
+
+int service_matcher_feed(const ServiceMatcher *matcher, int *state, const uint8_t *data, size_t length) {
+    const int32_t *delta = matcher->delta;
+    const int32_t *match = matcher->match;
+    int classes = matcher->class_count;
+    int32_t current = *state;
+    int best = -1;
+
+    for (size_t i = 0; i < length; i++) {
+        current = delta[current * classes + matcher->classes[data[i]]];
+        int32_t found = match[current];
+        if (found >= 0 && (best < 0 || found < best)) {
+            best = found;
+        }
+    }
+    *state = current;
+    return best;
+}
+
+const char* service_matcher_name(const ServiceMatcher *matcher, int signature) {
+    if (!matcher || signature < 0 || signature >= matcher->signature_count) return NULL;
+    return matcher->signatures[signature].service;
+}
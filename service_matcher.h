@@ -0,0 +1,37 @@
+/*
+ * Service Matcher - Identificación de servicios por firmas en el banner
+ */
+
+#ifndef SERVICE_MATCHER_H
+#define SERVICE_MATCHER_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct {
+    const char *pattern;    // Bytes a buscar (sin distinguir mayúsculas)
+    size_t length;
+    const char *service;    // Nombre que se guarda en Alert.service
+} ServiceSignature;
+
+// Autómata Aho-Corasick compilado a DFA sobre un alfabeto reducido
+typedef struct {
+    uint8_t classes[256];   // Byte -> clase (0 = no aparece en ninguna firma)
+    int class_count;        // Ancho de cada fila de delta
+    int32_t *delta;         // delta[estado * class_count + clase] = siguiente estado
+    int32_t *match;         // Firma de mayor prioridad reconocida en el estado (-1 = ninguna)
+    int state_count;
+    const ServiceSignature *signatures;
+    int signature_count;
+} ServiceMatcher;
+
+// Funciones públicas
+ServiceMatcher* service_matcher_create(void);
+void service_matcher_destroy(ServiceMatcher *matcher);
+int service_matcher_feed(const ServiceMatcher *matcher, int *state, const uint8_t *data, size_t length);
+const char* service_matcher_name(const ServiceMatcher *matcher, int signature);
+
+// Funciones auxiliares
+ServiceMatcher* service_matcher_build(const ServiceSignature *signatures, int count);
+
+#endif
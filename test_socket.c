@@ -1,18 +1,81 @@
 /*
- * Test Socket - Programa auxiliar para pruebas de detección en tiempo real
- * Crea un socket TCP temporal para verificar la detección de MatcomGuard
+ * Test Socket - Programa auxiliar para pruebas de detección y de rendimiento
+ *
+ * Sin --spec crea un socket TCP temporal para verificar la detección en
+ * tiempo real de MatcomGuard. Con --spec simula un host completo desde un
+ * único bucle epoll, según un archivo de especificación:
+ *
+ *   # PUERTOS     ACCIÓN   [delay=MS] [banner=TEXTO]
+ *   20000-20999   open
+ *   21000-21039   drop
+ *   21500         open     banner=SSH-2.0-OpenSSH_9.6\r\n
+ *   21501         open     delay=50 banner=HTTP/1.1 200 OK\r\n\r\n
+ *
+ *   open    listener que acepta cada conexión; con delay la respuesta (banner
+ *           y cierre) se retrasa MS milisegundos y con banner se envía TEXTO
+ *   drop    filtrado: la cola de aceptación del listener se llena con una
+ *           conexión propia y el kernel descarta los SYN siguientes, de modo
+ *           que la sonda expira como ante un firewall (sin privilegios)
+ *   closed  sin listener: el kernel responde con RST. Es lo que ocurre en
+ *           cualquier puerto no listado; declararlo verifica que ningún otro
+ *           proceso lo tenga ocupado
+ *
+ * Las líneas posteriores sobrescriben a las anteriores puerto a puerto.
+ * --expect imprime los puertos que un escáner debería ver abiertos (uno por
+ * línea) y termina; make bench-scan lo usa para medir la precisión.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <stdint.h>
 #include <unistd.h>
+#include <getopt.h>
+#include <time.h>
 #include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <signal.h>
 #include <errno.h>
 
+#define SIM_MAX_RULES 1024
+#define SIM_BANNER_SIZE 512
+#define SIM_MAX_EVENTS 256
+
+typedef enum {
+    SIM_CLOSED,
+    SIM_OPEN,
+    SIM_DROP
+} SimAction;
+
+typedef struct {
+    SimAction action;
+    int delay_ms;                   // Latencia antes de responder (0 = inmediata)
+    char banner[SIM_BANNER_SIZE];   // Texto enviado al aceptar (vacío = ninguno)
+    size_t banner_len;
+} SimRule;
+
+// Conexión aceptada a la espera de su latencia
+typedef struct {
+    int fd;
+    int rule;
+    uint64_t due_us;
+} SimPending;
+
+typedef struct {
+    SimRule rules[SIM_MAX_RULES];
+    int rule_count;
+    int16_t rule_of[65536];         // Regla de cada puerto (-1 = no listado)
+    int listeners[65536];           // Descriptor del listener (-1 = ninguno)
+    SimPending *pending;
+    int pending_count;
+    int pending_capacity;
+    unsigned long long accepted;
+    unsigned long long dropped;     // Conexiones que no cupieron en la cola de espera
+} Simulator;
+
 volatile int keep_running = 1;
 
 void signal_handler(int signum) {
@@ -20,79 +83,455 @@ void signal_handler(int signum) {
     printf("\n[INFO] Recibida señal %d, cerrando socket...\n", signum);
 }
 
+static uint64_t now_us(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000ULL + (uint64_t)ts.tv_nsec / 1000;
+}
+
+// Copia 'text' interpretando \r, \n, \t y \\; devuelve la longitud resultante
+static size_t unescape(const char *text, char *out, size_t size) {
+    size_t length = 0;
+    while (*text && length < size - 1) {
+        char c = *text++;
+        if (c == '\\' && *text) {
+            char next = *text++;
+            c = next == 'r' ? '\r' : next == 'n' ? '\n' : next == 't' ? '\t' : next;
+        }
+        out[length++] = c;
+    }
+    out[length] = '\0';
+    return length;
+}
+
+static int parse_ports(const char *text, int *start, int *end) {
+    char *rest;
+    long a = strtol(text, &rest, 10);
+    long b = a;
+    if (*rest == '-') {
+        b = strtol(rest + 1, &rest, 10);
+    }
+    if (rest == text || *rest != '\0' || a < 1 || b > 65535 || a > b) return -1;
+    *start = (int)a;
+    *end = (int)b;
+    return 0;
+}
+
+static int load_spec(Simulator *sim, const char *path) {
+    FILE *file = fopen(path, "r");
+    if (!file) {
+        fprintf(stderr, "Error: No se pudo abrir la especificación '%s': %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    char line[1024];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), file)) {
+        line_number++;
+        line[strcspn(line, "\r\n")] = '\0';
+        char *cursor = line + strspn(line, " \t");
+        if (*cursor == '\0' || *cursor == '#') continue;
+
+        // El banner se toma hasta el final de la línea (admite espacios)
+        char *banner = strstr(cursor, "banner=");
+        if (banner) {
+            *banner = '\0';
+            banner += strlen("banner=");
+        }
+
+        char *ports = strtok(cursor, " \t");
+        char *action = strtok(NULL, " \t");
+        int start, end;
+        if (!ports || !action || parse_ports(ports, &start, &end) != 0 || sim->rule_count >= SIM_MAX_RULES) {
+            fprintf(stderr, "Error: Línea %d inválida en '%s'\n", line_number, path);
+            fclose(file);
+            return -1;
+        }
+
+        SimRule *rule = &sim->rules[sim->rule_count];
+        memset(rule, 0, sizeof(SimRule));
+        if (strcmp(action, "open") == 0) {
+            rule->action = SIM_OPEN;
+        } else if (strcmp(action, "drop") == 0) {
+            rule->action = SIM_DROP;
+        } else if (strcmp(action, "closed") == 0) {
+            rule->action = SIM_CLOSED;
+        } else {
+            fprintf(stderr, "Error: Acción '%s' desconocida en la línea %d (open, drop o closed)\n",
+                    action, line_number);
+            fclose(file);
+            return -1;
+        }
+
+        char *option;
+        while ((option = strtok(NULL, " \t")) != NULL) {
+            if (strncmp(option, "delay=", 6) == 0) {
+                rule->delay_ms = atoi(option + 6);
+            } else {
+                fprintf(stderr, "Error: Opción '%s' desconocida en la línea %d\n", option, line_number);
+                fclose(file);
+                return -1;
+            }
+        }
+        if (banner) {
+            rule->banner_len = unescape(banner, rule->banner, sizeof(rule->banner));
+        }
+
+        for (int port = start; port <= end; port++) {
+            sim->rule_of[port] = (int16_t)sim->rule_count;
+        }
+        sim->rule_count++;
+    }
+    fclose(file);
+    return 0;
+}
+
+// Con miles de listeners el límite blando de descriptores se queda corto
+static void raise_fd_limit(void) {
+    struct rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max) {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+    }
+}
+
+static int open_listener(const struct in_addr *address, int port, int backlog, int nonblocking) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC | (nonblocking ? SOCK_NONBLOCK : 0), 0);
+    if (fd < 0) return -1;
+
+    int opt = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr = *address;
+    addr.sin_port = htons(port);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        (backlog >= 0 && listen(fd, backlog) < 0)) {
+        int error = errno;
+        close(fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+
+// Llena la cola de aceptación (backlog 0) con una conexión propia
+static int fill_accept_queue(const struct in_addr *address, int port) {
+    int fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (fd < 0) return -1;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr = *address;
+    addr.sin_port = htons(port);
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void respond(Simulator *sim, int fd, int rule_index) {
+    const SimRule *rule = &sim->rules[rule_index];
+    if (rule->banner_len > 0) {
+        ssize_t written = write(fd, rule->banner, rule->banner_len);
+        (void)written;
+    }
+    close(fd);
+}
+
+static void add_pending(Simulator *sim, int fd, int rule_index) {
+    if (sim->pending_count == sim->pending_capacity) {
+        int capacity = sim->pending_capacity ? sim->pending_capacity * 2 : 256;
+        SimPending *grown = realloc(sim->pending, capacity * sizeof(SimPending));
+        if (!grown) {
+            close(fd);
+            sim->dropped++;
+            return;
+        }
+        sim->pending = grown;
+        sim->pending_capacity = capacity;
+    }
+    SimPending *entry = &sim->pending[sim->pending_count++];
+    entry->fd = fd;
+    entry->rule = rule_index;
+    entry->due_us = now_us() + (uint64_t)sim->rules[rule_index].delay_ms * 1000;
+}
+
+// Responde a las conexiones vencidas; devuelve los ms hasta la siguiente (-1 = ninguna)
+static int flush_pending(Simulator *sim) {
+    uint64_t now = now_us();
+    uint64_t next = UINT64_MAX;
+    for (int i = 0; i < sim->pending_count; ) {
+        SimPending *entry = &sim->pending[i];
+        if (entry->due_us <= now) {
+            respond(sim, entry->fd, entry->rule);
+            *entry = sim->pending[--sim->pending_count];
+            continue;
+        }
+        if (entry->due_us < next) next = entry->due_us;
+        i++;
+    }
+    return next == UINT64_MAX ? -1 : (int)((next - now + 999) / 1000);
+}
+
+static void print_expected(const Simulator *sim) {
+    for (int port = 1; port <= 65535; port++) {
+        if (sim->rule_of[port] >= 0 && sim->rules[sim->rule_of[port]].action == SIM_OPEN) {
+            printf("%d\n", port);
+        }
+    }
+}
+
+static int run_simulator(const char *spec_path, const struct in_addr *address, int duration, int expect) {
+    Simulator *sim = calloc(1, sizeof(Simulator));
+    if (!sim) return 1;
+    for (int port = 0; port < 65536; port++) {
+        sim->rule_of[port] = -1;
+        sim->listeners[port] = -1;
+    }
+    if (load_spec(sim, spec_path) != 0) {
+        free(sim);
+        return 1;
+    }
+    if (expect) {
+        print_expected(sim);
+        free(sim);
+        return 0;
+    }
+
+    raise_fd_limit();
+    int epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (epfd < 0) {
+        perror("Error creando epoll");
+        free(sim);
+        return 1;
+    }
+
+    // Abrir los listeners; los filtrados llevan además la conexión que llena su cola
+    int counts[3] = {0, 0, 0};
+    int *fillers = malloc(65536 * sizeof(int));
+    int filler_count = 0;
+    int status = fillers ? 0 : 1;
+    for (int port = 1; port <= 65535 && status == 0; port++) {
+        if (sim->rule_of[port] < 0) continue;
+        const SimRule *rule = &sim->rules[sim->rule_of[port]];
+        int fd = -1;
+
+        if (rule->action == SIM_OPEN) {
+            fd = open_listener(address, port, SOMAXCONN, 1);
+            if (fd >= 0) {
+                struct epoll_event ev;
+                ev.events = EPOLLIN;
+                ev.data.u32 = (uint32_t)port;
+                if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                    close(fd);
+                    fd = -1;
+                }
+            }
+        } else if (rule->action == SIM_DROP) {
+            fd = open_listener(address, port, 0, 1);
+            int filler = fd >= 0 ? fill_accept_queue(address, port) : -1;
+            if (filler < 0 && fd >= 0) {
+                close(fd);
+                fd = -1;
+            }
+            if (filler >= 0) fillers[filler_count++] = filler;
+        } else {
+            // Cerrado: sólo comprobar que nadie más ocupa el puerto
+            fd = open_listener(address, port, -1, 0);
+            if (fd >= 0) {
+                close(fd);
+                counts[SIM_CLOSED]++;
+                continue;
+            }
+        }
+
+        if (fd < 0) {
+            fprintf(stderr, "Error preparando el puerto %d (%s): %s\n", port,
+                    rule->action == SIM_CLOSED ? "closed" : rule->action == SIM_OPEN ? "open" : "drop",
+                    strerror(errno));
+            status = 1;
+            break;
+        }
+        sim->listeners[port] = fd;
+        counts[rule->action]++;
+    }
+
+    if (status == 0) {
+        printf("[INFO] Simulando %s: %d abiertos, %d filtrados, %d cerrados por %d segundos\n",
+               inet_ntoa(*address), counts[SIM_OPEN], counts[SIM_DROP], counts[SIM_CLOSED], duration);
+        printf("[INFO] PID: %d\n", getpid());
+        fflush(stdout);
+    }
+
+    // Bucle único: aceptar en los listeners abiertos y responder cuando toque
+    uint64_t deadline = now_us() + (uint64_t)duration * 1000000ULL;
+    struct epoll_event events[SIM_MAX_EVENTS];
+    while (status == 0 && keep_running && now_us() < deadline) {
+        int wait_ms = flush_pending(sim);
+        if (wait_ms < 0 || wait_ms > 1000) wait_ms = 1000;
+
+        int ready = epoll_wait(epfd, events, SIM_MAX_EVENTS, wait_ms);
+        if (ready < 0 && errno != EINTR) {
+            perror("Error en epoll_wait");
+            status = 1;
+            break;
+        }
+        for (int i = 0; i < ready; i++) {
+            int port = (int)events[i].data.u32;
+            int rule_index = sim->rule_of[port];
+            int client;
+            while ((client = accept4(sim->listeners[port], NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                sim->accepted++;
+                if (sim->rules[rule_index].delay_ms > 0) {
+                    add_pending(sim, client, rule_index);
+                } else {
+                    respond(sim, client, rule_index);
+                }
+            }
+        }
+    }
+
+    for (int i = 0; i < sim->pending_count; i++) {
+        close(sim->pending[i].fd);
+    }
+    for (int i = 0; i < filler_count; i++) {
+        close(fillers[i]);
+    }
+    for (int port = 1; port <= 65535; port++) {
+        if (sim->listeners[port] >= 0) close(sim->listeners[port]);
+    }
+    if (status == 0) {
+        printf("[INFO] Simulación terminada: %llu conexiones aceptadas", sim->accepted);
+        if (sim->dropped > 0) {
+            printf(", %llu descartadas sin memoria", sim->dropped);
+        }
+        printf("\n");
+    }
+
+    close(epfd);
+    free(fillers);
+    free(sim->pending);
+    free(sim);
+    return status;
+}
+
+static void print_usage(const char *program_name) {
+    printf("Uso: %s [PUERTO] [SEGUNDOS]\n", program_name);
+    printf("     %s --spec ARCHIVO [--bind DIRECCIÓN] [--duration SEGUNDOS] [--expect]\n\n", program_name);
+    printf("  --spec ARCHIVO      Simular los puertos descritos en ARCHIVO (open, drop, closed)\n");
+    printf("  --bind DIRECCIÓN    Dirección IPv4 donde escuchar (por defecto: 127.0.0.1)\n");
+    printf("  --duration SEG      Segundos antes de cerrar (por defecto: 30)\n");
+    printf("  --expect            Imprimir los puertos que deberían verse abiertos y salir\n");
+}
+
 int main(int argc, char *argv[]) {
     int port = 9999;
     int duration = 30;
-    
-    // Parsear argumentos
-    if (argc >= 2) {
-        port = atoi(argv[1]);
+    const char *spec_path = NULL;
+    int expect = 0;
+    struct in_addr address;
+    address.s_addr = inet_addr("127.0.0.1");
+
+    static struct option long_options[] = {
+        {"spec", required_argument, 0, 'f'},
+        {"bind", required_argument, 0, 'b'},
+        {"duration", required_argument, 0, 'd'},
+        {"expect", no_argument, 0, 'x'},
+        {"help", no_argument, 0, 'h'},
+        {0, 0, 0, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "f:b:d:xh", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'f':
+                spec_path = optarg;
+                break;
+            case 'b':
+                if (inet_pton(AF_INET, optarg, &address) != 1) {
+                    fprintf(stderr, "Error: Dirección inválida %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'd':
+                duration = atoi(optarg);
+                if (duration <= 0) {
+                    fprintf(stderr, "Error: Duración inválida %d\n", duration);
+                    return 1;
+                }
+                break;
+            case 'x':
+                expect = 1;
+                break;
+            case 'h':
+                print_usage(argv[0]);
+                return 0;
+            default:
+                print_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    // Parsear argumentos posicionales (modo de un solo puerto)
+    if (optind < argc) {
+        port = atoi(argv[optind]);
         if (port <= 0 || port > 65535) {
             fprintf(stderr, "Error: Puerto inválido %d\n", port);
             return 1;
         }
     }
-    
-    if (argc >= 3) {
-        duration = atoi(argv[2]);
+
+    if (optind + 1 < argc) {
+        duration = atoi(argv[optind + 1]);
         if (duration <= 0) {
             fprintf(stderr, "Error: Duración inválida %d\n", duration);
             return 1;
         }
     }
-    
+
     // Configurar manejador de señales
     signal(SIGINT, signal_handler);
     signal(SIGTERM, signal_handler);
-    
-    // Crear socket
-    int sock_fd = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock_fd < 0) {
-        perror("Error creando socket");
-        return 1;
-    }
-    
-    // Configurar reutilización de dirección
-    int opt = 1;
-    if (setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt)) < 0) {
-        perror("Error configurando SO_REUSEADDR");
-        close(sock_fd);
-        return 1;
+
+    if (spec_path || expect) {
+        if (!spec_path) {
+            fprintf(stderr, "Error: --expect requiere --spec\n");
+            return 1;
+        }
+        return run_simulator(spec_path, &address, duration, expect);
     }
-    
-    // Configurar dirección
-    struct sockaddr_in addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sin_family = AF_INET;
-    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
-    addr.sin_port = htons(port);
-    
-    // Hacer bind
-    if (bind(sock_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+
+    // Crear socket, con reutilización de dirección
+    int sock_fd = open_listener(&address, port, -1, 0);
+    if (sock_fd < 0) {
         fprintf(stderr, "Error haciendo bind al puerto %d: %s\n", port, strerror(errno));
-        close(sock_fd);
         return 1;
     }
-    
+
     // Hacer listen
     if (listen(sock_fd, 5) < 0) {
         perror("Error haciendo listen");
         close(sock_fd);
         return 1;
     }
-    
+
     printf("[INFO] Socket abierto en puerto %d por %d segundos\n", port, duration);
     printf("[INFO] PID: %d\n", getpid());
     fflush(stdout);
-    
+
     // Esperar por tiempo especificado o hasta recibir señal
     for (int i = 0; i < duration && keep_running; i++) {
         sleep(1);
     }
-    
+
     // Cerrar socket
     close(sock_fd);
     printf("[INFO] Socket cerrado\n");
-    
+
     return 0;
 }
@@ -0,0 +1,86 @@
+/*
+ * Timer Wheel - Implementación de la rueda de temporizadores
+ *
+ * Cada bucket es una lista doblemente enlazada de índices de ranura, así que
+ * armar, cancelar y expirar un plazo cuesta O(1). Los plazos más largos que
+ * una vuelta completa (TIMER_WHEEL_SLOTS * TIMER_WHEEL_TICK_MS) siguen siendo
+ * correctos: se comparan con el tick absoluto y esperan a la vuelta siguiente.
+ */
+
+#include <time.h>
+#include "timer_wheel.h"
+
+static unsigned long long now_tick(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    unsigned long long ms = (unsigned long long)ts.tv_sec * 1000ULL +
+                            (unsigned long long)ts.tv_nsec / 1000000ULL;
+    return ms / TIMER_WHEEL_TICK_MS;
+}
+
+void timer_wheel_init(TimerWheel *wheel, TimerLink *links, int count) {
+    for (int i = 0; i < TIMER_WHEEL_SLOTS; i++) {
+        wheel->head[i] = -1;
+    }
+    for (int i = 0; i < count; i++) {
+        links[i].bucket = -1;
+    }
+    wheel->links = links;
+    wheel->current_tick = now_tick();
+}
+
+void timer_wheel_insert(TimerWheel *wheel, int index, int timeout_ms) {
+    TimerLink *links = wheel->links;
+    unsigned long long ticks =
+        (unsigned long long)(timeout_ms + TIMER_WHEEL_TICK_MS - 1) / TIMER_WHEEL_TICK_MS;
+    if (ticks == 0) ticks = 1;
+
+    links[index].deadline_tick = wheel->current_tick + ticks;
+    int bucket = (int)(links[index].deadline_tick % TIMER_WHEEL_SLOTS);
+    links[index].bucket = bucket;
+    links[index].prev = -1;
+    links[index].next = wheel->head[bucket];
+    if (wheel->head[bucket] >= 0) {
+        links[wheel->head[bucket]].prev = index;
+    }
+    wheel->head[bucket] = index;
+}
+
+void timer_wheel_remove(TimerWheel *wheel, int index) {
+    TimerLink *links = wheel->links;
+    TimerLink *link = &links[index];
+    if (link->prev >= 0) {
+        links[link->prev].next = link->next;
+    } else {
+        wheel->head[link->bucket] = link->next;
+    }
+    if (link->next >= 0) {
+        links[link->next].prev = link->prev;
+    }
+    link->bucket = -1;
+}
+
+void timer_wheel_advance(TimerWheel *wheel, TimerExpireCallback callback, void *user_data) {
+    TimerLink *links = wheel->links;
+    unsigned long long tick = now_tick();
+    unsigned long long steps = tick - wheel->current_tick;
+    if (steps > TIMER_WHEEL_SLOTS) steps = TIMER_WHEEL_SLOTS;
+
+    for (unsigned long long s = 1; s <= steps; s++) {
+        int bucket = (int)((wheel->current_tick + s) % TIMER_WHEEL_SLOTS);
+        int index = wheel->head[bucket];
+        while (index >= 0) {
+            int next = links[index].next;
+            if (links[index].deadline_tick <= tick) {
+                timer_wheel_remove(wheel, index);
+                callback(index, user_data);
+            }
+            index = next;
+        }
+    }
+    wheel->current_tick = tick;
+}
+
+int timer_wheel_armed(const TimerWheel *wheel, int index) {
+    return wheel->links[index].bucket >= 0;
+}
@@ -0,0 +1,34 @@
+/*
+ * Timer Wheel - Rueda de temporizadores para los plazos de las sondas
+ */
+
+#ifndef TIMER_WHEEL_H
+#define TIMER_WHEEL_H
+
+#define TIMER_WHEEL_TICK_MS 10
+#define TIMER_WHEEL_SLOTS 1024
+
+typedef struct {
+    unsigned long long deadline_tick;
+    int prev;       // Enlaces dentro del bucket de la rueda
+    int next;
+    int bucket;     // -1 si el temporizador no está armado
+} TimerLink;
+
+typedef struct {
+    int head[TIMER_WHEEL_SLOTS];
+    unsigned long long current_tick;
+    TimerLink *links;       // Un enlace por ranura de sonda, propiedad del motor
+} TimerWheel;
+
+// Callback invocado por cada temporizador vencido (ya desarmado)
+typedef void (*TimerExpireCallback)(int index, void *user_data);
+
+// Funciones públicas
+void timer_wheel_init(TimerWheel *wheel, TimerLink *links, int count);
+void timer_wheel_insert(TimerWheel *wheel, int index, int timeout_ms);
+void timer_wheel_remove(TimerWheel *wheel, int index);
+void timer_wheel_advance(TimerWheel *wheel, TimerExpireCallback callback, void *user_data);
+int timer_wheel_armed(const TimerWheel *wheel, int index);
+
+#endif